@@ -119,111 +119,126 @@ boolean PubSubClient::connect(const char *id, const char *user, const char *pass
 
 boolean PubSubClient::connect(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
     if (!connected()) {
-        int result = 0;
-
-        if (_client == nullptr) {
+        if (!connectSend(id, user, pass, willTopic, willQos, willRetain, willMessage, cleanSession)) {
             return false;
         }
-        if (_client->connected()) {
-            result = 1;
+        int result;
+        while (0 == (result = connectPoll())) {
+            delay(0);  // Prevent watchdog crashes
+        }
+        return (result > 0);
+    }
+    return true;
+}
+
+boolean PubSubClient::connectSend(const char *id, const char *user, const char *pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession) {
+    int result = 0;
+
+    if (_client == nullptr) {
+        return false;
+    }
+    if (_client->connected()) {
+        result = 1;
+    } else {
+        if (domain.length() != 0) {
+            result = _client->connect(this->domain.c_str(), this->port);
         } else {
-            if (domain.length() != 0) {
-                result = _client->connect(this->domain.c_str(), this->port);
-            } else {
-                result = _client->connect(this->ip, this->port);
-            }
+            result = _client->connect(this->ip, this->port);
         }
-        if (result == 1) {
-            nextMsgId = 1;
-            // Leave room in the buffer for header and variable length field
-            uint16_t length = MQTT_MAX_HEADER_SIZE;
-            unsigned int j;
+    }
+    if (result == 1) {
+        nextMsgId = 1;
+        // Leave room in the buffer for header and variable length field
+        uint16_t length = MQTT_MAX_HEADER_SIZE;
+        unsigned int j;
 
 #if MQTT_VERSION == MQTT_VERSION_3_1
-            uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
+        uint8_t d[9] = {0x00,0x06,'M','Q','I','s','d','p', MQTT_VERSION};
 #define MQTT_HEADER_VERSION_LENGTH 9
 #elif MQTT_VERSION == MQTT_VERSION_3_1_1
-            uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
+        uint8_t d[7] = {0x00,0x04,'M','Q','T','T',MQTT_VERSION};
 #define MQTT_HEADER_VERSION_LENGTH 7
 #endif
-            for (j = 0;j<MQTT_HEADER_VERSION_LENGTH;j++) {
-                buffer[length++] = d[j];
-            }
+        for (j = 0;j<MQTT_HEADER_VERSION_LENGTH;j++) {
+            buffer[length++] = d[j];
+        }
 
-            uint8_t v;
-            if (willTopic) {
-                v = 0x04|(willQos<<3)|(willRetain<<5);
-            } else {
-                v = 0x00;
-            }
-            if (cleanSession) {
-                v = v|0x02;
-            }
+        uint8_t v;
+        if (willTopic) {
+            v = 0x04|(willQos<<3)|(willRetain<<5);
+        } else {
+            v = 0x00;
+        }
+        if (cleanSession) {
+            v = v|0x02;
+        }
 
-            if(user != NULL) {
-                v = v|0x80;
+        if(user != NULL) {
+            v = v|0x80;
 
-                if(pass != NULL) {
-                    v = v|(0x80>>1);
-                }
+            if(pass != NULL) {
+                v = v|(0x80>>1);
             }
+        }
 
-            buffer[length++] = v;
+        buffer[length++] = v;
 
-            buffer[length++] = ((MQTT_KEEPALIVE) >> 8);
-            buffer[length++] = ((MQTT_KEEPALIVE) & 0xFF);
+        buffer[length++] = ((MQTT_KEEPALIVE) >> 8);
+        buffer[length++] = ((MQTT_KEEPALIVE) & 0xFF);
 
-            CHECK_STRING_LENGTH(length,id)
-            length = writeString(id,buffer,length);
-            if (willTopic) {
-                CHECK_STRING_LENGTH(length,willTopic)
-                length = writeString(willTopic,buffer,length);
-                CHECK_STRING_LENGTH(length,willMessage)
-                length = writeString(willMessage,buffer,length);
-            }
+        CHECK_STRING_LENGTH(length,id)
+        length = writeString(id,buffer,length);
+        if (willTopic) {
+            CHECK_STRING_LENGTH(length,willTopic)
+            length = writeString(willTopic,buffer,length);
+            CHECK_STRING_LENGTH(length,willMessage)
+            length = writeString(willMessage,buffer,length);
+        }
 
-            if(user != NULL) {
-                CHECK_STRING_LENGTH(length,user)
-                length = writeString(user,buffer,length);
-                if(pass != NULL) {
-                    CHECK_STRING_LENGTH(length,pass)
-                    length = writeString(pass,buffer,length);
-                }
+        if(user != NULL) {
+            CHECK_STRING_LENGTH(length,user)
+            length = writeString(user,buffer,length);
+            if(pass != NULL) {
+                CHECK_STRING_LENGTH(length,pass)
+                length = writeString(pass,buffer,length);
             }
+        }
 
-            write(MQTTCONNECT,buffer,length-MQTT_MAX_HEADER_SIZE);
-
-            lastInActivity = lastOutActivity = millis();
+        write(MQTTCONNECT,buffer,length-MQTT_MAX_HEADER_SIZE);
 
-            while (!_client->available()) {
-                delay(0);  // Prevent watchdog crashes
-                unsigned long t = millis();
-                if (t-lastInActivity >= ((int32_t) MQTT_SOCKET_TIMEOUT*1000UL)) {
-                    _state = MQTT_CONNECTION_TIMEOUT;
-                    _client->stop();
-                    return false;
-                }
-            }
-            uint8_t llen;
-            uint16_t len = readPacket(&llen);
+        lastInActivity = lastOutActivity = millis();
+        return true;
+    } else {
+        _state = MQTT_CONNECT_FAILED;
+    }
+    return false;
+}
 
-            if (len == 4) {
-                if (buffer[3] == 0) {
-                    lastInActivity = millis();
-                    pingOutstanding = false;
-                    _state = MQTT_CONNECTED;
-                    return true;
-                } else {
-                    _state = buffer[3];
-                }
-            }
+int PubSubClient::connectPoll() {
+    if (!_client->available()) {
+        unsigned long t = millis();
+        if (t-lastInActivity >= ((int32_t) MQTT_SOCKET_TIMEOUT*1000UL)) {
+            _state = MQTT_CONNECTION_TIMEOUT;
             _client->stop();
+            return -1;
+        }
+        return 0;
+    }
+    uint8_t llen;
+    uint16_t len = readPacket(&llen);
+
+    if (len == 4) {
+        if (buffer[3] == 0) {
+            lastInActivity = millis();
+            pingOutstanding = false;
+            _state = MQTT_CONNECTED;
+            return 1;
         } else {
-            _state = MQTT_CONNECT_FAILED;
+            _state = buffer[3];
         }
-        return false;
     }
-    return true;
+    _client->stop();
+    return -1;
 }
 
 // reads a byte into result
@@ -366,6 +381,10 @@ boolean PubSubClient::loop() {
                     _client->write(buffer,2);
                 } else if (type == MQTTPINGRESP) {
                     pingOutstanding = false;
+                } else if (type == MQTTPUBACK) {
+                    if (pubackCallback) {
+                        pubackCallback((buffer[llen+1]<<8)+buffer[llen+2]);
+                    }
                 }
             } else if (!connected()) {
                 // readPacket has closed the connection
@@ -467,7 +486,15 @@ boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsig
 }
 
 boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, boolean retained) {
+    return beginPublish(topic, plength, retained, 0, false);
+}
+
+boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, boolean retained, uint16_t msgId, boolean dup) {
+    _publishRemaining = 0;
     if (connected()) {
+        if (MQTT_MAX_HEADER_SIZE + 2+strlen(topic) + 2 > MQTT_MAX_PACKET_SIZE) {
+            return false;
+        }
         // Send the header and variable length field
         uint16_t length = MQTT_MAX_HEADER_SIZE;
         length = writeString(topic,buffer,length);
@@ -475,30 +502,47 @@ boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, bool
         if (retained) {
             header |= 1;
         }
+        if (msgId) {
+            header |= MQTTQOS1;
+            if (dup) {
+                header |= MQTTDUP;
+            }
+            buffer[length++] = (msgId >> 8);
+            buffer[length++] = (msgId & 0xFF);
+        }
         size_t hlen = buildHeader(header, buffer, plength+length-MQTT_MAX_HEADER_SIZE);
         uint16_t rc = _client->write(buffer+(MQTT_MAX_HEADER_SIZE-hlen),length-(MQTT_MAX_HEADER_SIZE-hlen));
         if (rc > 0) {
            lastOutActivity = millis();
         }
-        return (rc == (length-(MQTT_MAX_HEADER_SIZE-hlen)));
+        if (rc == (length-(MQTT_MAX_HEADER_SIZE-hlen))) {
+            _publishRemaining = plength;
+            return true;
+        }
     }
     return false;
 }
 
 int PubSubClient::endPublish() {
- return 1;
+    if (_publishRemaining == 0) {
+        return 1;
+    }
+    // Producer wrote less than announced. Pad to keep the broker in sync with the stream
+    uint8_t pad[16];
+    memset(pad, ' ', sizeof(pad));
+    while (_publishRemaining > 0) {
+        size_t chunk = (_publishRemaining < sizeof(pad)) ? _publishRemaining : sizeof(pad);
+        if (write(pad, chunk) != chunk) {
+            _publishRemaining = 0;
+            _client->stop();
+            break;
+        }
+    }
+    return 0;
 }
 
 size_t PubSubClient::write(uint8_t data) {
-    if (_client == nullptr) {
-        lastOutActivity = millis();
-        return 0;
-    }
-    size_t rc = _client->write(data);
-    if (rc != 0) {
-        lastOutActivity = millis();
-    }
-    return rc;
+    return write(&data, 1);
 }
 
 size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
@@ -506,19 +550,26 @@ size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
         lastOutActivity = millis();
         return 0;
     }
+    if (size > _publishRemaining) {
+        size = _publishRemaining;
+    }
+    if (size == 0) {
+        return 0;
+    }
     size_t rc = _client->write(buffer,size);
     if (rc != 0) {
         lastOutActivity = millis();
     }
+    _publishRemaining -= rc;
     return rc;
 }
 
-size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint16_t length) {
+size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint32_t length) {
     uint8_t lenBuf[4];
     uint8_t llen = 0;
     uint8_t digit;
     uint8_t pos = 0;
-    uint16_t len = length;
+    uint32_t len = length;
     do {
         digit = len % 128;
         len = len / 128;
@@ -563,6 +614,14 @@ boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length) {
 #endif
 }
 
+uint16_t PubSubClient::newMsgId() {
+    nextMsgId++;
+    if (nextMsgId == 0) {
+        nextMsgId = 1;
+    }
+    return nextMsgId;
+}
+
 boolean PubSubClient::subscribe(const char* topic) {
     return subscribe(topic, 0);
 }
@@ -644,9 +703,9 @@ boolean PubSubClient::connected() {
         return false;
     }
     if (_client->connected() == 0) {
-        bool lastStateConnected = this->_state == MQTT_CONNECTED;
-        this->disconnect();
-        if (lastStateConnected) {
+        // Leave a client alone that is still being connected by connectSend()/connectPoll() or the caller
+        if (this->_state == MQTT_CONNECTED) {
+            this->disconnect();
             this->_state = MQTT_CONNECTION_LOST;
         }
         return false;
@@ -677,6 +736,11 @@ PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
     return *this;
 }
 
+PubSubClient& PubSubClient::setPubackCallback(MQTT_PUBACK_CALLBACK_SIGNATURE) {
+    this->pubackCallback = pubackCallback;
+    return *this;
+}
+
 PubSubClient& PubSubClient::setClient(Client& client){
     this->_client = &client;
     return *this;
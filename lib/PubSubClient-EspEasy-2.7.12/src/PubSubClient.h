@@ -76,6 +76,7 @@
 #define MQTTQOS0        (0 << 1)
 #define MQTTQOS1        (1 << 1)
 #define MQTTQOS2        (2 << 1)
+#define MQTTDUP         (1 << 3)
 
 // Maximum size of fixed header and variable length size header
 #define MQTT_MAX_HEADER_SIZE 5
@@ -83,8 +84,10 @@
 #if defined(ESP8266) || defined(ESP32)
 #include <functional>
 #define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+#define MQTT_PUBACK_CALLBACK_SIGNATURE std::function<void(uint16_t)> pubackCallback
 #else
 #define MQTT_CALLBACK_SIGNATURE void (*callback)(char*, uint8_t*, unsigned int)
+#define MQTT_PUBACK_CALLBACK_SIGNATURE void (*pubackCallback)(uint16_t)
 #endif
 
 #define CHECK_STRING_LENGTH(l,s) if (l+2+strlen(s) > MQTT_MAX_PACKET_SIZE) {_client->stop();return false;}
@@ -98,6 +101,7 @@ private:
    unsigned long lastInActivity;
    bool pingOutstanding;
    MQTT_CALLBACK_SIGNATURE;
+   MQTT_PUBACK_CALLBACK_SIGNATURE = nullptr;
    uint16_t readPacket(uint8_t*);
    boolean readByte(uint8_t * result);
    boolean readByte(uint8_t * result, uint16_t * index);
@@ -107,7 +111,9 @@ private:
    // Returns the size of the header
    // Note: the header is built at the end of the first MQTT_MAX_HEADER_SIZE bytes, so will start
    //       (MQTT_MAX_HEADER_SIZE - <returned size>) bytes into the buffer
-   size_t buildHeader(uint8_t header, uint8_t* buf, uint16_t length);
+   size_t buildHeader(uint8_t header, uint8_t* buf, uint32_t length);
+   // Payload bytes still to be written for the message started with beginPublish
+   uint32_t _publishRemaining = 0;
    IPAddress ip;
    String domain;
    uint16_t port;
@@ -134,6 +140,8 @@ public:
    PubSubClient& setServer(uint8_t * ip, uint16_t port);
    PubSubClient& setServer(const char * domain, uint16_t port);
    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+   // Called with the packet identifier of each PUBACK received
+   PubSubClient& setPubackCallback(MQTT_PUBACK_CALLBACK_SIGNATURE);
    PubSubClient& setClient(Client& client);
    PubSubClient& setStream(Stream& stream);
 
@@ -142,6 +150,10 @@ public:
    boolean connect(const char* id, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage);
    boolean connect(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   // Non-blocking connect: send CONNECT using an already connected client if any, then call
+   // connectPoll() until it returns 1 (CONNACK accepted) or -1 (refused, timeout, see state())
+   boolean connectSend(const char* id, const char* user, const char* pass, const char* willTopic, uint8_t willQos, boolean willRetain, const char* willMessage, boolean cleanSession);
+   int connectPoll();
    void disconnect(bool disconnect_package = false);
    boolean publish(const char* topic, const char* payload);
    boolean publish(const char* topic, const char* payload, boolean retained);
@@ -158,12 +170,19 @@ public:
    // a new buffer and held in memory at one time
    // Returns 1 if the message was started successfully, 0 if there was an error
    boolean beginPublish(const char* topic, unsigned int plength, boolean retained);
+   // Start to publish a QoS 1 message using packet identifier msgId. Set dup when sending it again
+   // A msgId of 0 publishes with QoS 0
+   boolean beginPublish(const char* topic, unsigned int plength, boolean retained, uint16_t msgId, boolean dup);
+   // Returns a new non-zero packet identifier
+   uint16_t newMsgId();
    // Finish off this publish message (started with beginPublish)
-   // Returns 1 if the packet was sent successfully, 0 if there was an error
+   // Missing payload bytes are padded with spaces to keep the connection in sync
+   // Returns 1 if the packet was sent successfully, 0 if there was an error or padding was needed
    int endPublish();
    // Write a single byte of payload (only to be used with beginPublish/endPublish)
    virtual size_t write(uint8_t);
    // Write size bytes from buffer into the payload (only to be used with beginPublish/endPublish)
+   // Bytes exceeding the length given to beginPublish are dropped
    // Returns the number of bytes written
    virtual size_t write(const uint8_t *buffer, size_t size);
    boolean subscribe(const char* topic);
@@ -192,6 +192,9 @@ void WiFiClientSecure_light::_clear() {
 	_ta_P = nullptr;
   _ta_size = 0;
 	_max_thunkstack_use = 0;
+	_x509_context = nullptr;
+	_session = nullptr;
+	_resumed = false;
 }
 
 // Constructor
@@ -256,6 +259,7 @@ void WiFiClientSecure_light::setBufferSizes(int recv, int xmit) {
 
 bool WiFiClientSecure_light::stop(unsigned int maxWaitMs) {
   bool ret = WiFiClient::stop(maxWaitMs); // calls our virtual flush()
+  _endSSL();    // in case a non-blocking handshake was aborted
   _freeSSL();
   return ret;
 }
@@ -294,6 +298,47 @@ int WiFiClientSecure_light::connect(const char* name, uint16_t port) {
   return _connectSSL(name);
 }
 
+int WiFiClientSecure_light::connectStart(IPAddress ip, uint16_t port, const char* hostName) {
+  DEBUG_BSSL("connectStart(%s,%d)\n", ip.toString().c_str(), port);
+	clearLastError();
+  if (!WiFiClient::connect(ip, port)) {
+		setLastError(ERR_TCP_CONNECT);
+    return 0;
+  }
+  return _startSSL(hostName);
+}
+
+int WiFiClientSecure_light::connectRun(void) {
+  if (_handshake_done) {
+    return 1;
+  }
+  if (!ctx_present() || !_x509_context) {
+    return -1;
+  }
+  // Process the records received so far without waiting for more
+  (void) _run_until(BR_SSL_SENDAPP, false);
+  int state = br_ssl_engine_current_state(_eng);
+  if (state & BR_SSL_SENDAPP) {
+    _handshake_done = true;
+    _endSSL();
+    return 1;
+  }
+  if ((state & BR_SSL_CLOSED) || !_clientConnected()) {
+    DEBUG_BSSL("connectRun: failed\n");
+    _endSSL();
+    return -1;
+  }
+  return 0;
+}
+
+bool WiFiClientSecure_light::getSession(br_ssl_session_parameters *session) {
+  if (!_handshake_done || !ctx_present()) {
+    return false;
+  }
+  br_ssl_engine_get_session_parameters(_eng, session);
+  return (session->session_id_len > 0);
+}
+
 void WiFiClientSecure_light::_freeSSL() {
   _ctx_present = false;
   _recvapp_buf = nullptr;
@@ -882,6 +927,25 @@ extern "C" {
 // Called by connect() to do the actual SSL setup and handshake.
 // Returns if the SSL handshake succeeded.
 bool WiFiClientSecure_light::_connectSSL(const char* hostName) {
+	if (!_startSSL(hostName)) {
+		return false;
+	}
+  auto ret = _wait_for_handshake();
+#ifdef DEBUG_ESP_SSL
+  if (!ret) {
+    DEBUG_BSSL("Couldn't connect. Error = %d\n", getLastError());
+  } else {
+    DEBUG_BSSL("Connected! MFLNStatus = %d\n", getMFLNStatus());
+  }
+#endif
+	_endSSL();
+  return ret;
+}
+
+// Set up the SSL engine and start the handshake. The Thunk stack and the
+// decoder context are kept until _endSSL() so the handshake can run in slices.
+// Returns false on Out of Memory error.
+bool WiFiClientSecure_light::_startSSL(const char* hostName) {
 	// Validation context, either full CA validation or checking only fingerprints
 #ifdef USE_MQTT_TLS_CA_CERT
 	br_x509_minimal_context *x509_minimal;
@@ -913,6 +977,7 @@ bool WiFiClientSecure_light::_connectSSL(const char* hostName) {
 	#ifdef USE_MQTT_TLS_CA_CERT
 		x509_minimal = (br_x509_minimal_context*) malloc(sizeof(br_x509_minimal_context));
 		if (!x509_minimal) break;
+		_x509_context = x509_minimal;
 		br_x509_minimal_init(x509_minimal, &br_sha256_vtable, _ta_P, _ta_size);
 		br_x509_minimal_set_rsa(x509_minimal, br_ssl_engine_get_rsavrfy(_eng));
 		br_x509_minimal_set_hash(x509_minimal, br_sha256_ID, &br_sha256_vtable);
@@ -922,6 +987,7 @@ bool WiFiClientSecure_light::_connectSSL(const char* hostName) {
 	  x509_insecure = (br_x509_pubkeyfingerprint_context*) malloc(sizeof(br_x509_pubkeyfingerprint_context));
 		//x509_insecure = std::unique_ptr<br_x509_pubkeyfingerprint_context>(new br_x509_pubkeyfingerprint_context);
 		if (!x509_insecure) break;
+		_x509_context = x509_insecure;
 	  br_x509_pubkeyfingerprint_init(x509_insecure, _fingerprint1, _fingerprint2, _recv_fingerprint, _fingerprint_any);
 		br_ssl_engine_set_x509(_eng, &x509_insecure->vtable);
 	#endif
@@ -943,31 +1009,18 @@ bool WiFiClientSecure_light::_connectSSL(const char* hostName) {
 	                              _cert_issuer_key_type, &br_ec_p256_m15, br_ecdsa_sign_asn1_get_default());
 	#endif // USE_MQTT_AWS_IOT
 
+		// ============================================================
+		// Offer previous session for an abbreviated handshake
+		_resumed = false;
+		if (_session) {
+			br_ssl_engine_set_session_parameters(_eng, _session);
+		}
+
 		// ============================================================
 		// Start TLS connection, ALL
-	  if (!br_ssl_client_reset(_sc.get(), hostName, 0)) break;
-
-	  auto ret = _wait_for_handshake();
-	#ifdef DEBUG_ESP_SSL
-	  if (!ret) {
-	    DEBUG_BSSL("Couldn't connect. Error = %d\n", getLastError());
-	  } else {
-	    DEBUG_BSSL("Connected! MFLNStatus = %d\n", getMFLNStatus());
-	  }
-	#endif
-		LOG_HEAP_SIZE("_connectSSL.end");
-		_max_thunkstack_use = stack_thunk_light_get_max_usage();
-		stack_thunk_light_del_ref();
-	  //stack_thunk_light_repaint();
-		LOG_HEAP_SIZE("_connectSSL.end, freeing StackThunk");
+	  if (!br_ssl_client_reset(_sc.get(), hostName, (_session) ? 1 : 0)) break;
 
-	#ifdef USE_MQTT_TLS_CA_CERT
-		free(x509_minimal);
-	#else
-		free(x509_insecure);
-	#endif
-		LOG_HEAP_SIZE("_connectSSL after release of Priv Key");
-	  return ret;
+	  return true;
 	} while (0);
 
 	// ============================================================
@@ -975,15 +1028,34 @@ bool WiFiClientSecure_light::_connectSSL(const char* hostName) {
 	setLastError(ERR_OOM);
 	DEBUG_BSSL("_connectSSL: Out of memory\n");
 	stack_thunk_light_del_ref();
-#ifdef USE_MQTT_TLS_CA_CERT
-	free(x509_minimal);
-#else
-	free(x509_insecure);
-#endif
+	free(_x509_context);
+	_x509_context = nullptr;
 	LOG_HEAP_SIZE("_connectSSL clean_on_error");
 	return false;
 }
 
+// Release the Thunk stack and the decoder context after the handshake
+void WiFiClientSecure_light::_endSSL(void) {
+	if (!_x509_context) {
+		return;			// No handshake in progress
+	}
+	if (_handshake_done && _session) {
+		br_ssl_session_parameters params;
+		br_ssl_engine_get_session_parameters(_eng, &params);
+		_resumed = (_session->session_id_len > 0) && (params.session_id_len == _session->session_id_len) &&
+		           !memcmp(params.session_id, _session->session_id, params.session_id_len);
+	}
+	LOG_HEAP_SIZE("_connectSSL.end");
+	_max_thunkstack_use = stack_thunk_light_get_max_usage();
+	stack_thunk_light_del_ref();
+  //stack_thunk_light_repaint();
+	LOG_HEAP_SIZE("_connectSSL.end, freeing StackThunk");
+
+	free(_x509_context);
+	_x509_context = nullptr;
+	LOG_HEAP_SIZE("_connectSSL after release of Priv Key");
+}
+
 };
 
 #include "t_bearssl_tasmota_config.h"
@@ -40,6 +40,10 @@ class WiFiClientSecure_light : public WiFiClient {
 
     int connect(IPAddress ip, uint16_t port) override;
     int connect(const char* name, uint16_t port) override;
+    // Non-blocking connection: TCP connect and start of TLS handshake
+    // Call connectRun() until it returns 1 (connected) or -1 (error)
+    int connectStart(IPAddress ip, uint16_t port, const char* hostName);
+    int connectRun(void);
 
     uint8_t connected() override;
     size_t write(const uint8_t *buf, size_t size) override;
@@ -101,6 +105,16 @@ class WiFiClientSecure_light : public WiFiClient {
     inline size_t getMaxThunkStackUse(void) {
       return _max_thunkstack_use;
     }
+    // TLS session to offer for resumption on next connect, nullptr for a full handshake
+    void setSession(const br_ssl_session_parameters *session) {
+      _session = session;
+    }
+    // Get session parameters of the current connection for later resumption
+    bool getSession(br_ssl_session_parameters *session);
+    // Returns whether the offered session was resumed (after connection)
+    bool isResumed(void) {
+      return _resumed;
+    }
 
   private:
     void _clear();
@@ -133,6 +147,8 @@ class WiFiClientSecure_light : public WiFiClient {
 
     bool _clientConnected(); // Is the underlying socket alive?
     bool _connectSSL(const char *hostName); // Do initial SSL handshake
+    bool _startSSL(const char *hostName);   // Set up SSL engine and start handshake
+    void _endSSL(void);                     // Release handshake resources
     void _freeSSL();
     int _run_until(unsigned target, bool blocking = true);
     size_t _write(const uint8_t *buf, size_t size, bool pmem);
@@ -148,6 +164,11 @@ class WiFiClientSecure_light : public WiFiClient {
 
     // record the maximum use of ThunkStack for monitoring
     size_t _max_thunkstack_use;
+    // X509 decoder context during handshake
+    void *_x509_context;
+    // Session resumption
+    const br_ssl_session_parameters *_session;
+    bool _resumed;
 
 };
 
@@ -326,6 +326,10 @@
 #define D_CMND_HUMOFFSET "HumOffset"
 #define D_CMND_GLOBAL_TEMP "GlobalTemp"
 #define D_CMND_GLOBAL_HUM "GlobalHum"
+#define D_CMND_PROFILE "Profile"
+#define D_CMND_TELEDELTA "TeleDelta"
+#define D_CMND_TELECOALESCE "TeleCoalesce"
+#define D_CMND_TELEDEADBAND "TeleDeadband"
 
 #ifdef ESP32
 #define D_CMND_TOUCH_CAL "TouchCal"
@@ -339,6 +343,8 @@
 #define D_CMND_MQTTHOST "MqttHost"
 #define D_CMND_MQTTPORT "MqttPort"
 #define D_CMND_MQTTRETRY "MqttRetry"
+#define D_CMND_MQTTQOS "MqttQos"
+#define D_CMND_MQTTCBOR "MqttCbor"
 #define D_CMND_STATETEXT "StateText"
 #define D_CMND_MQTTFINGERPRINT "MqttFingerprint"
 #define D_CMND_MQTTCLIENT "MqttClient"
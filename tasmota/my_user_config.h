@@ -374,6 +374,8 @@
 
 #define MQTT_TELE_RETAIN       0                 // Tele messages may send retain flag (0 = off, 1 = on)
 #define MQTT_CLEAN_SESSION     1                 // Mqtt clean session connection (0 = No clean session, 1 = Clean session (default))
+//#define USE_TELE_DELTA                           // Add commands TeleDelta, TeleCoalesce and TeleDeadband to publish changed telemetry only (+2k code, +0.5k mem when enabled)
+//#define USE_MQTT_CBOR                            // Add command MqttCbor to publish SENSOR, STATE, RESULT and Zigbee payloads as CBOR and accept CBOR commands (+3k code)
 
 // -- MQTT - Domoticz -----------------------------
 #define USE_DOMOTICZ                             // Enable Domoticz (+6k code, +0.3k mem)
@@ -807,6 +809,8 @@
 //#define DEBUG_TASMOTA_DRIVER                     // Enable driver debug messages
 //#define DEBUG_TASMOTA_SENSOR                     // Enable sensor debug messages
 //#define USE_DEBUG_DRIVER                         // Use xdrv_99_debug.ino providing commands CpuChk, CfgXor, CfgDump, CfgPeek and CfgPoke
+//#define USE_PROFILE_DRIVER                       // Add command Profile for per driver call count and execution time (+1k5 code, +1k mem when enabled)
+//#define USE_LOG_BINARY                           // Queue log messages as format pointer and arguments and format them from loop() (+2k code, +2k mem)
 
 /*********************************************************************************************\
  * Optional firmware configurations
@@ -132,7 +132,7 @@ typedef union {                            // Restricted by MISRA-C Rule 18.4 bu
     uint32_t zb_disable_autobind : 1;      // bit 28 (v8.5.0.1)  - SetOption110 - disable Zigbee auto-config when pairing new devices
     uint32_t buzzer_freq_mode : 1;         // bit 29 (v8.5.0.1)  - SetOption111 - Use frequency output for buzzer pin instead of on/off signal
     uint32_t zb_topic_fname : 1;           // bit 30 (v8.5.0.1)  - SetOption112 - Use friendly name in zigbee topic (use with SetOption89)
-    uint32_t spare31 : 1;                  // bit 31
+    uint32_t syslog_batch : 1;             // bit 31 (v9.0.0.2)  - SetOption113 - Send syslog batched in RFC5424 format with RFC6587 octet counting
   };
 } SysBitfield4;
 
@@ -635,7 +635,16 @@ struct {
   uint16_t      energy_power_delta[3];     // F44
   uint16_t      shutter_pwmrange[2][MAX_SHUTTERS];  // F4A
 
-  uint8_t       free_f5a[89];             // F5A  Decrement if adding new Setting variables just above and below
+  uint8_t       mqtt_qos_policy;           // F5A
+  uint8_t       tele_delta;                // F5B
+  struct {
+    float       deadband;
+    char        key[16];
+  } tele_deadband[MAX_TELE_DEADBANDS];     // F5C
+  uint8_t       tele_coalesce;             // FAC
+
+  uint8_t       mqtt_cbor;                 // FAD
+  uint8_t       free_fae[5];              // FAE  Decrement if adding new Setting variables just above and below
 
   // Only 32 bit boundary variables below
   SysBitfield5  flag5;                     // FB4
@@ -17,9 +17,6 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-IPAddress syslog_host_addr;      // Syslog host IP address
-uint32_t syslog_host_hash = 0;   // Syslog host name hash
-
 extern "C" {
 extern struct rst_info resetInfo;
 }
@@ -841,6 +838,95 @@ int GetCommandCode(char* destination, size_t destination_size, const char* needl
   return result;
 }
 
+/*********************************************************************************************\
+ * Command table hash index
+ *
+ * Each command table used by DecodeCommand gets a one byte hash per command on first use.
+ * A lookup compares the needle hash with the hashes in RAM and only walks the PROGMEM
+ * table to verify a matching hash.
+\*********************************************************************************************/
+
+#ifndef MAX_COMMAND_TABLES
+#define MAX_COMMAND_TABLES     32             // Max number of indexed command tables
+#endif
+
+struct COMMAND_INDEX {
+  const char* haystack[MAX_COMMAND_TABLES];
+  uint8_t* hashes[MAX_COMMAND_TABLES];        // [0] = number of commands, [1..] = hash per command
+} CommandIndex;
+
+uint8_t CommandHashFold(uint32_t hash)
+{
+  return (hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 24)) & 0xFF;
+}
+
+uint8_t* CommandIndexGet(const char* haystack)
+{
+  uint32_t slot = ((uintptr_t)haystack >> 2) % MAX_COMMAND_TABLES;
+  for (uint32_t i = 0; i < MAX_COMMAND_TABLES; i++) {
+    if (CommandIndex.haystack[slot] == haystack) {
+      return CommandIndex.hashes[slot];
+    }
+    if (nullptr == CommandIndex.haystack[slot]) {
+      // Build index on first use of this command table
+      uint32_t count = 0;
+      const char* read = haystack;
+      char ch;
+      do {
+        ch = pgm_read_byte(read++);
+        if (('\0' == ch) || ('|' == ch)) { count++; }
+      } while (ch);
+      if (count > 255) { return nullptr; }
+
+      uint8_t* hashes = (uint8_t*)malloc(count +1);
+      if (!hashes) { return nullptr; }
+      hashes[0] = count;
+      read = haystack;
+      for (uint32_t j = 1; j <= count; j++) {
+        uint32_t hash = 0;
+        while ((ch = pgm_read_byte(read++)) && (ch != '|')) {
+          hash = hash * 31 + toupper(ch);
+        }
+        hashes[j] = CommandHashFold(hash);
+      }
+      CommandIndex.haystack[slot] = haystack;
+      CommandIndex.hashes[slot] = hashes;
+      return hashes;
+    }
+    slot++;
+    if (slot >= MAX_COMMAND_TABLES) { slot = 0; }
+  }
+  return nullptr;                             // Index full
+}
+
+int GetCommandCodeHashed(char* destination, size_t destination_size, const char* needle, const char* haystack)
+{
+  // Returns -1 of not found
+  // Returns index and command if found
+  uint8_t* hashes = CommandIndexGet(haystack);
+  if (!hashes) {
+    return GetCommandCode(destination, destination_size, needle, haystack);
+  }
+
+  uint32_t hash = 0;
+  for (const char* read = needle; *read; read++) {
+    hash = hash * 31 + toupper(*read);
+  }
+  uint8_t needle_hash = CommandHashFold(hash);
+
+  uint32_t count = hashes[0];
+  for (uint32_t i = 0; i < count; i++) {
+    if (hashes[i +1] == needle_hash) {
+      GetTextIndexed(destination, destination_size, i, haystack);
+      if (!strcasecmp(needle, destination)) {
+        return i;
+      }
+    }
+  }
+  *destination = '\0';
+  return -1;
+}
+
 bool DecodeCommand(const char* haystack, void (* const MyCommand[])(void))
 {
   GetTextIndexed(XdrvMailbox.command, CMDSZ, 0, haystack);  // Get prefix if available
@@ -852,7 +938,7 @@ bool DecodeCommand(const char* haystack, void (* const MyCommand[])(void))
       return false;                                         // Prefix not in command
     }
   }
-  int command_code = GetCommandCode(XdrvMailbox.command + prefix_length, CMDSZ, XdrvMailbox.topic + prefix_length, haystack);
+  int command_code = GetCommandCodeHashed(XdrvMailbox.command + prefix_length, CMDSZ - prefix_length, XdrvMailbox.topic + prefix_length, haystack);
   if (command_code > 0) {                                   // Skip prefix
     XdrvMailbox.command_code = command_code -1;
     MyCommand[XdrvMailbox.command_code]();
@@ -1054,10 +1140,90 @@ uint32_t WebColor(uint32_t i)
 
 /*********************************************************************************************\
  * Response data handling
+ *
+ * The Response functions keep the length of mqtt_data and a truncation flag for data written since
+ * the last Response_P or ResponseClear so appending does not need to scan the whole buffer. A few
+ * O(1) probes catch direct writes clearing, extending or truncating mqtt_data at its end. Code
+ * writing shorter data into mqtt_data directly must use Response_P or call ResponseReset after it.
+ * ResponseUnits finds the unit classes (pressure, temperature and speed) used in mqtt_data with a
+ * single scan.
 \*********************************************************************************************/
 
 const uint16_t TIMESZ = 100;                   // Max number of characters in time string
 
+struct RESPONSE {
+  uint16_t len = 0;                            // Length of mqtt_data
+  bool overflow = false;                       // Data did not fit in mqtt_data
+} Response;
+
+const char kResponseUnitKeys[] PROGMEM = D_JSON_PRESSURE "|" D_JSON_TEMPERATURE "|" D_JSON_SPEED;
+
+void ResponseSetLength(int len, uint32_t start)
+{
+  // len as returned by vsnprintf_P for data written from start
+  if (len < 0) {
+    Response.len = strlen(mqtt_data);
+  }
+  else if (start + len >= sizeof(mqtt_data)) {
+    Response.overflow = true;
+    Response.len = sizeof(mqtt_data) -1;       // vsnprintf_P truncated the data
+  } else {
+    Response.len = start + len;
+  }
+}
+
+uint32_t ResponseLength(void)
+{
+  uint32_t len = Response.len;
+  if ((len >= sizeof(mqtt_data)) || mqtt_data[len] || (len && (!mqtt_data[0] || !mqtt_data[len -1]))) {
+    // mqtt_data has been changed outside of the Response functions
+    Response.len = strlen(mqtt_data);
+    Response.overflow = false;
+  }
+  return Response.len;
+}
+
+bool ResponseOverflow(void)
+{
+  ResponseLength();
+  return Response.overflow;
+}
+
+uint32_t ResponseUnits(void)
+{
+  // Returns RESPONSE_UNIT_xxx flags for unit keys found in mqtt_data
+  uint32_t units = 0;
+  for (uint32_t i = 0; mqtt_data[i]; i++) {
+    uint32_t index;
+    switch (mqtt_data[i]) {
+      case D_JSON_PRESSURE[0]: index = 0; break;
+      case D_JSON_TEMPERATURE[0]: index = 1; break;
+      case D_JSON_SPEED[0]: index = 2; break;
+      default: continue;
+    }
+    if (units & (1 << index)) { continue; }
+    char key[sizeof(D_JSON_TEMPERATURE)];      // Longest key
+    GetTextIndexed(key, sizeof(key), index, kResponseUnitKeys);
+    if (!strncmp(mqtt_data + i, key, strlen(key))) {
+      units |= (1 << index);
+    }
+  }
+  return units;
+}
+
+void ResponseReset(void)
+{
+  // Start a new response or take the length from mqtt_data after writing it directly
+  Response.len = 0;
+  Response.overflow = false;
+}
+
+void ResponseClear(void)
+{
+  mqtt_data[0] = '\0';
+  ResponseReset();
+}
+
 char* ResponseGetTime(uint32_t format, char* time_str)
 {
   switch (format) {
@@ -1081,8 +1247,10 @@ int Response_P(const char* format, ...)        // Content send snprintf_P char d
   // This uses char strings. Be aware of sending %% if % is needed
   va_list args;
   va_start(args, format);
+  ResponseReset();
   int len = vsnprintf_P(mqtt_data, sizeof(mqtt_data), format, args);
   va_end(args);
+  ResponseSetLength(len, 0);
   return len;
 }
 
@@ -1092,11 +1260,13 @@ int ResponseTime_P(const char* format, ...)    // Content send snprintf_P char d
   va_list args;
   va_start(args, format);
 
+  ResponseReset();
   ResponseGetTime(Settings.flag2.time_format, mqtt_data);
 
   int mlen = strlen(mqtt_data);
   int len = vsnprintf_P(mqtt_data + mlen, sizeof(mqtt_data) - mlen, format, args);
   va_end(args);
+  ResponseSetLength(len, mlen);
   return len + mlen;
 }
 
@@ -1105,9 +1275,10 @@ int ResponseAppend_P(const char* format, ...)  // Content send snprintf_P char d
   // This uses char strings. Be aware of sending %% if % is needed
   va_list args;
   va_start(args, format);
-  int mlen = strlen(mqtt_data);
+  int mlen = ResponseLength();
   int len = vsnprintf_P(mqtt_data + mlen, sizeof(mqtt_data) - mlen, format, args);
   va_end(args);
+  ResponseSetLength(len, mlen);
   return len + mlen;
 }
 
@@ -1924,6 +2095,7 @@ void SetSeriallog(uint32_t loglevel)
   Settings.seriallog_level = loglevel;
   seriallog_level = loglevel;
   seriallog_timer = 0;
+  UpdateLogLevelMax();
 }
 
 void SetSyslog(uint32_t loglevel)
@@ -1931,60 +2103,137 @@ void SetSyslog(uint32_t loglevel)
   Settings.syslog_level = loglevel;
   syslog_level = loglevel;
   syslog_timer = 0;
+  UpdateLogLevelMax();
+}
+
+void UpdateLogLevelMax(void)
+{
+  // Highest level any log sink accepts. Messages above it are dropped before formatting
+  uint32_t level = seriallog_level;
+  if (Settings.weblog_level > level) { level = Settings.weblog_level; }
+  if (Settings.mqttlog_level > level) { level = Settings.mqttlog_level; }
+  if (syslog_level > level) { level = syslog_level; }
+  log_level_max = level;
 }
 
 #ifdef USE_WEBSERVER
+/*********************************************************************************************\
+ * Web log ring buffer
+ *
+ * Log lines are stored in web_log as records of a two byte length followed by the text and a
+ * terminating '\1'. A record never wraps. If it does not fit at the end of the buffer it is
+ * stored at the start and the unused end is skipped. Oldest records are removed until the new
+ * record fits. Log index 1 to 255 is mapped to its record offset for direct access.
+\*********************************************************************************************/
+
+struct WEBLOG {
+  uint16_t offset[256];                        // Record offset per log index
+  uint16_t head = 0;                           // Offset of oldest record
+  uint16_t tail = 0;                           // Offset for next record
+  uint16_t wrap = 0;                           // End of records before the start when wrapped
+  uint8_t oldest = 1;                          // Log index of oldest record
+  uint8_t count = 0;                           // Number of records
+  bool wrapped = false;                        // Records continue at the start of the buffer
+} WebLog;
+
+uint32_t WebLogNextIndex(uint32_t idx)
+{
+  idx++;
+  idx &= 0xFF;
+  if (!idx) { idx++; }                         // Index 0 is not allowed
+  return idx;
+}
+
+void WebLogRemoveOldest(void)
+{
+  uint16_t len;
+  memcpy(&len, web_log + WebLog.head, sizeof(len));
+  WebLog.head += sizeof(len) + len;
+  WebLog.oldest = WebLogNextIndex(WebLog.oldest);
+  WebLog.count--;
+  if (!WebLog.count) {
+    WebLog.head = 0;
+    WebLog.tail = 0;
+    WebLog.wrapped = false;
+  }
+  else if (WebLog.wrapped && (WebLog.head >= WebLog.wrap)) {
+    WebLog.head = 0;
+    WebLog.wrapped = false;
+  }
+}
+
+void WebLogAdd(uint32_t idx, const char* mxtime, const char* line)
+{
+  uint32_t mlen = strlen(mxtime);
+  uint32_t llen = strlen(line);
+  uint16_t len = mlen + llen +1;               // Text and terminating '\1'
+  uint32_t size = sizeof(len) + len;
+  if (size > WEB_LOG_SIZE) { return; }
+
+  if (WebLog.count && (WebLog.oldest == idx)) {  // Log index about to be re-used
+    WebLogRemoveOldest();
+  }
+  while (true) {
+    if (!WebLog.wrapped) {
+      if (WEB_LOG_SIZE - WebLog.tail >= size) { break; }
+      if (WebLog.count) {
+        WebLog.wrap = WebLog.tail;             // Skip unused end of buffer
+        WebLog.wrapped = true;
+      }
+      WebLog.tail = 0;
+      if (!WebLog.count) { break; }
+    }
+    if (WebLog.head - WebLog.tail >= size) { break; }
+    WebLogRemoveOldest();
+  }
+
+  char* record = web_log + WebLog.tail;
+  memcpy(record, &len, sizeof(len));
+  record += sizeof(len);
+  memcpy(record, mxtime, mlen);
+  memcpy(record + mlen, line, llen);
+  record[mlen + llen] = '\1';
+  if (!WebLog.count) {
+    WebLog.head = WebLog.tail;
+    WebLog.oldest = idx;
+  }
+  WebLog.offset[idx] = WebLog.tail;
+  WebLog.tail += size;
+  WebLog.count++;
+}
+
 void GetLog(uint32_t idx, char** entry_pp, size_t* len_p)
 {
   char* entry_p = nullptr;
   size_t len = 0;
 
-  if (idx) {
-    char* it = web_log;
-    do {
-      uint32_t cur_idx = *it;
-      it++;
-      size_t tmp = strchrspn(it, '\1');
-      tmp++;                             // Skip terminating '\1'
-      if (cur_idx == idx) {              // Found the requested entry
-        len = tmp;
-        entry_p = it;
-        break;
-      }
-      it += tmp;
-    } while (it < web_log + WEB_LOG_SIZE && *it != '\0');
+  if (idx && (idx < 256) && WebLog.count) {
+    uint32_t age = (idx + 255 - WebLog.oldest) % 255;  // Log index distance from oldest skipping index 0
+    if (age < WebLog.count) {
+      uint16_t rlen;
+      memcpy(&rlen, web_log + WebLog.offset[idx], sizeof(rlen));
+      entry_p = web_log + WebLog.offset[idx] + sizeof(rlen);
+      len = rlen;
+    }
   }
   *entry_pp = entry_p;
   *len_p = len;
 }
 #endif  // USE_WEBSERVER
 
-void Syslog(void)
+void AddLog(uint32_t loglevel)
 {
-  // Destroys log_data
+  prepped_loglevel = 0;
+  if (loglevel > log_level_max) { return; }
 
-  uint32_t current_hash = GetHash(SettingsText(SET_SYSLOG_HOST), strlen(SettingsText(SET_SYSLOG_HOST)));
-  if (syslog_host_hash != current_hash) {
-    syslog_host_hash = current_hash;
-    WiFi.hostByName(SettingsText(SET_SYSLOG_HOST), syslog_host_addr);  // If sleep enabled this might result in exception so try to do it once using hash
-  }
-  if (PortUdp.beginPacket(syslog_host_addr, Settings.syslog_port)) {
-    char syslog_preamble[64];  // Hostname + Id
-    snprintf_P(syslog_preamble, sizeof(syslog_preamble), PSTR("%s ESP-"), NetworkHostname());
-    memmove(log_data + strlen(syslog_preamble), log_data, sizeof(log_data) - strlen(syslog_preamble));
-    log_data[sizeof(log_data) -1] = '\0';
-    memcpy(log_data, syslog_preamble, strlen(syslog_preamble));
-    PortUdp_write(log_data, strlen(log_data));
-    PortUdp.endPacket();
-    delay(1);  // Add time for UDP handling (#5512)
-  } else {
-    syslog_level = 0;
-    syslog_timer = SYSLOG_TIMER;
-    AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_APPLICATION D_SYSLOG_HOST_NOT_FOUND ". " D_RETRY_IN " %d " D_UNIT_SECOND), SYSLOG_TIMER);
-  }
+#ifdef USE_LOG_BINARY
+  LogBinaryAddText(loglevel, log_data);  // Keep order with queued binary messages
+#else
+  AddLogToSinks(loglevel);
+#endif  // USE_LOG_BINARY
 }
 
-void AddLog(uint32_t loglevel)
+void AddLogToSinks(uint32_t loglevel)
 {
   char mxtime[10];  // "13:45:21 "
   snprintf_P(mxtime, sizeof(mxtime), PSTR("%02d" D_HOUR_MINUTE_SEPARATOR "%02d" D_MINUTE_SECOND_SEPARATOR "%02d "), RtcTime.hour, RtcTime.minute, RtcTime.second);
@@ -1997,22 +2246,10 @@ void AddLog(uint32_t loglevel)
   if (Settings.webserver &&
      (loglevel <= Settings.weblog_level) &&
      (masterlog_level <= Settings.weblog_level)) {
-    // Delimited, zero-terminated buffer of log lines.
-    // Each entry has this format: [index][log data]['\1']
-    web_log_index &= 0xFF;
-    if (!web_log_index) web_log_index++;   // Index 0 is not allowed as it is the end of char string
-    while (web_log_index == web_log[0] ||  // If log already holds the next index, remove it
-           strlen(web_log) + strlen(log_data) + 13 > WEB_LOG_SIZE)  // 13 = web_log_index + mxtime + '\1' + '\0'
-    {
-      char* it = web_log;
-      it++;                                // Skip web_log_index
-      it += strchrspn(it, '\1');           // Skip log line
-      it++;                                // Skip delimiting "\1"
-      memmove(web_log, it, WEB_LOG_SIZE -(it-web_log));  // Move buffer forward to remove oldest log line
-    }
-    snprintf_P(web_log, sizeof(web_log), PSTR("%s%c%s%s\1"), web_log, web_log_index++, mxtime, log_data);
     web_log_index &= 0xFF;
-    if (!web_log_index) web_log_index++;   // Index 0 is not allowed as it is the end of char string
+    if (!web_log_index) web_log_index++;   // Index 0 is not allowed
+    WebLogAdd(web_log_index, mxtime, log_data);
+    web_log_index = WebLogNextIndex(web_log_index);
   }
 #endif  // USE_WEBSERVER
   if (Settings.flag.mqtt_enabled &&        // SetOption3 - Enable MQTT
@@ -2022,19 +2259,21 @@ void AddLog(uint32_t loglevel)
 
   if (!global_state.network_down &&
       (loglevel <= syslog_level) &&
-      (masterlog_level <= syslog_level)) { Syslog(); }
-
-  prepped_loglevel = 0;
+      (masterlog_level <= syslog_level)) { SyslogAdd(loglevel, log_data); }
 }
 
 void AddLog_P(uint32_t loglevel, const char *formatP)
 {
+  if (loglevel > log_level_max) { return; }
+
   snprintf_P(log_data, sizeof(log_data), formatP);
   AddLog(loglevel);
 }
 
 void AddLog_P(uint32_t loglevel, const char *formatP, const char *formatP2)
 {
+  if (loglevel > log_level_max) { return; }
+
   char message[sizeof(log_data)];
 
   snprintf_P(log_data, sizeof(log_data), formatP);
@@ -2045,6 +2284,8 @@ void AddLog_P(uint32_t loglevel, const char *formatP, const char *formatP2)
 
 void PrepLog_P2(uint32_t loglevel, PGM_P formatP, ...)
 {
+  if (loglevel > log_level_max) { return; }
+
   va_list arg;
   va_start(arg, formatP);
   vsnprintf_P(log_data, sizeof(log_data), formatP, arg);
@@ -2055,16 +2296,25 @@ void PrepLog_P2(uint32_t loglevel, PGM_P formatP, ...)
 
 void AddLog_P2(uint32_t loglevel, PGM_P formatP, ...)
 {
+  if (loglevel > log_level_max) { return; }
+
   va_list arg;
   va_start(arg, formatP);
+#ifdef USE_LOG_BINARY
+  LogBinaryAdd(loglevel, formatP, arg);  // Format when draining the queue from loop()
+  va_end(arg);
+#else
   vsnprintf_P(log_data, sizeof(log_data), formatP, arg);
   va_end(arg);
 
   AddLog(loglevel);
+#endif  // USE_LOG_BINARY
 }
 
 void AddLog_Debug(PGM_P formatP, ...)
 {
+  if (LOG_LEVEL_DEBUG > log_level_max) { return; }
+
   va_list arg;
   va_start(arg, formatP);
   vsnprintf_P(log_data, sizeof(log_data), formatP, arg);
@@ -2087,6 +2337,8 @@ void AddLogBuffer(uint32_t loglevel, uint8_t *buffer, uint32_t count)
   ToHex_P(buffer, count, log_data + strlen(log_data), sizeof(log_data) - strlen(log_data), ' ');
   AddLog(loglevel);
 */
+  if (loglevel > log_level_max) { return; }
+
   char hex_char[(count * 3) + 2];
   AddLog_P2(loglevel, PSTR("DMP: %s"), ToHex_P(buffer, count, hex_char, sizeof(hex_char), ' '));
 }
@@ -2102,6 +2354,8 @@ void AddLogMissed(const char *sensor, uint32_t misses)
 }
 
 void AddLogBufferSize(uint32_t loglevel, uint8_t *buffer, uint32_t count, uint32_t size) {
+  if (loglevel > log_level_max) { return; }
+
   snprintf_P(log_data, sizeof(log_data), PSTR("DMP:"));
   for (uint32_t i = 0; i < count; i++) {
     if (1 ==  size) {  // uint8_t
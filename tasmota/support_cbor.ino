@@ -0,0 +1,600 @@
+/*
+  support_cbor.ino - CBOR encoding support for Tasmota
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef USE_MQTT_CBOR
+/*********************************************************************************************\
+ * CBOR (RFC7049) encoding of MQTT payloads
+ *
+ * Drivers keep building JSON in mqtt_data. Payloads of topics enabled with command MqttCbor are
+ * transcoded on the wire by a character driven scanner which can be fed in parts as done by the
+ * streaming publish. Objects and arrays are sent with indefinite length, numbers as integer or
+ * float and strings longer than the token buffer as chunked text strings.
+ *
+ * Inbound payloads starting with a CBOR map or array are decoded to JSON before being handed to
+ * the command handler and rules. Such a first byte can not start a UTF-8 text payload.
+\*********************************************************************************************/
+
+#include <float.h>
+
+#ifndef CBOR_TOKEN_SIZE
+#define CBOR_TOKEN_SIZE            64         // Max length of a number or literal and text string chunk size
+#endif
+#ifndef CBOR_MAX_DEPTH
+#define CBOR_MAX_DEPTH             8          // Max nesting of inbound maps and arrays
+#endif
+
+enum CborMajorTypes { CBOR_UINT, CBOR_NINT, CBOR_BYTES, CBOR_TEXT, CBOR_ARRAY, CBOR_MAP, CBOR_TAG, CBOR_SIMPLE };
+enum CborOutputs { CBOR_OUT_BUFFER, CBOR_OUT_COUNT, CBOR_OUT_MQTT };
+enum CborScanStates { CBOR_SCAN_VALUE, CBOR_SCAN_STRING, CBOR_SCAN_ESCAPE, CBOR_SCAN_UNICODE, CBOR_SCAN_NUMBER, CBOR_SCAN_LITERAL };
+
+const uint8_t CBOR_INDEFINITE = 31;
+const uint8_t CBOR_BREAK = 0xFF;
+const uint8_t CBOR_FALSE = 0xF4;
+const uint8_t CBOR_TRUE = 0xF5;
+const uint8_t CBOR_NULL = 0xF6;
+const uint8_t CBOR_FLOAT32 = 0xFA;
+const uint8_t CBOR_FLOAT64 = 0xFB;
+
+struct CBOR {
+  uint8_t *out = nullptr;                     // Output buffer in CBOR_OUT_BUFFER mode
+  uint32_t size = 0;                          // Output buffer size
+  uint32_t length = 0;                        // Encoded length
+  uint16_t unicode = 0;                       // Code point of \uXXXX escape
+  uint8_t output = CBOR_OUT_COUNT;            // CborOutputs
+  uint8_t state = CBOR_SCAN_VALUE;            // CborScanStates
+  uint8_t token_len = 0;
+  uint8_t digits = 0;                         // Hex digits of \uXXXX escape read
+  bool chunked = false;                       // Text string sent as indefinite length chunks
+  bool error = false;
+  char token[CBOR_TOKEN_SIZE];                // Pending number, literal or text string chunk
+} Cbor;
+
+/*********************************************************************************************\
+ * Encoder
+\*********************************************************************************************/
+
+void CborWrite(const uint8_t* data, uint32_t len)
+{
+  switch (Cbor.output) {
+    case CBOR_OUT_BUFFER:
+      if (Cbor.length + len > Cbor.size) {
+        Cbor.error = true;
+      } else {
+        memcpy(Cbor.out + Cbor.length, data, len);
+      }
+      break;
+    case CBOR_OUT_MQTT:
+      MqttPublishWriteLib((const char*)data, len);
+      break;
+  }
+  Cbor.length += len;
+}
+
+void CborHead(uint32_t major, uint64_t value)
+{
+  // Write major type with value in the shortest form
+  uint8_t head[9];
+  uint32_t bytes = (value < 24) ? 0 : (value <= 0xFF) ? 1 : (value <= 0xFFFF) ? 2 : (value <= 0xFFFFFFFF) ? 4 : 8;
+  head[0] = (major << 5) | ((0 == bytes) ? value : (1 == bytes) ? 24 : (2 == bytes) ? 25 : (4 == bytes) ? 26 : 27);
+  for (uint32_t i = 0; i < bytes; i++) {
+    head[bytes - i] = value >> (i * 8);       // Big endian
+  }
+  CborWrite(head, bytes +1);
+}
+
+void CborIndefinite(uint32_t major)
+{
+  uint8_t head = (major << 5) | CBOR_INDEFINITE;
+  CborWrite(&head, 1);
+}
+
+void CborBegin(uint8_t* out, uint32_t size, uint32_t output)
+{
+  Cbor.out = out;
+  Cbor.size = size;
+  Cbor.output = output;
+  Cbor.length = 0;
+  Cbor.state = CBOR_SCAN_VALUE;
+  Cbor.token_len = 0;
+  Cbor.error = false;
+}
+
+void CborTextChunk(void)
+{
+  // Send the complete UTF-8 sequences of a full token buffer as text string chunk
+  uint32_t cut = Cbor.token_len;
+  uint32_t lead = cut;
+  while (lead && (0x80 == (Cbor.token[lead -1] & 0xC0))) { lead--; }
+  if (lead) {
+    uint8_t c = Cbor.token[lead -1];
+    uint32_t seq_len = (c < 0x80) ? 1 : (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : 2;
+    if (Cbor.token_len - (lead -1) < seq_len) { cut = lead -1; }  // Keep incomplete sequence
+  }
+  if (!Cbor.chunked) {
+    CborIndefinite(CBOR_TEXT);
+    Cbor.chunked = true;
+  }
+  CborHead(CBOR_TEXT, cut);
+  CborWrite((uint8_t*)Cbor.token, cut);
+  Cbor.token_len -= cut;
+  memmove(Cbor.token, Cbor.token + cut, Cbor.token_len);
+}
+
+void CborTextByte(uint8_t c)
+{
+  if (Cbor.token_len >= sizeof(Cbor.token)) { CborTextChunk(); }
+  Cbor.token[Cbor.token_len++] = c;
+}
+
+void CborTextCodePoint(uint32_t code)
+{
+  if ((code >= 0xD800) && (code <= 0xDFFF)) { code = 0xFFFD; }  // Surrogate pairs are not combined
+  if (code < 0x80) {
+    CborTextByte(code);
+  } else if (code < 0x800) {
+    CborTextByte(0xC0 | (code >> 6));
+    CborTextByte(0x80 | (code & 0x3F));
+  } else {
+    CborTextByte(0xE0 | (code >> 12));
+    CborTextByte(0x80 | ((code >> 6) & 0x3F));
+    CborTextByte(0x80 | (code & 0x3F));
+  }
+}
+
+void CborTextEnd(void)
+{
+  if (Cbor.chunked) {
+    if (Cbor.token_len) {
+      CborHead(CBOR_TEXT, Cbor.token_len);
+      CborWrite((uint8_t*)Cbor.token, Cbor.token_len);
+    }
+    uint8_t brk = CBOR_BREAK;
+    CborWrite(&brk, 1);
+  } else {
+    CborHead(CBOR_TEXT, Cbor.token_len);
+    CborWrite((uint8_t*)Cbor.token, Cbor.token_len);
+  }
+  Cbor.token_len = 0;
+}
+
+void CborNumberEnd(void)
+{
+  // Integers as major type 0 or 1, others as float32 if the text has up to six significant digits
+  // and the value is a normal float32, else as float64
+  Cbor.token[Cbor.token_len] = '\0';
+  Cbor.token_len = 0;
+  char* str = Cbor.token;
+  bool negative = ('-' == *str);
+  if (negative) { str++; }
+
+  uint64_t value = 0;
+  uint32_t digits = 0;
+  bool integer = true;
+  for (char* p = str; *p; p++) {
+    if (!isdigit(*p) || (++digits > 19)) {
+      integer = false;
+      break;
+    }
+    value = value * 10 + (*p - '0');
+  }
+  if (integer && digits) {
+    if (negative) {
+      if (value) { CborHead(CBOR_NINT, value -1); }
+      else { CborHead(CBOR_UINT, 0); }        // -0
+    } else {
+      CborHead(CBOR_UINT, value);
+    }
+    return;
+  }
+
+  char* end;
+  double number = strtod(Cbor.token, &end);
+  if (*end || (end == Cbor.token)) {
+    Cbor.error = true;
+    return;
+  }
+  uint32_t significant = 0;
+  bool leading = true;
+  for (char* p = str; *p && ('e' != *p) && ('E' != *p); p++) {
+    if (!isdigit(*p) || (leading && ('0' == *p))) { continue; }
+    leading = false;
+    significant++;
+  }
+  uint8_t data[9];
+  double magnitude = fabs(number);
+  if ((significant <= 6) && ((0 == magnitude) || ((magnitude >= FLT_MIN) && (magnitude <= FLT_MAX)))) {
+    float number32 = number;
+    uint32_t bits;
+    memcpy(&bits, &number32, sizeof(bits));
+    data[0] = CBOR_FLOAT32;
+    for (uint32_t i = 0; i < 4; i++) { data[4 - i] = bits >> (i * 8); }
+    CborWrite(data, 5);
+  } else {
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    data[0] = CBOR_FLOAT64;
+    for (uint32_t i = 0; i < 8; i++) { data[8 - i] = bits >> (i * 8); }
+    CborWrite(data, 9);
+  }
+}
+
+void CborLiteralEnd(void)
+{
+  Cbor.token[Cbor.token_len] = '\0';
+  Cbor.token_len = 0;
+  uint8_t simple;
+  if (!strcmp_P(Cbor.token, PSTR("true"))) { simple = CBOR_TRUE; }
+  else if (!strcmp_P(Cbor.token, PSTR("false"))) { simple = CBOR_FALSE; }
+  else if (!strcmp_P(Cbor.token, PSTR("null"))) { simple = CBOR_NULL; }
+  else {
+    Cbor.error = true;
+    return;
+  }
+  CborWrite(&simple, 1);
+}
+
+void CborPutChar(char c)
+{
+  switch (Cbor.state) {
+    case CBOR_SCAN_STRING:
+      if ('"' == c) {
+        CborTextEnd();
+        Cbor.state = CBOR_SCAN_VALUE;
+      } else if ('\\' == c) {
+        Cbor.state = CBOR_SCAN_ESCAPE;
+      } else {
+        CborTextByte(c);
+      }
+      return;
+    case CBOR_SCAN_ESCAPE:
+      Cbor.state = CBOR_SCAN_STRING;
+      switch (c) {
+        case 'b': CborTextByte('\b'); break;
+        case 'f': CborTextByte('\f'); break;
+        case 'n': CborTextByte('\n'); break;
+        case 'r': CborTextByte('\r'); break;
+        case 't': CborTextByte('\t'); break;
+        case 'u':
+          Cbor.unicode = 0;
+          Cbor.digits = 0;
+          Cbor.state = CBOR_SCAN_UNICODE;
+          break;
+        default: CborTextByte(c);             // " \ and /
+      }
+      return;
+    case CBOR_SCAN_UNICODE:
+      if (!isxdigit(c)) {
+        Cbor.error = true;
+        Cbor.state = CBOR_SCAN_STRING;
+        return;
+      }
+      Cbor.unicode = (Cbor.unicode << 4) | ((c <= '9') ? c - '0' : (c | 0x20) - 'a' + 10);
+      if (4 == ++Cbor.digits) {
+        CborTextCodePoint(Cbor.unicode);
+        Cbor.state = CBOR_SCAN_STRING;
+      }
+      return;
+    case CBOR_SCAN_NUMBER:
+      if (isdigit(c) || ('.' == c) || ('-' == c) || ('+' == c) || ('e' == c) || ('E' == c)) {
+        if (Cbor.token_len < sizeof(Cbor.token) -1) { Cbor.token[Cbor.token_len++] = c; }
+        else { Cbor.error = true; }
+        return;
+      }
+      CborNumberEnd();
+      break;
+    case CBOR_SCAN_LITERAL:
+      if (isalpha(c)) {
+        if (Cbor.token_len < sizeof(Cbor.token) -1) { Cbor.token[Cbor.token_len++] = c; }
+        else { Cbor.error = true; }
+        return;
+      }
+      CborLiteralEnd();
+      break;
+  }
+
+  Cbor.state = CBOR_SCAN_VALUE;
+  switch (c) {
+    case '{':
+      CborIndefinite(CBOR_MAP);
+      break;
+    case '[':
+      CborIndefinite(CBOR_ARRAY);
+      break;
+    case '}':
+    case ']': {
+      uint8_t brk = CBOR_BREAK;
+      CborWrite(&brk, 1);
+      break;
+    }
+    case '"':
+      Cbor.chunked = false;
+      Cbor.state = CBOR_SCAN_STRING;
+      break;
+    case ',':
+    case ':':
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      break;
+    default:
+      if (isdigit(c) || ('-' == c)) {
+        Cbor.state = CBOR_SCAN_NUMBER;
+      } else if (isalpha(c)) {
+        Cbor.state = CBOR_SCAN_LITERAL;
+      } else {
+        Cbor.error = true;
+        return;
+      }
+      Cbor.token[0] = c;
+      Cbor.token_len = 1;
+  }
+}
+
+void CborPut(const char* json, uint32_t len)
+{
+  for (uint32_t i = 0; (i < len) && !Cbor.error; i++) {
+    CborPutChar(json[i]);
+  }
+}
+
+bool CborEnd(void)
+{
+  // Returns true if the JSON text was complete and fitted in the output buffer
+  if (CBOR_SCAN_NUMBER == Cbor.state) { CborNumberEnd(); }
+  else if (CBOR_SCAN_LITERAL == Cbor.state) { CborLiteralEnd(); }
+  else if (CBOR_SCAN_VALUE != Cbor.state) { Cbor.error = true; }
+  Cbor.state = CBOR_SCAN_VALUE;
+  return !Cbor.error;
+}
+
+uint8_t* CborFromJson(const char* json, uint32_t *len)
+{
+  // Returns allocated CBOR of json with its length in len or nullptr on failure. Free after use
+  uint32_t size = *len + *len / 2 + 8;        // Short floats like 0.5 grow from 3 to 5 bytes
+  uint8_t* out = (uint8_t*)malloc(size);
+  if (!out) { return nullptr; }
+  CborBegin(out, size, CBOR_OUT_BUFFER);
+  CborPut(json, *len);
+  if (!CborEnd()) {
+    free(out);
+    return nullptr;
+  }
+  *len = Cbor.length;
+  return out;
+}
+
+/*********************************************************************************************\
+ * Decoder
+\*********************************************************************************************/
+
+struct CBOR_IN {
+  const uint8_t *data;
+  uint32_t len;
+  uint32_t pos;
+  char *out;                                  // nullptr to count only
+  uint32_t size;
+  uint32_t length;                            // JSON length
+  uint8_t info;                               // Additional information of last head
+} CborIn;
+
+void CborInAppend(const char* str, uint32_t len)
+{
+  if (CborIn.out) {
+    for (uint32_t i = 0; i < len; i++) {
+      if (CborIn.length + i < CborIn.size -1) { CborIn.out[CborIn.length + i] = str[i]; }
+    }
+  }
+  CborIn.length += len;
+}
+
+bool CborInHead(uint32_t *major, uint64_t *value, bool *indefinite)
+{
+  if (CborIn.pos >= CborIn.len) { return false; }
+  uint8_t head = CborIn.data[CborIn.pos++];
+  *major = head >> 5;
+  uint32_t info = head & 0x1F;
+  CborIn.info = info;
+  *indefinite = (CBOR_INDEFINITE == info);
+  *value = info;
+  if ((info < 24) || *indefinite) { return true; }
+  if (info > 27) { return false; }
+  uint32_t bytes = 1 << (info - 24);
+  if (CborIn.pos + bytes > CborIn.len) { return false; }
+  *value = 0;
+  for (uint32_t i = 0; i < bytes; i++) {
+    *value = (*value << 8) | CborIn.data[CborIn.pos++];
+  }
+  return true;
+}
+
+bool CborInBreak(void)
+{
+  if ((CborIn.pos < CborIn.len) && (CBOR_BREAK == CborIn.data[CborIn.pos])) {
+    CborIn.pos++;
+    return true;
+  }
+  return false;
+}
+
+void CborInNumber(uint64_t value, bool negative)
+{
+  char number[22];
+  char* p = number + sizeof(number);
+  if (negative) {
+    if (value == 0xFFFFFFFFFFFFFFFFULL) { value = 0; }  // Would overflow, report as -0
+    else { value++; }                         // -1 - value
+  }
+  do {
+    *--p = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+  if (negative) { *--p = '-'; }
+  CborInAppend(p, number + sizeof(number) - p);
+}
+
+void CborInFloat(double number, uint32_t precision)
+{
+  // Shortest decimal text reading back as the same float
+  char str[40];
+  if (isnan(number) || isinf(number) || (fabs(number) > 1e15)) {
+    dtostrfd(number, 0, str);
+  } else {
+    for (uint32_t decimals = 0; decimals <= precision; decimals++) {
+      dtostrfd(number, decimals, str);
+      double check = strtod(str, nullptr);
+      if ((precision < 10) ? ((float)check == (float)number) : (check == number)) { break; }
+    }
+  }
+  CborInAppend(str, strlen(str));
+}
+
+void CborInText(uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++) {
+    uint8_t c = CborIn.data[CborIn.pos++];
+    if (('"' == c) || ('\\' == c)) {
+      char escaped[2] = { '\\', (char)c };
+      CborInAppend(escaped, 2);
+    } else if (c < 0x20) {
+      char escaped[8];
+      snprintf_P(escaped, sizeof(escaped), PSTR("\\u%04X"), c);
+      CborInAppend(escaped, 6);
+    } else {
+      CborInAppend((char*)&c, 1);
+    }
+  }
+}
+
+void CborInBytes(uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++) {
+    char hex[3];
+    snprintf_P(hex, sizeof(hex), PSTR("%02X"), CborIn.data[CborIn.pos++]);
+    CborInAppend(hex, 2);
+  }
+}
+
+bool CborInItem(uint32_t depth, bool key)
+{
+  // Decode one item as JSON. Map keys need to be strings
+  uint32_t major;
+  uint64_t value;
+  bool indefinite;
+  if (!CborInHead(&major, &value, &indefinite)) { return false; }
+  while (CBOR_TAG == major) {                 // Tags are ignored
+    if (!CborInHead(&major, &value, &indefinite)) { return false; }
+  }
+  if (key && (major != CBOR_TEXT) && (major != CBOR_BYTES)) { return false; }
+
+  switch (major) {
+    case CBOR_UINT:
+    case CBOR_NINT:
+      if (indefinite) { return false; }
+      CborInNumber(value, (CBOR_NINT == major));
+      return true;
+    case CBOR_BYTES:
+    case CBOR_TEXT:
+      CborInAppend("\"", 1);
+      if (indefinite) {
+        while (!CborInBreak()) {
+          uint32_t chunk_major;
+          bool chunk_indefinite;
+          if (!CborInHead(&chunk_major, &value, &chunk_indefinite) || (chunk_major != major) || chunk_indefinite) { return false; }
+          if (value > CborIn.len - CborIn.pos) { return false; }
+          if (CBOR_TEXT == major) { CborInText(value); } else { CborInBytes(value); }
+        }
+      } else {
+        if (value > CborIn.len - CborIn.pos) { return false; }
+        if (CBOR_TEXT == major) { CborInText(value); } else { CborInBytes(value); }
+      }
+      CborInAppend("\"", 1);
+      return true;
+    case CBOR_ARRAY:
+    case CBOR_MAP: {
+      if (depth >= CBOR_MAX_DEPTH) { return false; }
+      bool map = (CBOR_MAP == major);
+      CborInAppend((map) ? "{" : "[", 1);
+      for (uint32_t i = 0; indefinite || (i < value); i++) {
+        if (indefinite && CborInBreak()) { break; }
+        if (i) { CborInAppend(",", 1); }
+        if (map) {
+          if (!CborInItem(depth +1, true)) { return false; }
+          CborInAppend(":", 1);
+        }
+        if (!CborInItem(depth +1, false)) { return false; }
+      }
+      CborInAppend((map) ? "}" : "]", 1);
+      return true;
+    }
+    case CBOR_SIMPLE:
+      switch (CborIn.info) {
+        case 20: CborInAppend("false", 5); return true;
+        case 21: CborInAppend("true", 4); return true;
+        case 22:
+        case 23: CborInAppend("null", 4); return true;
+        case 25: {                            // Half precision
+          uint32_t half = value;
+          uint32_t exponent = (half >> 10) & 0x1F;
+          double mantissa = half & 0x3FF;
+          double number = (0 == exponent) ? ldexp(mantissa, -24) : (31 == exponent) ? ((mantissa) ? NAN : INFINITY) : ldexp(mantissa + 1024, exponent - 25);
+          CborInFloat((half & 0x8000) ? -number : number, 4);
+          return true;
+        }
+        case 26: {
+          uint32_t bits = value;
+          float number;
+          memcpy(&number, &bits, sizeof(number));
+          CborInFloat(number, 7);
+          return true;
+        }
+        case 27: {
+          double number;
+          memcpy(&number, &value, sizeof(number));
+          CborInFloat(number, 15);
+          return true;
+        }
+      }
+  }
+  return false;
+}
+
+bool CborIsPayload(const uint8_t* data, uint32_t len)
+{
+  // A CBOR map or array can not be the first byte of a UTF-8 text
+  return (len > 0) && (data[0] >= 0x80) && (data[0] <= 0xBF);
+}
+
+int32_t CborToJson(const uint8_t* data, uint32_t len, char* out, uint32_t size)
+{
+  // Returns the JSON length, like snprintf truncated to size, or -1 if data is no valid CBOR
+  CborIn.data = data;
+  CborIn.len = len;
+  CborIn.pos = 0;
+  CborIn.out = (size) ? out : nullptr;
+  CborIn.size = size;
+  CborIn.length = 0;
+  bool valid = CborInItem(0, false) && (CborIn.pos == len);
+  if (CborIn.out) {
+    CborIn.out[(CborIn.length < size) ? CborIn.length : size -1] = '\0';
+  }
+  return (valid) ? CborIn.length : -1;
+}
+
+#endif  // USE_MQTT_CBOR
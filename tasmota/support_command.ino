@@ -38,6 +38,12 @@ const char kTasmotaCommands[] PROGMEM = "|"  // No prefix
 #endif  // USE_DEVICE_GROUPS_SEND
   D_CMND_DEVGROUP_SHARE "|" D_CMND_DEVGROUPSTATUS "|"
 #endif  // USE_DEVICE_GROUPS
+#ifdef USE_PROFILE_DRIVER
+  D_CMND_PROFILE "|"
+#endif  // USE_PROFILE_DRIVER
+#ifdef USE_TELE_DELTA
+  D_CMND_TELEDELTA "|" D_CMND_TELECOALESCE "|" D_CMND_TELEDEADBAND "|"
+#endif  // USE_TELE_DELTA
   D_CMND_SENSOR "|" D_CMND_DRIVER
 #ifdef ESP32
    "|" D_CMND_TOUCH_CAL "|" D_CMND_TOUCH_THRES "|" D_CMND_TOUCH_NUM "|" D_CMND_CPU_FREQUENCY
@@ -65,6 +71,12 @@ void (* const TasmotaCommand[])(void) PROGMEM = {
 #endif  // USE_DEVICE_GROUPS_SEND
   &CmndDevGroupShare, &CmndDevGroupStatus,
 #endif  // USE_DEVICE_GROUPS
+#ifdef USE_PROFILE_DRIVER
+  &CmndProfile,
+#endif  // USE_PROFILE_DRIVER
+#ifdef USE_TELE_DELTA
+  &CmndTeleDelta, &CmndTeleCoalesce, &CmndTeleDeadband,
+#endif  // USE_TELE_DELTA
   &CmndSensor, &CmndDriver
 #ifdef ESP32
   ,&CmndTouchCal, &CmndTouchThres, &CmndTouchNum, &CmndCpuFrequency
@@ -187,16 +199,7 @@ void CommandHandler(char* topicBuf, char* dataBuf, uint32_t data_len)
     data_len--;
   }
 
-  bool grpflg = false;
-  uint32_t real_index = SET_MQTT_GRP_TOPIC;
-  for (uint32_t i = 0; i < MAX_GROUP_TOPICS; i++) {
-    if (1 == i) { real_index = SET_MQTT_GRP_TOPIC2 -1; }
-    char *group_topic = SettingsText(real_index +i);
-    if (*group_topic && strstr(topicBuf, group_topic) != nullptr) {
-      grpflg = true;
-      break;
-    }
-  }
+  bool grpflg = MqttTopicGroupMatch(topicBuf);  // Resolved by MqttDataHandler
 
   char stemp1[TOPSZ];
   GetFallbackTopic_P(stemp1, "");  // Full Fallback topic = cmnd/DVES_xxxxxxxx_fb/
@@ -208,23 +211,20 @@ void CommandHandler(char* topicBuf, char* dataBuf, uint32_t data_len)
   bool user_index = false;
   if (type != nullptr) {
     type++;
-    uint32_t i;
-    int nLen; // strlen(type)
-    char *s = type;
-    for (nLen = 0; *s; s++, nLen++) {
-      *s=toupper(*s);
-    }
-    i = nLen;
-    if (i > 0) { // may be 0
-      while (isdigit(type[i-1])) {
-        i--;
+    char *digits = nullptr;              // Start of trailing index digits
+    for (char *s = type; *s; s++) {      // Upper case and find index in one pass
+      *s = toupper(*s);
+      if (!isdigit(*s)) {
+        digits = nullptr;
+      } else if (!digits) {
+        digits = s;
       }
     }
-    if (i < nLen) {
-      index = atoi(type + i);
+    if (digits) {
+      index = atoi(digits);
       user_index = true;
+      *digits = '\0';
     }
-    type[i] = '\0';
   }
 
   AddLog_P2(LOG_LEVEL_DEBUG, PSTR("CMD: " D_GROUP " %d, " D_INDEX " %d, " D_COMMAND " \"%s\", " D_DATA " \"%s\""), grpflg, index, type, dataBuf);
@@ -305,22 +305,98 @@ void CommandHandler(char* topicBuf, char* dataBuf, uint32_t data_len)
   fallback_topic_flag = false;
 }
 
-/********************************************************************************************/
+/*********************************************************************************************\
+ * Command backlog
+ *
+ * Fixed size ring buffer of commands each preceded by a two byte length. Commands are appended
+ * by Backlog and inserted in front by rules IF blocks. No heap is used.
+\*********************************************************************************************/
+
+void BacklogCopy(uint32_t position, char* data, uint32_t len, bool write)
+{
+  position %= BACKLOG_SIZE;
+  while (len) {
+    uint32_t chunk = tmin(len, BACKLOG_SIZE - position);
+    if (write) {
+      memcpy(Backlog.buffer + position, data, chunk);
+    } else {
+      memcpy(data, Backlog.buffer + position, chunk);
+    }
+    data += chunk;
+    len -= chunk;
+    position = 0;
+  }
+}
+
+bool BacklogStore(const char* command, bool front)
+{
+  uint16_t len = strlen(command);
+  uint32_t size = len + sizeof(len);
+  if ((Backlog.count >= MAX_BACKLOG) || (Backlog.used + size > BACKLOG_SIZE)) {
+    AddLog_P2(LOG_LEVEL_INFO, PSTR("CMD: Backlog full, dropped \"%s\""), command);
+    return false;
+  }
+  uint32_t position;
+  if (front) {
+    Backlog.head = (Backlog.head + BACKLOG_SIZE - size) % BACKLOG_SIZE;
+    position = Backlog.head;
+  } else {
+    position = Backlog.head + Backlog.used;
+  }
+  BacklogCopy(position, (char*)&len, sizeof(len), true);
+  BacklogCopy(position + sizeof(len), (char*)command, len, true);
+  Backlog.used += size;
+  Backlog.count++;
+  if (Backlog.used > Backlog.high_water) { Backlog.high_water = Backlog.used; }
+  return true;
+}
+
+bool BacklogAdd(const char* command)
+{
+  return BacklogStore(command, false);
+}
+
+bool BacklogInsert(const char* command)
+{
+  return BacklogStore(command, true);
+}
+
+uint32_t BacklogNextLength(void)
+{
+  uint16_t len = 0;
+  if (Backlog.count) {
+    BacklogCopy(Backlog.head, (char*)&len, sizeof(len), false);
+  }
+  return len;
+}
+
+void BacklogNext(char* command, uint32_t size)
+{
+  // Remove first command from backlog. Size needs to be at least BacklogNextLength() +1
+  *command = '\0';
+  if (!Backlog.count) { return; }
+  uint16_t len = BacklogNextLength();
+  if (len < size) {
+    BacklogCopy(Backlog.head + sizeof(len), command, len, false);
+    command[len] = '\0';
+  }
+  Backlog.head = (Backlog.head + len + sizeof(len)) % BACKLOG_SIZE;
+  Backlog.used -= len + sizeof(len);
+  Backlog.count--;
+}
+
+void BacklogClear(void)
+{
+  Backlog.head = 0;
+  Backlog.used = 0;
+  Backlog.count = 0;
+}
 
 void CmndBacklog(void)
 {
   if (XdrvMailbox.data_len) {
-
-#ifdef SUPPORT_IF_STATEMENT
-    char *blcommand = strtok(XdrvMailbox.data, ";");
-    while ((blcommand != nullptr) && (backlog.size() < MAX_BACKLOG))
-#else
-    uint32_t bl_pointer = (!backlog_pointer) ? MAX_BACKLOG -1 : backlog_pointer;
-    bl_pointer--;
     char *blcommand = strtok(XdrvMailbox.data, ";");
-    while ((blcommand != nullptr) && (backlog_index != bl_pointer))
-#endif
-    {
+    while (blcommand != nullptr) {
       while(true) {
         blcommand = Trim(blcommand);
         if (!strncasecmp_P(blcommand, PSTR(D_CMND_BACKLOG), strlen(D_CMND_BACKLOG))) {
@@ -330,15 +406,7 @@ void CmndBacklog(void)
         }
       }
       if (*blcommand != '\0') {
-#ifdef SUPPORT_IF_STATEMENT
-        if (backlog.size() < MAX_BACKLOG) {
-          backlog.add(blcommand);
-        }
-#else
-        backlog[backlog_index] = blcommand;
-        backlog_index++;
-        if (backlog_index >= MAX_BACKLOG) backlog_index = 0;
-#endif
+        if (!BacklogAdd(blcommand)) { break; }
       }
       blcommand = strtok(nullptr, ";");
     }
@@ -347,11 +415,7 @@ void CmndBacklog(void)
     backlog_delay = 0;
   } else {
     bool blflag = BACKLOG_EMPTY;
-#ifdef SUPPORT_IF_STATEMENT
-    backlog.clear();
-#else
-    backlog_pointer = backlog_index;
-#endif
+    BacklogClear();
     ResponseCmndChar(blflag ? D_JSON_EMPTY : D_JSON_ABORTED);
   }
 }
@@ -500,6 +564,7 @@ void CmndStatus(void)
 #endif
                           , ESP.getFlashChipSpeed()/1000000, ESP.getFlashChipMode(),
                           LANGUAGE_LCID, feature_drv1, feature_drv2, feature_sns1, feature_sns2, feature5, feature6, feature7);
+    ResponseAppend_P(PSTR(",\"" D_CMND_BACKLOG "\":{\"Size\":%d,\"Used\":%d,\"Max\":%d}"), BACKLOG_SIZE, Backlog.used, Backlog.high_water);
     XsnsDriverState();
     ResponseAppend_P(PSTR(",\"Sensors\":"));
     XsnsSensorState();
@@ -519,9 +584,11 @@ void CmndStatus(void)
 
   if (((0 == payload) || (6 == payload)) && Settings.flag.mqtt_enabled) {  // SetOption3 - Enable MQTT
     Response_P(PSTR("{\"" D_CMND_STATUS D_STATUS6_MQTT "\":{\"" D_CMND_MQTTHOST "\":\"%s\",\"" D_CMND_MQTTPORT "\":%d,\"" D_CMND_MQTTCLIENT D_JSON_MASK "\":\"%s\",\""
-                          D_CMND_MQTTCLIENT "\":\"%s\",\"" D_CMND_MQTTUSER "\":\"%s\",\"" D_JSON_MQTT_COUNT "\":%d,\"MAX_PACKET_SIZE\":%d,\"KEEPALIVE\":%d}}"),
+                          D_CMND_MQTTCLIENT "\":\"%s\",\"" D_CMND_MQTTUSER "\":\"%s\",\"" D_JSON_MQTT_COUNT "\":%d,\"MAX_PACKET_SIZE\":%d,\"KEEPALIVE\":%d"),
                           SettingsText(SET_MQTT_HOST), Settings.mqtt_port, EscapeJSONString(SettingsText(SET_MQTT_CLIENT)).c_str(),
                           mqtt_client, EscapeJSONString(SettingsText(SET_MQTT_USER)).c_str(), MqttConnectCount(), MQTT_MAX_PACKET_SIZE, MQTT_KEEPALIVE);
+    MqttShowConnectTimes();
+    ResponseJsonEndEnd();
     MqttPublishPrefixTopic_P(STAT, PSTR(D_CMND_STATUS "6"));
   }
 
@@ -558,13 +625,14 @@ void CmndStatus(void)
 #endif  // USE_ENERGY_MARGIN_DETECTION
 
   if ((0 == payload) || (8 == payload) || (10 == payload)) {
+    MqttStreamBegin();
     Response_P(PSTR("{\"" D_CMND_STATUS D_STATUS10_SENSOR "\":"));
     MqttShowSensor();
     ResponseJsonEnd();
     if (8 == payload) {
-      MqttPublishPrefixTopic_P(STAT, PSTR(D_CMND_STATUS "8"));
+      MqttPublishPrefixTopicStream_P(STAT, PSTR(D_CMND_STATUS "8"), false);
     } else {
-      MqttPublishPrefixTopic_P(STAT, PSTR(D_CMND_STATUS "10"));
+      MqttPublishPrefixTopicStream_P(STAT, PSTR(D_CMND_STATUS "10"), false);
     }
   }
 
@@ -1962,6 +2030,7 @@ void CmndI2cScan(void)
 {
   if (i2c_flg) {
     I2cScan(mqtt_data, sizeof(mqtt_data));
+    ResponseReset();
   }
 }
 
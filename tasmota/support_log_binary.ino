@@ -0,0 +1,349 @@
+/*
+  support_log_binary.ino - deferred log formatting support for Tasmota
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef USE_LOG_BINARY
+/*********************************************************************************************\
+ * Deferred log formatting
+ *
+ * AddLog_P2 stores the log level, the PROGMEM format pointer and the raw arguments in a byte
+ * ring. The ring is drained from loop() where each message is formatted into log_data and
+ * passed to the log sinks. Text already formatted by other AddLog functions is stored as is to
+ * keep the message order.
+ *
+ * Record: [uint16_t size][uint8_t loglevel][PGM_P format][arguments]
+ * A nullptr format marks a text record. Strings are copied into the record as they may not
+ * live until the record is drained. Conversions not supported (%n, %L..) stop argument capture
+ * and are output verbatim with the remaining format text.
+\*********************************************************************************************/
+
+#ifndef LOG_BINARY_SIZE
+#define LOG_BINARY_SIZE            2048       // Size of log record ring in bytes
+#endif
+
+const uint32_t LOG_BINARY_SPEC = 24;          // Max length of a single conversion specification
+const uint32_t LOG_BINARY_HEADER = sizeof(uint16_t) + sizeof(uint8_t) + sizeof(PGM_P);
+
+enum LogBinaryArgTypes { LBA_UNSUPPORTED, LBA_PERCENT, LBA_INT, LBA_LONG, LBA_LONGLONG, LBA_DOUBLE, LBA_STRING, LBA_POINTER };
+
+struct LOGBINARY {
+  uint8_t buffer[LOG_BINARY_SIZE];
+  uint16_t head = 0;                          // Offset of oldest record
+  uint16_t used = 0;                          // Bytes in use
+  uint16_t high_water = 0;                    // Max bytes in use
+  uint32_t dropped = 0;                       // Messages lost due to a full ring
+} LogBinary;
+
+void LogBinaryWrite(const uint8_t* data, uint32_t len)
+{
+  uint32_t tail = (LogBinary.head + LogBinary.used) % LOG_BINARY_SIZE;
+  uint32_t first = LOG_BINARY_SIZE - tail;
+  if (first > len) { first = len; }
+  memcpy(LogBinary.buffer + tail, data, first);
+  memcpy(LogBinary.buffer, data + first, len - first);
+  LogBinary.used += len;
+  if (LogBinary.used > LogBinary.high_water) { LogBinary.high_water = LogBinary.used; }
+}
+
+void LogBinaryRead(uint8_t* data, uint32_t len)
+{
+  uint32_t first = LOG_BINARY_SIZE - LogBinary.head;
+  if (first > len) { first = len; }
+  memcpy(data, LogBinary.buffer + LogBinary.head, first);
+  memcpy(data + first, LogBinary.buffer, len - first);
+  LogBinary.head = (LogBinary.head + len) % LOG_BINARY_SIZE;
+  LogBinary.used -= len;
+}
+
+void LogBinaryStore(uint8_t* record, uint32_t size)
+{
+  // Record header size and loglevel are already set up by the caller
+  if (size > (uint32_t)(LOG_BINARY_SIZE - LogBinary.used)) {
+    LogBinary.dropped++;
+    return;
+  }
+  uint16_t rsize = size;
+  memcpy(record, &rsize, sizeof(rsize));
+  LogBinaryWrite(record, size);
+}
+
+uint32_t LogBinarySpec(PGM_P formatP, uint32_t index, char* spec, uint32_t* stars, uint32_t* type)
+{
+  // Parse conversion specification starting at the '%' on index. Returns index after specification
+  uint32_t len = 0;
+  uint32_t longs = 0;
+  spec[len++] = pgm_read_byte(formatP + index++);
+  *stars = 0;
+  *type = LBA_UNSUPPORTED;
+
+  char c;
+  while ((c = pgm_read_byte(formatP + index)) && (len < LOG_BINARY_SPEC -1)) {
+    index++;
+    spec[len++] = c;
+    if (strchr("-+ #0123456789.", c)) { continue; }
+    if ('*' == c) {
+      (*stars)++;
+      continue;
+    }
+    if ('h' == c) { continue; }
+    if ('l' == c) {
+      longs++;
+      continue;
+    }
+    if (('z' == c) || ('t' == c)) {
+      longs = (sizeof(size_t) > sizeof(long)) ? 2 : (sizeof(size_t) > sizeof(int)) ? 1 : 0;
+      continue;
+    }
+    if ('j' == c) {
+      longs = 2;
+      continue;
+    }
+    switch (c) {
+      case '%':
+        *type = LBA_PERCENT;
+        break;
+      case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+        *type = (longs > 1) ? LBA_LONGLONG : (longs) ? LBA_LONG : LBA_INT;
+        break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        *type = LBA_DOUBLE;
+        break;
+      case 's':
+        *type = LBA_STRING;
+        break;
+      case 'p':
+        *type = LBA_POINTER;
+        break;
+    }
+    break;
+  }
+  spec[len] = '\0';
+  if (*stars > 2) { *type = LBA_UNSUPPORTED; }
+  return index;
+}
+
+void LogBinaryAdd(uint32_t loglevel, PGM_P formatP, va_list arg)
+{
+  uint8_t record[LOGSZ];
+  uint32_t len = LOG_BINARY_HEADER;
+  record[sizeof(uint16_t)] = loglevel;
+  memcpy(record + sizeof(uint16_t) + sizeof(uint8_t), &formatP, sizeof(PGM_P));
+
+  char spec[LOG_BINARY_SPEC];
+  uint32_t stars;
+  uint32_t type;
+  uint32_t index = 0;
+  char c;
+  while ((c = pgm_read_byte(formatP + index))) {
+    if (c != '%') {
+      index++;
+      continue;
+    }
+    index = LogBinarySpec(formatP, index, spec, &stars, &type);
+    if (LBA_UNSUPPORTED == type) { break; }
+    if (LBA_PERCENT == type) { continue; }
+    uint32_t needed = (stars * sizeof(int)) + ((LBA_LONGLONG == type) ? sizeof(long long) : (LBA_DOUBLE == type) ? sizeof(double) : sizeof(void*));
+    if (len + needed > sizeof(record)) {
+      LogBinary.dropped++;
+      return;
+    }
+    for (uint32_t i = 0; i < stars; i++) {
+      int value = va_arg(arg, int);
+      memcpy(record + len, &value, sizeof(value));
+      len += sizeof(value);
+    }
+    switch (type) {
+      case LBA_INT: {
+        int value = va_arg(arg, int);
+        memcpy(record + len, &value, sizeof(value));
+        len += sizeof(value);
+        break;
+      }
+      case LBA_LONG: {
+        long value = va_arg(arg, long);
+        memcpy(record + len, &value, sizeof(value));
+        len += sizeof(value);
+        break;
+      }
+      case LBA_LONGLONG: {
+        long long value = va_arg(arg, long long);
+        memcpy(record + len, &value, sizeof(value));
+        len += sizeof(value);
+        break;
+      }
+      case LBA_DOUBLE: {
+        double value = va_arg(arg, double);
+        memcpy(record + len, &value, sizeof(value));
+        len += sizeof(value);
+        break;
+      }
+      case LBA_POINTER: {
+        void* value = va_arg(arg, void*);
+        memcpy(record + len, &value, sizeof(value));
+        len += sizeof(value);
+        break;
+      }
+      case LBA_STRING: {
+        const char* value = va_arg(arg, const char*);
+        if (!value) { value = PSTR("(null)"); }
+        uint32_t slen = strlen_P(value);      // Some drivers pass PROGMEM strings
+        if (len + slen +1 > sizeof(record)) { slen = sizeof(record) - len -1; }
+        memcpy_P(record + len, value, slen);
+        len += slen;
+        record[len++] = '\0';
+        break;
+      }
+    }
+  }
+  LogBinaryStore(record, len);
+}
+
+void LogBinaryAddText(uint32_t loglevel, const char* text)
+{
+  uint8_t record[LOGSZ];
+  PGM_P formatP = nullptr;
+  record[sizeof(uint16_t)] = loglevel;
+  memcpy(record + sizeof(uint16_t) + sizeof(uint8_t), &formatP, sizeof(PGM_P));
+  uint32_t slen = strlen(text);
+  if (LOG_BINARY_HEADER + slen +1 > sizeof(record)) { slen = sizeof(record) - LOG_BINARY_HEADER -1; }
+  memcpy(record + LOG_BINARY_HEADER, text, slen);
+  record[LOG_BINARY_HEADER + slen] = '\0';
+  LogBinaryStore(record, LOG_BINARY_HEADER + slen +1);
+}
+
+void LogBinaryRender(PGM_P formatP, const uint8_t* args)
+{
+  // Format record arguments into log_data
+  uint32_t pos = 0;
+  const uint32_t max_pos = sizeof(log_data) -1;
+  char spec[LOG_BINARY_SPEC];
+  char format[LOG_BINARY_SPEC + 22];          // Specification with stars replaced by their value
+  uint32_t stars;
+  uint32_t type;
+  uint32_t index = 0;
+  bool verbatim = false;
+  char c;
+  while ((c = pgm_read_byte(formatP + index)) && (pos < max_pos)) {
+    if (verbatim || (c != '%')) {
+      log_data[pos++] = c;
+      index++;
+      continue;
+    }
+    index = LogBinarySpec(formatP, index, spec, &stars, &type);
+    if (LBA_UNSUPPORTED == type) {
+      verbatim = true;
+    }
+    if ((LBA_UNSUPPORTED == type) || (LBA_PERCENT == type)) {
+      int written = snprintf(log_data + pos, max_pos - pos +1, "%s", (LBA_PERCENT == type) ? "%" : spec);
+      pos += (written > 0) ? written : 0;
+      if (pos > max_pos) { pos = max_pos; }
+      continue;
+    }
+
+    uint32_t flen = 0;
+    for (uint32_t i = 0; spec[i]; i++) {
+      if ('*' == spec[i]) {
+        int value;
+        memcpy(&value, args, sizeof(value));
+        args += sizeof(value);
+        flen += snprintf(format + flen, sizeof(format) - flen, "%d", value);
+      } else {
+        format[flen++] = spec[i];
+      }
+    }
+    format[flen] = '\0';
+
+    char* out = log_data + pos;
+    uint32_t size = max_pos - pos +1;
+    int written = 0;
+    switch (type) {
+      case LBA_INT: {
+        int value;
+        memcpy(&value, args, sizeof(value));
+        args += sizeof(value);
+        written = snprintf(out, size, format, value);
+        break;
+      }
+      case LBA_LONG: {
+        long value;
+        memcpy(&value, args, sizeof(value));
+        args += sizeof(value);
+        written = snprintf(out, size, format, value);
+        break;
+      }
+      case LBA_LONGLONG: {
+        long long value;
+        memcpy(&value, args, sizeof(value));
+        args += sizeof(value);
+        written = snprintf(out, size, format, value);
+        break;
+      }
+      case LBA_DOUBLE: {
+        double value;
+        memcpy(&value, args, sizeof(value));
+        args += sizeof(value);
+        written = snprintf(out, size, format, value);
+        break;
+      }
+      case LBA_POINTER: {
+        void* value;
+        memcpy(&value, args, sizeof(value));
+        args += sizeof(value);
+        written = snprintf(out, size, format, value);
+        break;
+      }
+      case LBA_STRING: {
+        const char* value = (const char*)args;
+        args += strlen(value) +1;
+        written = snprintf(out, size, format, value);
+        break;
+      }
+    }
+    pos += (written > 0) ? written : 0;
+    if (pos > max_pos) { pos = max_pos; }
+  }
+  log_data[pos] = '\0';
+}
+
+void LogBinaryLoop(void)
+{
+  uint8_t record[LOGSZ];
+  while (LogBinary.used) {
+    uint16_t size;
+    LogBinaryRead((uint8_t*)&size, sizeof(size));
+    LogBinaryRead(record, size - sizeof(size));   // Free the record before sinks may log again
+
+    uint32_t loglevel = record[0];
+    PGM_P formatP;
+    memcpy(&formatP, record + sizeof(uint8_t), sizeof(PGM_P));
+    const uint8_t* args = record + sizeof(uint8_t) + sizeof(PGM_P);
+    if (formatP) {
+      LogBinaryRender(formatP, args);
+    } else {
+      strlcpy(log_data, (const char*)args, sizeof(log_data));
+    }
+    AddLogToSinks(loglevel);
+  }
+  if (LogBinary.dropped) {
+    snprintf_P(log_data, sizeof(log_data), PSTR(D_LOG_APPLICATION "%u log messages dropped"), LogBinary.dropped);
+    LogBinary.dropped = 0;
+    AddLogToSinks(LOG_LEVEL_INFO);
+  }
+}
+
+#endif  // USE_LOG_BINARY
@@ -0,0 +1,182 @@
+/*
+  support_profiling.ino - driver dispatch profiling support for Tasmota
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef USE_PROFILE_DRIVER
+/*********************************************************************************************\
+ * Driver dispatch profiler
+ *
+ * Collects call count, total and max execution time in microseconds per driver and
+ * function for XdrvCall, XsnsCall, XlgtCall and XnrgCall.
+ * The slot table is only allocated when profiling is enabled.
+ *
+ * Profile           - Show scheduler lateness and worst drivers sorted by max execution time
+ * Profile 0         - Stop profiling keeping collected data
+ * Profile 1         - Start profiling
+ * Profile 2         - Reset collected data
+\*********************************************************************************************/
+
+#ifndef PROFILE_MAX_SLOTS
+#define PROFILE_MAX_SLOTS          64         // Number of driver/function combinations tracked
+#endif
+#ifndef PROFILE_THRESHOLD
+#define PROFILE_THRESHOLD          100000     // Log single calls taking longer than this many microseconds
+#endif
+
+const char kProfileInterfaces[] PROGMEM = "Drv|Sns|Lgt|Nrg";
+
+typedef struct {
+  uint32_t key;                               // 0 = free, else 0x01 << 24 | interface << 16 | index << 8 | function
+  uint32_t count;
+  uint32_t total_us;
+  uint32_t max_us;
+} ProfileSlot;
+
+struct PROFILE {
+  ProfileSlot *slots = nullptr;
+  uint32_t lost = 0;                          // Calls not recorded due to full slot table
+  bool enabled = false;
+} Profile;
+
+uint32_t ProfileStart(void)
+{
+  return (Profile.enabled) ? micros() : 0;
+}
+
+void ProfileDriver(uint32_t interface, uint32_t index, uint32_t function, uint32_t start)
+{
+  if (!Profile.enabled) { return; }
+
+  uint32_t duration = micros() - start;
+  uint32_t key = 0x01000000 | (interface << 16) | ((index & 0xFF) << 8) | (function & 0xFF);
+  uint32_t slot = (key * 2654435761) % PROFILE_MAX_SLOTS;   // Knuth multiplicative hash
+  for (uint32_t i = 0; i < PROFILE_MAX_SLOTS; i++) {
+    ProfileSlot *entry = &Profile.slots[slot];
+    if (0 == entry->key) {
+      entry->key = key;
+    }
+    if (key == entry->key) {
+      entry->count++;
+      entry->total_us += duration;
+      if (duration > entry->max_us) { entry->max_us = duration; }
+      if (duration > PROFILE_THRESHOLD) {
+        char stemp[4];
+        AddLog_P2(LOG_LEVEL_DEBUG, PSTR("PRF: %s%02d function %d took %u uS"),
+          GetTextIndexed(stemp, sizeof(stemp), interface, kProfileInterfaces), ProfileDriverId(interface, index), function, duration);
+      }
+      return;
+    }
+    slot++;
+    if (slot >= PROFILE_MAX_SLOTS) { slot = 0; }
+  }
+  Profile.lost++;
+}
+
+uint32_t ProfileDriverId(uint32_t interface, uint32_t index)
+{
+  switch (interface) {
+    case PRF_XDRV:
+      return XdrvDriverId(index);
+    case PRF_XSNS:
+      return XsnsDriverId(index);
+  }
+  return index;                               // Light and energy drivers are reported by table index
+}
+
+void ProfileReset(void)
+{
+  if (Profile.slots) {
+    memset(Profile.slots, 0, PROFILE_MAX_SLOTS * sizeof(ProfileSlot));
+  }
+  Profile.lost = 0;
+  SchedulerResetStats();
+}
+
+void ProfileEnable(bool state)
+{
+  if (state && !Profile.slots) {
+    Profile.slots = (ProfileSlot*)calloc(PROFILE_MAX_SLOTS, sizeof(ProfileSlot));
+    if (!Profile.slots) { return; }           // Not enough memory
+  }
+  Profile.enabled = state;
+}
+
+void ProfileShow(void)
+{
+  uint32_t used = 0;
+  if (Profile.slots) {
+    for (uint32_t i = 0; i < PROFILE_MAX_SLOTS; i++) {
+      if (Profile.slots[i].key) { used++; }
+    }
+  }
+  Response_P(PSTR("{\"" D_CMND_PROFILE "\":{\"" D_JSON_STATUS "\":\"%s\",\"Slots\":%d,\"Lost\":%u,"),
+    GetStateText(Profile.enabled), used, Profile.lost);
+  SchedulerShow();
+  ResponseAppend_P(PSTR(",\"Top\":["));
+
+  // Selection by descending max execution time until the response buffer is full
+  uint32_t last_max = 0xFFFFFFFF;
+  uint32_t last_key = 0;
+  bool first = true;
+  while (Profile.slots) {
+    int32_t found = -1;
+    for (uint32_t i = 0; i < PROFILE_MAX_SLOTS; i++) {
+      ProfileSlot *entry = &Profile.slots[i];
+      if (!entry->key) { continue; }
+      if ((entry->max_us > last_max) || ((entry->max_us == last_max) && (entry->key >= last_key))) { continue; }
+      if ((found < 0) ||
+          (entry->max_us > Profile.slots[found].max_us) ||
+          ((entry->max_us == Profile.slots[found].max_us) && (entry->key > Profile.slots[found].key))) {
+        found = i;
+      }
+    }
+    if (found < 0) { break; }
+    ProfileSlot *entry = &Profile.slots[found];
+    last_max = entry->max_us;
+    last_key = entry->key;
+    if (ResponseLength() > sizeof(mqtt_data) - 80) { break; }  // Leave room for closing the JSON
+    uint32_t interface = (entry->key >> 16) & 0xFF;
+    uint32_t function = entry->key & 0xFF;
+    char stemp[4];
+    ResponseAppend_P(PSTR("%s{\"Id\":\"%s%02d\",\"Fn\":%d,\"Cnt\":%u,\"Tot\":%u,\"Max\":%u}"), (first) ? "" : ",",
+      GetTextIndexed(stemp, sizeof(stemp), interface, kProfileInterfaces), ProfileDriverId(interface, (entry->key >> 8) & 0xFF),
+      function, entry->count, entry->total_us, entry->max_us);
+    first = false;
+  }
+  ResponseAppend_P(PSTR("]}}"));
+}
+
+/*********************************************************************************************\
+ * Commands
+\*********************************************************************************************/
+
+void CmndProfile(void)
+{
+  switch (XdrvMailbox.payload) {
+    case 0:
+    case 1:
+      ProfileEnable(XdrvMailbox.payload);
+      break;
+    case 2:
+      ProfileReset();
+      break;
+  }
+  ProfileShow();
+}
+
+#endif  // USE_PROFILE_DRIVER
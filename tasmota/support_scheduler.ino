@@ -0,0 +1,133 @@
+/*
+  support_scheduler.ino - deadline scheduler support for Tasmota
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*********************************************************************************************\
+ * Deadline scheduler
+ *
+ * Periodic and one-shot timers executed from loop(). The main loop sleeps until the earliest
+ * deadline of a timer that may wake it, limited by the dynamic sleep time.
+ * Timers with an interval shorter than Sleep do not shorten the sleep and are served at the
+ * loop rate like before, keeping power use unchanged for large Sleep values.
+ *
+ * Example:
+ *   int32_t timer = SchedulerAdd(&MyDriverPoll, 200, 0);  // Call MyDriverPoll every 200 mS starting now
+ *   SchedulerAdd(&MyDriverTimeout, 0, 1500);              // Call MyDriverTimeout once in 1500 mS
+ *   SchedulerRemove(timer);
+\*********************************************************************************************/
+
+#ifndef MAX_SCHEDULER_TIMERS
+#define MAX_SCHEDULER_TIMERS       16         // Max number of concurrent timers
+#endif
+
+struct SCHEDULER {
+  struct {
+    void (*func)(void);                       // nullptr = free
+    uint32_t due;                             // Next deadline in millis()
+    uint32_t interval;                        // 0 = one-shot
+    uint32_t count;                           // Number of executions
+    uint32_t late_total;                      // Total lateness in mS
+    uint32_t late_max;                        // Max lateness in mS
+  } timer[MAX_SCHEDULER_TIMERS];
+} Scheduler;
+
+int32_t SchedulerAdd(void (*func)(void), uint32_t interval, uint32_t delay_ms)
+{
+  // Returns timer id or -1 if no free timer
+  for (uint32_t i = 0; i < MAX_SCHEDULER_TIMERS; i++) {
+    if (!Scheduler.timer[i].func) {
+      memset(&Scheduler.timer[i], 0, sizeof(Scheduler.timer[i]));
+      Scheduler.timer[i].due = millis() + delay_ms;
+      Scheduler.timer[i].interval = interval;
+      Scheduler.timer[i].func = func;
+      return i;
+    }
+  }
+  AddLog_P2(LOG_LEVEL_ERROR, PSTR("SCH: No free timer"));
+  return -1;
+}
+
+void SchedulerRemove(int32_t id)
+{
+  if ((id >= 0) && (id < MAX_SCHEDULER_TIMERS)) {
+    Scheduler.timer[id].func = nullptr;
+  }
+}
+
+void SchedulerLoop(void)
+{
+  for (uint32_t i = 0; i < MAX_SCHEDULER_TIMERS; i++) {
+    void (*func)(void) = Scheduler.timer[i].func;
+    if (!func || !TimeReached(Scheduler.timer[i].due)) { continue; }
+
+    uint32_t late = TimePassedSince(Scheduler.timer[i].due);
+    Scheduler.timer[i].count++;
+    Scheduler.timer[i].late_total += late;
+    if (late > Scheduler.timer[i].late_max) { Scheduler.timer[i].late_max = late; }
+
+    uint32_t interval = Scheduler.timer[i].interval;
+    if (interval) {
+      if (late < interval) {
+        Scheduler.timer[i].due += interval;           // Try to stay in sync
+      } else {
+        Scheduler.timer[i].due = millis() + interval; // No need to keep running behind, start again
+      }
+    } else {
+      Scheduler.timer[i].func = nullptr;              // One-shot done, allow re-use from within func
+    }
+    func();
+  }
+}
+
+uint32_t SchedulerSleep(uint32_t sleep_ms)
+{
+  // Returns sleep_ms limited by the earliest deadline of timers allowed to wake the loop
+  for (uint32_t i = 0; i < MAX_SCHEDULER_TIMERS; i++) {
+    if (!Scheduler.timer[i].func) { continue; }
+    uint32_t interval = Scheduler.timer[i].interval;
+    if (interval && (interval < ssleep)) { continue; }  // Served at loop rate
+    int32_t remaining = -TimePassedSince(Scheduler.timer[i].due);
+    if (remaining <= 0) { return 0; }
+    if ((uint32_t)remaining < sleep_ms) { sleep_ms = remaining; }
+  }
+  return sleep_ms;
+}
+
+void SchedulerResetStats(void)
+{
+  for (uint32_t i = 0; i < MAX_SCHEDULER_TIMERS; i++) {
+    Scheduler.timer[i].count = 0;
+    Scheduler.timer[i].late_total = 0;
+    Scheduler.timer[i].late_max = 0;
+  }
+}
+
+void SchedulerShow(void)
+{
+  // Append active timers as [Id,Interval,Count,AvgLate,MaxLate]
+  ResponseAppend_P(PSTR("\"Timers\":["));
+  bool first = true;
+  for (uint32_t i = 0; i < MAX_SCHEDULER_TIMERS; i++) {
+    if (!Scheduler.timer[i].func) { continue; }
+    uint32_t count = Scheduler.timer[i].count;
+    ResponseAppend_P(PSTR("%s[%d,%u,%u,%u,%u]"), (first) ? "" : ",", i, Scheduler.timer[i].interval, count,
+      (count) ? Scheduler.timer[i].late_total / count : 0, Scheduler.timer[i].late_max);
+    first = false;
+  }
+  ResponseAppend_P(PSTR("]"));
+}
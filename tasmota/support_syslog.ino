@@ -0,0 +1,226 @@
+/*
+  support_syslog.ino - batched syslog support for Tasmota
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*********************************************************************************************\
+ * Syslog
+ *
+ * Log lines are queued with their level and UTC time in a byte ring and sent by the scheduler
+ * every SYSLOG_INTERVAL mSeconds, up to SYSLOG_PACKET_SIZE bytes per interval. The queue is
+ * allocated while syslog is enabled.
+ *
+ * By default every line is sent in its own datagram as before:
+ *
+ *   tasmota-1234 ESP-MQT: Connected
+ *
+ * With SetOption113 1 one datagram carries as many lines as fit in SYSLOG_PACKET_SIZE using
+ * RFC5424 messages with RFC6587 octet-counted framing. This needs a receiver accepting
+ * octet-counted frames over UDP:
+ *
+ *   123 <14>1 2020-10-17T13:45:21Z tasmota-1234 tasmota - MQT - Connected
+ *
+ * A log prefix like "MQT: " is used as MSGID. The resolved host address is kept for
+ * SYSLOG_DNS_TTL seconds or until the host name changes. Lines not fitting in the queue are
+ * counted and reported with the next datagram.
+\*********************************************************************************************/
+
+const uint32_t SYSLOG_HEADER = sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint32_t);  // Record size, loglevel and UTC time
+
+struct SYSLOG {
+  uint8_t *queue = nullptr;                   // SYSLOG_QUEUE_SIZE bytes of records of [uint16_t size][uint8_t loglevel][uint32_t utc][text]
+  IPAddress host_addr;                        // Syslog host IP address
+  uint32_t host_hash = 0;                     // Syslog host name hash
+  uint32_t resolved = 0;                      // Uptime of last host resolution
+  uint32_t dropped = 0;                       // Lines lost due to a full queue
+  uint16_t head = 0;                          // Offset of oldest record
+  uint16_t used = 0;                          // Bytes in use
+} Syslog;
+
+void SyslogCopy(uint32_t offset, uint8_t* data, uint32_t len)
+{
+  // Copy len bytes from queue offset relative to the oldest record
+  uint32_t start = (Syslog.head + offset) % SYSLOG_QUEUE_SIZE;
+  uint32_t first = SYSLOG_QUEUE_SIZE - start;
+  if (first > len) { first = len; }
+  memcpy(data, Syslog.queue + start, first);
+  memcpy(data + first, Syslog.queue, len - first);
+}
+
+void SyslogClear(void)
+{
+  free(Syslog.queue);
+  Syslog.queue = nullptr;
+  Syslog.head = 0;
+  Syslog.used = 0;
+}
+
+void SyslogAdd(uint32_t loglevel, const char* text)
+{
+  if (!Syslog.queue) {
+    Syslog.queue = (uint8_t*)malloc(SYSLOG_QUEUE_SIZE);
+  }
+  uint32_t len = strlen(text);
+  uint32_t size = SYSLOG_HEADER + len;
+  if (!Syslog.queue || (size > (uint32_t)(SYSLOG_QUEUE_SIZE - Syslog.used))) {
+    Syslog.dropped++;
+    return;
+  }
+
+  uint8_t header[SYSLOG_HEADER];
+  uint16_t rsize = size;
+  uint32_t utc = UtcTime();
+  memcpy(header, &rsize, sizeof(rsize));
+  header[sizeof(rsize)] = loglevel;
+  memcpy(header + sizeof(rsize) + sizeof(uint8_t), &utc, sizeof(utc));
+
+  uint32_t tail = (Syslog.head + Syslog.used) % SYSLOG_QUEUE_SIZE;
+  for (uint32_t i = 0; i < size; i++) {
+    Syslog.queue[tail++] = (i < SYSLOG_HEADER) ? header[i] : text[i - SYSLOG_HEADER];
+    if (tail >= SYSLOG_QUEUE_SIZE) { tail = 0; }
+  }
+  Syslog.used += size;
+}
+
+bool SyslogResolve(void)
+{
+  uint32_t current_hash = GetHash(SettingsText(SET_SYSLOG_HOST), strlen(SettingsText(SET_SYSLOG_HOST)));
+  if ((Syslog.host_hash != current_hash) || (uint32_t)(UpTime() - Syslog.resolved) >= SYSLOG_DNS_TTL) {
+    Syslog.host_hash = current_hash;
+    Syslog.resolved = UpTime();
+    if (!WiFi.hostByName(SettingsText(SET_SYSLOG_HOST), Syslog.host_addr)) {  // If sleep enabled this might result in exception so try to do it once per TTL
+      Syslog.host_hash = 0;
+      return false;
+    }
+  }
+  return true;
+}
+
+void SyslogFailed(void)
+{
+  SyslogClear();
+  syslog_level = 0;
+  syslog_timer = SYSLOG_TIMER;
+  UpdateLogLevelMax();
+  AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_APPLICATION D_SYSLOG_HOST_NOT_FOUND ". " D_RETRY_IN " %d " D_UNIT_SECOND), SYSLOG_TIMER);
+}
+
+uint32_t SyslogFrame(char* frame, uint32_t size, uint32_t loglevel, uint32_t utc, const char* msgid, uint32_t text_len)
+{
+  // Build header into frame. Returns total frame length including text_len
+  if (!Settings.flag4.syslog_batch) {         // SetOption113 - Legacy header and full text
+    return snprintf_P(frame, size, PSTR("%s ESP-"), NetworkHostname()) + text_len;
+  }
+
+  // Octet count and RFC5424 header
+  const uint8_t severity[] = { 5, 3, 6, 7, 7 };   // LOG_LEVEL_NONE..LOG_LEVEL_DEBUG_MORE to notice, error, info, debug
+  uint32_t pri = 8 + severity[(loglevel > LOG_LEVEL_DEBUG_MORE) ? LOG_LEVEL_DEBUG_MORE : loglevel];  // Facility user
+
+  char timestamp[24];
+  TIME_T tm;
+  BreakTime(utc, tm);
+  if (tm.valid) {
+    snprintf_P(timestamp, sizeof(timestamp), PSTR("%04d-%02d-%02dT%02d:%02d:%02dZ"),
+      tm.year + 1970, tm.month, tm.day_of_month, tm.hour, tm.minute, tm.second);
+  } else {
+    strcpy_P(timestamp, PSTR("-"));
+  }
+
+  char header[100 + 32];
+  uint32_t header_len = snprintf_P(header, sizeof(header), PSTR("<%d>1 %s %s tasmota - %s - "),
+    pri, timestamp, NetworkHostname(), msgid);
+  if (header_len >= sizeof(header)) { header_len = sizeof(header) -1; }
+  return snprintf_P(frame, size, PSTR("%d %s"), header_len + text_len, header) + text_len;
+}
+
+bool SyslogBegin(void)
+{
+  if (!SyslogResolve() || !PortUdp.beginPacket(Syslog.host_addr, Settings.syslog_port)) {
+    SyslogFailed();
+    return false;
+  }
+  return true;
+}
+
+void SyslogLoop(void)
+{
+  if (!syslog_level) {                        // Disabled or waiting for retry
+    if (Syslog.queue) { SyslogClear(); }
+    return;
+  }
+  if ((!Syslog.used && !Syslog.dropped) || global_state.network_down) { return; }
+  if (!SyslogBegin()) { return; }
+
+  bool batch = Settings.flag4.syslog_batch;   // SetOption113 - Several lines per datagram
+  char frame[160];
+  uint32_t size = 0;
+  if (Syslog.dropped) {
+    char text[40];
+    uint32_t len = snprintf_P(text, sizeof(text), PSTR("%u lines dropped"), Syslog.dropped);
+    uint32_t frame_len = SyslogFrame(frame, sizeof(frame), LOG_LEVEL_ERROR, UtcTime(), "SYS", len);
+    PortUdp_write(frame, frame_len - len);
+    PortUdp_write(text, len);
+    size += frame_len;
+    Syslog.dropped = 0;
+  }
+
+  while (Syslog.used) {
+    uint8_t header[SYSLOG_HEADER];
+    SyslogCopy(0, header, SYSLOG_HEADER);
+    uint16_t rsize;
+    uint32_t utc;
+    memcpy(&rsize, header, sizeof(rsize));
+    memcpy(&utc, header + sizeof(rsize) + sizeof(uint8_t), sizeof(utc));
+    uint32_t loglevel = header[sizeof(rsize)];
+
+    uint32_t text_offset = SYSLOG_HEADER;
+    uint32_t text_len = rsize - SYSLOG_HEADER;
+    char msgid[4];
+    strcpy_P(msgid, PSTR("-"));
+    if (batch && (text_len > 5)) {
+      char prefix[5];
+      SyslogCopy(text_offset, (uint8_t*)prefix, sizeof(prefix));
+      if (isupper(prefix[0]) && isalnum(prefix[1]) && isalnum(prefix[2]) && (':' == prefix[3]) && (' ' == prefix[4])) {
+        memcpy(msgid, prefix, 3);
+        msgid[3] = '\0';
+        text_offset += sizeof(prefix);
+        text_len -= sizeof(prefix);
+      }
+    }
+
+    uint32_t frame_len = SyslogFrame(frame, sizeof(frame), loglevel, utc, msgid, text_len);
+    if (size && (size + frame_len > SYSLOG_PACKET_SIZE)) { break; }  // Send in next interval
+    if (size && !batch) {                     // One line per datagram
+      PortUdp.endPacket();
+      if (!SyslogBegin()) { return; }
+    }
+
+    PortUdp_write(frame, frame_len - text_len);
+    uint32_t start = (Syslog.head + text_offset) % SYSLOG_QUEUE_SIZE;
+    uint32_t first = SYSLOG_QUEUE_SIZE - start;
+    if (first > text_len) { first = text_len; }
+    PortUdp_write((const char*)Syslog.queue + start, first);
+    if (text_len > first) {
+      PortUdp_write((const char*)Syslog.queue, text_len - first);
+    }
+    size += frame_len;
+
+    Syslog.head = (Syslog.head + rsize) % SYSLOG_QUEUE_SIZE;
+    Syslog.used -= rsize;
+  }
+  PortUdp.endPacket();                        // No delay needed as the scheduler spaces the intervals
+}
@@ -472,7 +472,7 @@ bool SendKey(uint32_t key, uint32_t device, uint32_t state)
           (POWER_TOGGLE == state)) {
         state = ~(power >> (device -1)) &1;                 // POWER_OFF or POWER_ON
       }
-      snprintf_P(mqtt_data, sizeof(mqtt_data), GetStateText(state));
+      Response_P(GetStateText(state));
     }
 #ifdef USE_DOMOTICZ
     if (!(DomoticzSendKey(key, device, state, strlen(mqtt_data)))) {
@@ -698,6 +698,9 @@ void MqttShowState(void)
 
 void MqttPublishTeleState(void)
 {
+#ifdef USE_TELE_DELTA
+  if (TeleDeltaCoalesce()) { return; }  // Published once at the end of the coalesce window
+#endif  // USE_TELE_DELTA
   mqtt_data[0] = '\0';
   MqttShowState();
   MqttPublishPrefixTopic_P(TELE, PSTR(D_RSLT_STATE), MQTT_TELE_RETAIN);
@@ -730,11 +733,8 @@ void TempHumDewShow(bool json, bool pass_on, const char *types, float f_temperat
   }
 }
 
-bool MqttShowSensor(void)
+void MqttShowSensorData(void)
 {
-  ResponseAppendTime();
-
-  int json_data_start = strlen(mqtt_data);
   for (uint32_t i = 0; i < MAX_SWITCHES; i++) {
 #ifdef USE_TM1638
     if (PinUsed(GPIO_SWT1, i) || (PinUsed(GPIO_TM16CLK) && PinUsed(GPIO_TM16DIO) && PinUsed(GPIO_TM16STB))) {
@@ -746,29 +746,47 @@ bool MqttShowSensor(void)
   }
   XsnsCall(FUNC_JSON_APPEND);
   XdrvCall(FUNC_JSON_APPEND);
+}
 
-  bool json_data_available = (strlen(mqtt_data) - json_data_start);
-  if (strstr_P(mqtt_data, PSTR(D_JSON_PRESSURE)) != nullptr) {
+void MqttShowSensorEnd(void)
+{
+  uint32_t units = ResponseUnits() | MqttStreamUnits();
+  if (units & RESPONSE_UNIT_PRESSURE) {
     ResponseAppend_P(PSTR(",\"" D_JSON_PRESSURE_UNIT "\":\"%s\""), PressureUnit().c_str());
   }
-  if (strstr_P(mqtt_data, PSTR(D_JSON_TEMPERATURE)) != nullptr) {
+  if (units & RESPONSE_UNIT_TEMPERATURE) {
     ResponseAppend_P(PSTR(",\"" D_JSON_TEMPERATURE_UNIT "\":\"%c\""), TempUnit());
   }
-  if ((strstr_P(mqtt_data, PSTR(D_JSON_SPEED)) != nullptr) && Settings.flag2.speed_conversion) {
+  if ((units & RESPONSE_UNIT_SPEED) && Settings.flag2.speed_conversion) {
     ResponseAppend_P(PSTR(",\"" D_JSON_SPEED_UNIT "\":\"%s\""), SpeedUnit().c_str());
   }
   ResponseJsonEnd();
+}
+
+bool MqttShowSensor(void)
+{
+  ResponseAppendTime();
+
+  int json_data_start = ResponseLength();
+  MqttShowSensorData();
+  bool json_data_available = (MqttStreamLength() + ResponseLength() - json_data_start);
+  MqttShowSensorEnd();
+  if (ResponseOverflow()) {
+    AddLog_P2(LOG_LEVEL_DEBUG, PSTR("MQT: Sensor data exceeds %d characters"), ResponseLength());
+  }
 
-  if (json_data_available) { XdrvCall(FUNC_SHOW_SENSOR); }
+  if (json_data_available) { MqttStreamShowSensor(); }
   return json_data_available;
 }
 
 void MqttPublishSensor(void)
 {
   mqtt_data[0] = '\0';
+  MqttStreamBegin();
   if (MqttShowSensor()) {
     MqttPublishTeleSensor();
   }
+  MqttStreamEnd();
 }
 
 /*********************************************************************************************\
@@ -813,6 +831,7 @@ void PerformEverySecond(void)
         AddLog_P(LOG_LEVEL_INFO, PSTR(D_LOG_APPLICATION D_SERIAL_LOGGING_DISABLED));
       }
       seriallog_level = 0;
+      UpdateLogLevelMax();
     }
   }
 
@@ -820,6 +839,7 @@ void PerformEverySecond(void)
     syslog_timer--;
     if (!syslog_timer) {
       syslog_level = Settings.syslog_level;
+      UpdateLogLevelMax();
       if (Settings.syslog_level) {
         AddLog_P(LOG_LEVEL_INFO, PSTR(D_LOG_APPLICATION D_SYSLOG_LOGGING_REENABLED));  // Might trigger disable again (on purpose)
       }
@@ -838,15 +858,20 @@ void PerformEverySecond(void)
       if (tele_period >= Settings.tele_period) {
         tele_period = 0;
 
+#ifdef USE_TELE_DELTA
+        TeleDeltaPeriod();
+#endif  // USE_TELE_DELTA
         MqttPublishTeleState();
 
         mqtt_data[0] = '\0';
+        MqttStreamBegin();
         if (MqttShowSensor()) {
-          MqttPublishPrefixTopic_P(TELE, PSTR(D_RSLT_SENSOR), Settings.flag.mqtt_sensor_retain);  // CMND_SENSORRETAIN
+          MqttPublishPrefixTopicStream_P(TELE, PSTR(D_RSLT_SENSOR), Settings.flag.mqtt_sensor_retain);  // CMND_SENSORRETAIN
 #if defined(USE_RULES) || defined(USE_SCRIPT)
           RulesTeleperiod();  // Allow rule based HA messages
 #endif  // USE_RULES
         }
+        MqttStreamEnd();
 
         XsnsCall(FUNC_AFTER_TELEPERIOD);
         XdrvCall(FUNC_AFTER_TELEPERIOD);
@@ -1021,6 +1046,7 @@ void Every250mSeconds(void)
             snprintf_P(mqtt_data, sizeof(mqtt_data), PSTR("%s-" D_JSON_MINIMAL "%s"), mqtt_data, ota_url_type);  // Minimal filename must be filename-minimal
           }
 #endif  // FIRMWARE_MINIMAL
+          ResponseReset();                                             // mqtt_data holds the url
           AddLog_P2(LOG_LEVEL_DEBUG, PSTR(D_LOG_UPLOAD "%s"), mqtt_data);
           WiFiClient OTAclient;
           ota_result = (HTTP_UPDATE_FAILED != ESPhttpUpdate.update(OTAclient, mqtt_data));
@@ -1401,6 +1427,7 @@ void SerialInput(void)
     if (!Settings.flag.mqtt_serial && (serial_in_byte == '\n')) {                // CMND_SERIALSEND and CMND_SERIALLOG
       serial_in_buffer[serial_in_byte_counter] = 0;                              // Serial data completed
       seriallog_level = (Settings.seriallog_level < LOG_LEVEL_INFO) ? (uint8_t)LOG_LEVEL_INFO : Settings.seriallog_level;
+      UpdateLogLevelMax();
       if (serial_buffer_overrun) {
         AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_COMMAND "Serial buffer overrun"));
       } else {
@@ -0,0 +1,364 @@
+/*
+  support_tele_delta.ino - delta telemetry support for Tasmota
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef USE_TELE_DELTA
+/*********************************************************************************************\
+ * Delta telemetry
+ *
+ * In delta mode tele STATE and SENSOR messages only carry Time and the JSON leaves changed
+ * since they were last published. A message without changed leaves is not published.
+ * Leaves are tracked by a hash of their key path in a fixed size table holding the last
+ * published number or a hash of any other value. A number only counts as changed when it moved
+ * more than the deadband set for its key (Temperature) or key path (AM2301.Temperature).
+ * All leaves are published every TeleDelta teleperiods. Messages larger than mqtt_data are
+ * always published in full. STATE messages requested within TeleCoalesce * 100 mSeconds are
+ * merged into one message.
+ *
+ * TeleDelta 0                    - Publish full messages (default)
+ * TeleDelta 1..255               - Publish changed leaves only and all leaves every n teleperiods
+ * TeleCoalesce 0..255            - Merge STATE messages requested within n * 100 mSeconds
+ * TeleDeadband<x> <key>,<value>  - Set deadband x of key or key path
+ * TeleDeadband<x> 0              - Clear deadband x
+\*********************************************************************************************/
+
+#ifndef TELE_DELTA_MAX_KEYS
+#define TELE_DELTA_MAX_KEYS        64         // Number of tracked JSON leaves
+#endif
+
+const uint32_t TELE_DELTA_MAX_DEPTH = 4;      // Deeper nested objects are tracked as one leaf
+const uint32_t TELE_DELTA_HASH_INIT = 2166136261;  // FNV-1a offset basis
+
+enum TeleDeltaTopics { TELE_DELTA_STATE, TELE_DELTA_SENSOR };
+
+typedef struct {
+  uint32_t key;                               // 0 = free, else key path hash mixed with topic
+  uint32_t value;                             // Last published number as float or value hash
+} TeleDeltaLeaf;
+
+struct TELEDELTA {
+  TeleDeltaLeaf *leaves = nullptr;
+  const char *src;                            // Scan position in the full message
+  uint32_t out;                               // Write position in mqtt_data
+  uint32_t topic_key;                         // Key path hash modifier of current topic
+  uint32_t deadband_key[MAX_TELE_DEADBANDS];  // Key hash per deadband, 0 = unused
+  int8_t state_timer = -1;                    // Scheduler timer of coalesced STATE
+  uint8_t periods = 0;                        // Teleperiods since last full publish
+  uint8_t full = 0;                           // Bitmask of TeleDeltaTopics to publish in full
+  bool full_topic = false;                    // Current message is published in full
+  bool coalesced = false;                     // Publishing coalesced STATE
+} TeleDelta;
+
+uint32_t TeleDeltaHash(uint32_t hash, const char* data, uint32_t len)
+{
+  while (len--) {
+    hash = (hash ^ (uint8_t)*data++) * 16777619;
+  }
+  return hash;
+}
+
+void TeleDeltaInitDeadbands(void)
+{
+  for (uint32_t i = 0; i < MAX_TELE_DEADBANDS; i++) {
+    char *key = Settings.tele_deadband[i].key;
+    TeleDelta.deadband_key[i] = (key[0]) ? TeleDeltaHash(TELE_DELTA_HASH_INIT, key, strnlen(key, sizeof(Settings.tele_deadband[i].key))) : 0;
+  }
+}
+
+float TeleDeltaDeadband(uint32_t path, uint32_t name)
+{
+  for (uint32_t i = 0; i < MAX_TELE_DEADBANDS; i++) {
+    uint32_t key = TeleDelta.deadband_key[i];
+    if (key && ((key == path) || (key == name))) {
+      return Settings.tele_deadband[i].deadband;
+    }
+  }
+  return 0;
+}
+
+const char* TeleDeltaSkip(const char* p)
+{
+  // Returns pointer past the JSON value starting at p
+  if ('"' == *p) {
+    p++;
+    while (*p && ('"' != *p)) {
+      if (('\\' == *p) && p[1]) { p++; }
+      p++;
+    }
+    return (*p) ? p +1 : p;
+  }
+  if (('{' == *p) || ('[' == *p)) {
+    uint32_t depth = 0;
+    while (*p) {
+      if ('"' == *p) {
+        p = TeleDeltaSkip(p);
+        continue;
+      }
+      if (('{' == *p) || ('[' == *p)) {
+        depth++;
+      }
+      else if (('}' == *p) || (']' == *p)) {
+        depth--;
+        if (!depth) { return p +1; }
+      }
+      p++;
+    }
+    return p;
+  }
+  while (*p && (',' != *p) && ('}' != *p) && (']' != *p)) { p++; }
+  return p;
+}
+
+void TeleDeltaWrite(const char* data, uint32_t len)
+{
+  // Output never exceeds the scanned message which fitted in mqtt_data
+  memcpy(mqtt_data + TeleDelta.out, data, len);
+  TeleDelta.out += len;
+}
+
+bool TeleDeltaChanged(uint32_t path, uint32_t name, const char* value, uint32_t value_len)
+{
+  // Returns true if the leaf needs to be published and remembers its value if so
+  bool number = isdigit(value[0]) || (('-' == value[0]) && isdigit(value[1]));
+  float fvalue = 0;
+  uint32_t current;
+  if (number) {
+    char number_str[24];
+    strlcpy(number_str, value, (value_len < sizeof(number_str)) ? value_len +1 : sizeof(number_str));
+    fvalue = CharToFloat(number_str);
+    memcpy(&current, &fvalue, sizeof(current));
+  } else {
+    current = TeleDeltaHash(TELE_DELTA_HASH_INIT, value, value_len);
+  }
+
+  uint32_t key = (path ^ TeleDelta.topic_key) | 1;
+  uint32_t slot = (key * 2654435761) % TELE_DELTA_MAX_KEYS;
+  for (uint32_t i = 0; i < TELE_DELTA_MAX_KEYS; i++) {
+    TeleDeltaLeaf *leaf = &TeleDelta.leaves[slot];
+    if (!leaf->key) {                         // New leaf
+      leaf->key = key;
+      leaf->value = current;
+      return true;
+    }
+    if (key == leaf->key) {
+      bool changed = TeleDelta.full_topic;
+      if (!changed) {
+        if (number) {
+          float last;
+          memcpy(&last, &leaf->value, sizeof(last));
+          changed = !(fabs(fvalue - last) <= TeleDeltaDeadband(path, name));  // Also true for a previous non-number
+        } else {
+          changed = (current != leaf->value);
+        }
+      }
+      if (changed) {
+        leaf->value = current;
+      }
+      return changed;
+    }
+    slot++;
+    if (slot >= TELE_DELTA_MAX_KEYS) { slot = 0; }
+  }
+  return true;                                // Table full so always publish
+}
+
+bool TeleDeltaObject(uint32_t path, uint32_t depth)
+{
+  // Copy changed members of the object at TeleDelta.src, just after its opening brace, to
+  // mqtt_data. Returns true if a changed leaf was written
+  bool changed = false;
+  bool first = true;
+  const char *p = TeleDelta.src;
+  while (*p) {
+    while (isspace(*p) || (',' == *p)) { p++; }
+    if ('"' != *p) {
+      if ('}' == *p) { p++; }
+      break;
+    }
+    const char *key = p;
+    p = TeleDeltaSkip(p);
+    uint32_t key_len = (p - key > 2) ? p - key - 2 : 0;
+    while (*p && (':' != *p)) { p++; }
+    if (*p) { p++; }
+    while (isspace(*p)) { p++; }
+    const char *value = p;
+
+    uint32_t name = TeleDeltaHash(TELE_DELTA_HASH_INIT, key +1, key_len);
+    uint32_t child = TeleDeltaHash((depth) ? TeleDeltaHash(path, ".", 1) : TELE_DELTA_HASH_INIT, key +1, key_len);
+    uint32_t mark = TeleDelta.out;
+    if (!first) { TeleDeltaWrite(",", 1); }
+    TeleDeltaWrite(key, value - key);         // "Key":
+    if (('{' == *value) && (depth < TELE_DELTA_MAX_DEPTH)) {
+      TeleDeltaWrite("{", 1);
+      TeleDelta.src = value +1;
+      bool object_changed = TeleDeltaObject(child, depth +1);
+      p = TeleDelta.src;
+      if (object_changed) {
+        TeleDeltaWrite("}", 1);
+        changed = true;
+        first = false;
+      } else {
+        TeleDelta.out = mark;
+      }
+    } else {
+      p = TeleDeltaSkip(value);
+      bool always = !depth && (((4 == key_len) && !strncmp_P(key +1, PSTR(D_JSON_TIME), 4)) ||
+                               ((5 == key_len) && !strncmp_P(key +1, PSTR("Epoch"), 5)));
+      if (always || TeleDeltaChanged(child, name, value, p - value)) {
+        TeleDeltaWrite(value, p - value);
+        changed |= !always;
+        first = false;
+      } else {
+        TeleDelta.out = mark;
+      }
+    }
+  }
+  TeleDelta.src = p;
+  return changed;
+}
+
+bool TeleDeltaPublish(uint32_t prefix, const char* subtopic, const char* topic, bool retained)
+{
+  // Publish changed leaves of tele STATE or SENSOR in mqtt_data. Returns false if not handled
+  if (!Settings.tele_delta || (TELE != prefix) || ResponseOverflow() || ('{' != mqtt_data[0])) { return false; }
+  uint32_t delta_topic;
+  if (!strcmp_P(subtopic, PSTR(D_RSLT_STATE))) {
+    delta_topic = TELE_DELTA_STATE;
+  }
+  else if (!strcmp_P(subtopic, PSTR(D_RSLT_SENSOR))) {
+    delta_topic = TELE_DELTA_SENSOR;
+  } else {
+    return false;
+  }
+  if (!TeleDelta.leaves) {
+    TeleDelta.leaves = (TeleDeltaLeaf*)calloc(TELE_DELTA_MAX_KEYS, sizeof(TeleDeltaLeaf));
+    if (!TeleDelta.leaves) { return false; }  // Not enough memory
+    TeleDeltaInitDeadbands();
+  }
+  uint32_t len = ResponseLength();
+  char *full = (char*)malloc(len +1);
+  if (!full) { return false; }
+  memcpy(full, mqtt_data, len +1);
+
+  TeleDelta.topic_key = (delta_topic +1) * 0x9E3779B9;
+  TeleDelta.full_topic = bitRead(TeleDelta.full, delta_topic);
+  bitClear(TeleDelta.full, delta_topic);
+  TeleDelta.src = full +1;
+  TeleDelta.out = 0;
+  TeleDeltaWrite("{", 1);
+  bool changed = TeleDeltaObject(TELE_DELTA_HASH_INIT, 0);
+  TeleDeltaWrite("}", 1);
+  mqtt_data[TeleDelta.out] = '\0';
+  ResponseReset();
+  ResponseSetLength(TeleDelta.out, 0);
+
+  if (changed) {
+    MqttPublish(topic, retained);
+  }
+  Response_P(PSTR("%s"), full);               // Restore full message for rules and drivers
+  free(full);
+  return true;
+}
+
+void TeleDeltaPeriod(void)
+{
+  // Called every teleperiod before publishing STATE and SENSOR
+  if (!Settings.tele_delta) { return; }
+  TeleDelta.periods++;
+  if (TeleDelta.periods >= Settings.tele_delta) {
+    TeleDelta.periods = 0;
+    TeleDelta.full = (1 << TELE_DELTA_STATE) | (1 << TELE_DELTA_SENSOR);
+  }
+}
+
+void TeleDeltaCoalesced(void)
+{
+  TeleDelta.state_timer = -1;
+  TeleDelta.coalesced = true;
+  MqttPublishTeleState();
+  TeleDelta.coalesced = false;
+}
+
+bool TeleDeltaCoalesce(void)
+{
+  // Returns true if the STATE message is published at the end of the coalesce window
+  if (!Settings.tele_delta || !Settings.tele_coalesce || TeleDelta.coalesced) { return false; }
+  if (TeleDelta.state_timer < 0) {
+    TeleDelta.state_timer = SchedulerAdd(&TeleDeltaCoalesced, 0, Settings.tele_coalesce * 100);
+    if (TeleDelta.state_timer < 0) { return false; }
+  }
+  return true;
+}
+
+/*********************************************************************************************\
+ * Commands
+\*********************************************************************************************/
+
+void CmndTeleDelta(void)
+{
+  if ((XdrvMailbox.payload >= 0) && (XdrvMailbox.payload <= 255)) {
+    Settings.tele_delta = XdrvMailbox.payload;
+    TeleDelta.periods = 0;
+    TeleDelta.full = (1 << TELE_DELTA_STATE) | (1 << TELE_DELTA_SENSOR);
+    if (!Settings.tele_delta && TeleDelta.leaves) {
+      free(TeleDelta.leaves);
+      TeleDelta.leaves = nullptr;
+    }
+  }
+  ResponseCmndNumber(Settings.tele_delta);
+}
+
+void CmndTeleCoalesce(void)
+{
+  if ((XdrvMailbox.payload >= 0) && (XdrvMailbox.payload <= 255)) {
+    Settings.tele_coalesce = XdrvMailbox.payload;
+  }
+  ResponseCmndNumber(Settings.tele_coalesce);
+}
+
+void CmndTeleDeadband(void)
+{
+  if ((XdrvMailbox.index > 0) && (XdrvMailbox.index <= MAX_TELE_DEADBANDS)) {
+    uint32_t index = XdrvMailbox.index -1;
+    if (XdrvMailbox.data_len > 0) {
+      char *value = strchr(XdrvMailbox.data, ',');
+      if (value) {
+        *value++ = '\0';
+        strlcpy(Settings.tele_deadband[index].key, Trim(XdrvMailbox.data), sizeof(Settings.tele_deadband[index].key));
+        Settings.tele_deadband[index].deadband = fabs(CharToFloat(value));
+      }
+      else if (('0' == XdrvMailbox.data[0]) || ('"' == XdrvMailbox.data[0])) {
+        memset(&Settings.tele_deadband[index], 0, sizeof(Settings.tele_deadband[index]));
+      }
+      TeleDeltaInitDeadbands();
+    }
+    Response_P(PSTR("{\"%s\":{"), XdrvMailbox.command);
+    bool first = true;
+    for (uint32_t i = 0; i < MAX_TELE_DEADBANDS; i++) {
+      if (!Settings.tele_deadband[i].key[0]) { continue; }
+      char deadband[FLOATSZ];
+      dtostrfd(Settings.tele_deadband[i].deadband, 3, deadband);
+      ResponseAppend_P(PSTR("%s\"%d\":{\"%s\":%s}"), (first) ? "" : ",", i +1,
+        EscapeJSONString(Settings.tele_deadband[i].key).c_str(), deadband);
+      first = false;
+    }
+    ResponseJsonEndEnd();
+  }
+}
+
+#endif  // USE_TELE_DELTA
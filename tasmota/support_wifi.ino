@@ -637,6 +637,9 @@ void WifiShutdown(bool option = false)
 
 void EspRestart(void)
 {
+#ifdef USE_LOG_BINARY
+  LogBinaryLoop();            // Output queued log messages
+#endif  // USE_LOG_BINARY
   ResetPwm();
   WifiShutdown(true);
   CrashDumpClear();           // Clear the stack dump in RTC
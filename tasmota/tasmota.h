@@ -90,6 +90,7 @@ const uint8_t MAX_ADCS = 8;                 // Max number of ESP32 ADC pins (ADC
 
 const uint8_t MAX_HUE_DEVICES = 15;         // Max number of Philips Hue device per emulation
 const uint8_t MAX_ROTARIES = 2;             // Max number of Rotary Encoders
+const uint8_t MAX_TELE_DEADBANDS = 4;       // Max number of telemetry deadbands
 
 const char MQTT_TOKEN_PREFIX[] PROGMEM = "%prefix%";  // To be substituted by mqtt_prefix[x]
 const char MQTT_TOKEN_TOPIC[] PROGMEM = "%topic%";    // To be substituted by mqtt_topic, mqtt_grptopic, mqtt_buttontopic, mqtt_switchtopic
@@ -127,6 +128,10 @@ const uint8_t IMMINENT_RESET_FACTOR = 10;   // Factor to extent button hold time
 const uint32_t BOOT_LOOP_TIME = 10;         // Number of seconds to stop detecting boot loops
 const uint32_t POWER_CYCLE_TIME = 8;        // Number of seconds to reset power cycle boot loops
 const uint16_t SYSLOG_TIMER = 600;          // Seconds to restore syslog_level
+const uint16_t SYSLOG_INTERVAL = 100;       // mSeconds between syslog datagrams
+const uint16_t SYSLOG_QUEUE_SIZE = 2048;    // Max number of bytes in syslog queue
+const uint16_t SYSLOG_PACKET_SIZE = 1024;   // Max number of bytes in syslog datagram unless a single message is larger
+const uint16_t SYSLOG_DNS_TTL = 3600;       // Seconds to keep the resolved syslog host address
 const uint16_t SERIALLOG_TIMER = 600;       // Seconds to disable SerialLog
 const uint8_t OTA_ATTEMPTS = 5;             // Number of times to try fetching the new firmware
 
@@ -140,6 +145,7 @@ const uint16_t MIN_MESSZ = 1040;            // Min number of characters in MQTT
 const uint8_t SENSOR_MAX_MISS = 5;          // Max number of missed sensor reads before deciding it's offline
 
 const uint8_t MAX_BACKLOG = 30;             // Max number of commands in backlog
+const uint16_t BACKLOG_SIZE = 1024;         // Max number of bytes in backlog including two bytes length per command
 const uint32_t MIN_BACKLOG_DELAY = 200;     // Minimal backlog delay in mSeconds
 
 const uint32_t SOFT_BAUDRATE = 9600;        // Default software serial baudrate
@@ -276,6 +282,14 @@ enum XsnsFunctions {FUNC_SETTINGS_OVERRIDE, FUNC_PIN_STATE, FUNC_MODULE_INIT, FU
                     FUNC_WEB_ADD_BUTTON, FUNC_WEB_ADD_MAIN_BUTTON, FUNC_WEB_ADD_HANDLER, FUNC_SET_CHANNELS, FUNC_SET_SCHEME, FUNC_HOTPLUG_SCAN,
                     FUNC_DEVICE_GROUP_ITEM };
 
+#define FUNC_TICKS          6                     // Periodic functions FUNC_LOOP up to FUNC_EVERY_SECOND
+#define FUNC_TICKS_ALL      0x3F
+#define FUNC_TICK(FUNCTION) (1 << ((FUNCTION) - FUNC_LOOP))
+
+enum ProfileInterfaces { PRF_XDRV, PRF_XSNS, PRF_XLGT, PRF_XNRG };
+
+enum ResponseUnits { RESPONSE_UNIT_PRESSURE = 1, RESPONSE_UNIT_TEMPERATURE = 2, RESPONSE_UNIT_SPEED = 4 };
+
 enum AddressConfigSteps { ADDR_IDLE, ADDR_RECEIVE, ADDR_SEND };
 
 enum SettingsTextIndex { SET_OTAURL,
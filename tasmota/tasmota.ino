@@ -85,10 +85,6 @@ unsigned long feature5;                     // Compiled feature map
 unsigned long feature6;                     // Compiled feature map
 unsigned long feature7;                     // Compiled feature map
 unsigned long serial_polling_window = 0;    // Serial polling window
-unsigned long state_second = 0;             // State second timer
-unsigned long state_50msecond = 0;          // State 50msecond timer
-unsigned long state_100msecond = 0;         // State 100msecond timer
-unsigned long state_250msecond = 0;         // State 250msecond timer
 unsigned long pulse_timer[MAX_PULSETIMERS] = { 0 }; // Power off timer
 unsigned long blink_timer = 0;              // Power cycle timer
 unsigned long backlog_delay = 0;            // Command backlog delay
@@ -140,6 +136,7 @@ uint8_t devices_present = 0;                // Max number of devices supported
 uint8_t masterlog_level = 0;                // Master log level used to override set log level
 uint8_t seriallog_level;                    // Current copy of Settings.seriallog_level
 uint8_t syslog_level;                       // Current copy of Settings.syslog_level
+uint8_t log_level_max = LOG_LEVEL_DEBUG_MORE;  // Highest log level accepted by any log sink
 uint8_t my_module_type;                     // Current copy of Settings.module or user template type
 uint8_t last_source = 0;                    // Last command source
 uint8_t shutters_present = 0;               // Number of actual define shutters
@@ -172,16 +169,14 @@ char serial_in_buffer[INPUT_BUFFER_SIZE];   // Receive buffer
 char mqtt_data[MESSZ];                      // MQTT publish buffer and web page ajax buffer
 char log_data[LOGSZ];                       // Logging
 char web_log[WEB_LOG_SIZE] = {'\0'};        // Web log buffer
-#ifdef SUPPORT_IF_STATEMENT
-  #include <LinkedList.h>
-  LinkedList<String> backlog;               // Command backlog implemented with LinkedList
-  #define BACKLOG_EMPTY (backlog.size() == 0)
-#else
-  uint8_t backlog_index = 0;                // Command backlog index
-  uint8_t backlog_pointer = 0;              // Command backlog pointer
-  String backlog[MAX_BACKLOG];              // Command backlog buffer
-  #define BACKLOG_EMPTY (backlog_pointer == backlog_index)
-#endif
+struct BACKLOG {
+  uint16_t head = 0;                        // Buffer position of first command
+  uint16_t used = 0;                        // Bytes in use including length headers
+  uint16_t high_water = 0;                  // Max bytes in use since restart
+  uint8_t count = 0;                        // Number of queued commands
+  char buffer[BACKLOG_SIZE];                // Ring of length prefixed commands
+} Backlog;
+#define BACKLOG_EMPTY (0 == Backlog.count)
 
 /*********************************************************************************************\
  * Main
@@ -234,6 +229,7 @@ void setup(void) {
   seriallog_level = Settings.seriallog_level;
   seriallog_timer = SERIALLOG_TIMER;
   syslog_level = Settings.syslog_level;
+  UpdateLogLevelMax();
   stop_flash_rotate = Settings.flag.stop_flash_rotate;  // SetOption12 - Switch between dynamic or fixed slot flash save location
   save_data_counter = Settings.save_data;
   ssleep = Settings.sleep;
@@ -308,33 +304,63 @@ void setup(void) {
 
   XdrvCall(FUNC_INIT);
   XsnsCall(FUNC_INIT);
+  XdrvTicksInit();
+  XsnsTicksInit();
 #ifdef USE_SCRIPT
   if (bitRead(Settings.rule_enabled, 0)) Run_Scripter(">BS",3,0);
 #endif
 
+  SchedulerAdd(&Every50mSecondsTick, 50, 0);
+  SchedulerAdd(&Every100mSecondsTick, 100, 0);
+  SchedulerAdd(&Every250mSecondsTick, 250, 0);
+  SchedulerAdd(&EverySecondTick, 1000, 0);
+  SchedulerAdd(&SyslogLoop, SYSLOG_INTERVAL, 0);
+
   rules_flag.system_init = 1;
 }
 
+void Every50mSecondsTick(void) {
+#ifdef ROTARY_V1
+  RotaryHandler();
+#endif  // ROTARY_V1
+  XdrvCall(FUNC_EVERY_50_MSECOND);
+  XsnsCall(FUNC_EVERY_50_MSECOND);
+}
+
+void Every100mSecondsTick(void) {
+  Every100mSeconds();
+  XdrvCall(FUNC_EVERY_100_MSECOND);
+  XsnsCall(FUNC_EVERY_100_MSECOND);
+}
+
+void Every250mSecondsTick(void) {
+  Every250mSeconds();
+  XdrvCall(FUNC_EVERY_250_MSECOND);
+  XsnsCall(FUNC_EVERY_250_MSECOND);
+}
+
+void EverySecondTick(void) {
+  PerformEverySecond();
+  XdrvCall(FUNC_EVERY_SECOND);
+  XsnsCall(FUNC_EVERY_SECOND);
+}
+
 void BacklogLoop(void) {
   if (TimeReached(backlog_delay)) {
     if (!BACKLOG_EMPTY && !backlog_mutex) {
       backlog_mutex = true;
       bool nodelay = false;
       bool nodelay_detected = false;
-      String cmd;
       do {
-#ifdef SUPPORT_IF_STATEMENT
-        cmd = backlog.shift();
-#else
-        cmd = backlog[backlog_pointer];
-        backlog[backlog_pointer] = (const char*) nullptr;  // Force deallocation of the String internal memory
-        backlog_pointer++;
-        if (backlog_pointer >= MAX_BACKLOG) { backlog_pointer = 0; }
-#endif
-        nodelay_detected = !strncasecmp_P(cmd.c_str(), PSTR(D_CMND_NODELAY), strlen(D_CMND_NODELAY));
-        if (nodelay_detected) { nodelay = true; }
+        static char cmd[BACKLOG_SIZE];     // Keeps up to 1k off the loop stack. Not re-entered due to backlog_mutex
+        BacklogNext(cmd, sizeof(cmd));
+        nodelay_detected = !strncasecmp_P(cmd, PSTR(D_CMND_NODELAY), strlen(D_CMND_NODELAY));
+        if (nodelay_detected) {
+          nodelay = true;
+        } else {
+          ExecuteCommand(cmd, SRC_BACKLOG);
+        }
       } while (!BACKLOG_EMPTY && nodelay_detected);
-      if (!nodelay_detected) { ExecuteCommand((char*)cmd.c_str(), SRC_BACKLOG); }
       if (nodelay) { backlog_delay = 0; }  // Reset backlog_delay which has been set by ExecuteCommand (CommandHandler)
       backlog_mutex = false;
     }
@@ -367,32 +393,10 @@ void loop(void) {
 #endif  // USE_DEVICE_GROUPS
   BacklogLoop();
 
-  if (TimeReached(state_50msecond)) {
-    SetNextTimeInterval(state_50msecond, 50);
-#ifdef ROTARY_V1
-    RotaryHandler();
-#endif  // ROTARY_V1
-    XdrvCall(FUNC_EVERY_50_MSECOND);
-    XsnsCall(FUNC_EVERY_50_MSECOND);
-  }
-  if (TimeReached(state_100msecond)) {
-    SetNextTimeInterval(state_100msecond, 100);
-    Every100mSeconds();
-    XdrvCall(FUNC_EVERY_100_MSECOND);
-    XsnsCall(FUNC_EVERY_100_MSECOND);
-  }
-  if (TimeReached(state_250msecond)) {
-    SetNextTimeInterval(state_250msecond, 250);
-    Every250mSeconds();
-    XdrvCall(FUNC_EVERY_250_MSECOND);
-    XsnsCall(FUNC_EVERY_250_MSECOND);
-  }
-  if (TimeReached(state_second)) {
-    SetNextTimeInterval(state_second, 1000);
-    PerformEverySecond();
-    XdrvCall(FUNC_EVERY_SECOND);
-    XsnsCall(FUNC_EVERY_SECOND);
-  }
+  SchedulerLoop();
+#ifdef USE_LOG_BINARY
+  LogBinaryLoop();
+#endif  // USE_LOG_BINARY
 
   if (!serial_local) { SerialInput(); }
 
@@ -404,13 +408,13 @@ void loop(void) {
 
   if (Settings.flag3.sleep_normal) {               // SetOption60 - Enable normal sleep instead of dynamic sleep
     //  yield();                                   // yield == delay(0), delay contains yield, auto yield in loop
-    SleepDelay(ssleep);                            // https://github.com/esp8266/Arduino/issues/2021
+    SleepDelay(SchedulerSleep(ssleep));            // https://github.com/esp8266/Arduino/issues/2021
   } else {
     if (my_activity < (uint32_t)ssleep) {
-      SleepDelay((uint32_t)ssleep - my_activity);  // Provide time for background tasks like wifi
+      SleepDelay(SchedulerSleep((uint32_t)ssleep - my_activity));  // Provide time for background tasks like wifi until next deadline
     } else {
       if (global_state.network_down) {
-        SleepDelay(my_activity /2);                // If wifi down and my_activity > setoption36 then force loop delay to 1/3 of my_activity period
+        SleepDelay(SchedulerSleep(my_activity /2));  // If wifi down and my_activity > setoption36 then force loop delay to 1/3 of my_activity period
       }
     }
   }
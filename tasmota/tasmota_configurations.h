@@ -681,6 +681,10 @@
 #undef USE_THERMOSTAT                            // Disable support for Thermostat
 #undef DEBUG_THEO                                // Disable debug code
 #undef USE_DEBUG_DRIVER                          // Disable debug code
+#undef USE_PROFILE_DRIVER                        // Disable driver profiling
+#undef USE_LOG_BINARY                            // Disable deferred log formatting
+#undef USE_TELE_DELTA                            // Disable delta telemetry
+#undef USE_MQTT_CBOR                             // Disable CBOR payloads
 #endif  // FIRMWARE_LITE
 
 /*********************************************************************************************\
@@ -818,6 +822,10 @@
 #undef USE_PROMETHEUS                            // Disable support for https://prometheus.io/ metrics exporting over HTTP /metrics endpoint
 #undef DEBUG_THEO                                // Disable debug code
 #undef USE_DEBUG_DRIVER                          // Disable debug code
+#undef USE_PROFILE_DRIVER                        // Disable driver profiling
+#undef USE_LOG_BINARY                            // Disable deferred log formatting
+#undef USE_TELE_DELTA                            // Disable delta telemetry
+#undef USE_MQTT_CBOR                             // Disable CBOR payloads
 #endif  // FIRMWARE_MINIMAL
 
 #ifdef ESP32
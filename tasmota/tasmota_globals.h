@@ -414,6 +414,14 @@ uint8_t device_group_count = 0;
 #define DEBUG_TRACE_LOG(...)
 #endif
 
+#ifdef USE_PROFILE_DRIVER
+#define PROFILE_DRIVER_START(START) uint32_t START = ProfileStart()
+#define PROFILE_DRIVER(INTERFACE, INDEX, FUNCTION, START) ProfileDriver(INTERFACE, INDEX, FUNCTION, START)
+#else
+#define PROFILE_DRIVER_START(START)
+#define PROFILE_DRIVER(INTERFACE, INDEX, FUNCTION, START)
+#endif  // USE_PROFILE_DRIVER
+
 /*********************************************************************************************/
 
 #endif  // _TASMOTA_GLOBALS_H_
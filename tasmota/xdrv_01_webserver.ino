@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XDRV_01                               1
+#define XDRV_01_TICKS                         FUNC_TICK(FUNC_LOOP)
 
 #ifndef WIFI_SOFT_AP_CHANNEL
 #define WIFI_SOFT_AP_CHANNEL                  1          // Soft Access Point Channel number between 1 and 11 as used by WifiManager web GUI
@@ -1026,6 +1027,7 @@ void WSContentFlush(void)
 
 void _WSContentSendBuffer(void)
 {
+  ResponseReset();                                     // mqtt_data is used as scratch buffer
   int len = strlen(mqtt_data);
 
   if (0 == len) {                                  // No content
@@ -3241,6 +3243,7 @@ int WebSend(char *buffer)
             }
           }
           mqtt_data[j] = '\0';
+          ResponseReset();
           MqttPublishPrefixTopic_P(RESULT_OR_STAT, PSTR(D_CMND_WEBSEND));
 #ifdef USE_SCRIPT
 extern uint8_t tasm_cmd_activ;
@@ -3373,6 +3376,7 @@ void CmndWeblog(void)
 {
   if ((XdrvMailbox.payload >= LOG_LEVEL_NONE) && (XdrvMailbox.payload <= LOG_LEVEL_DEBUG_MORE)) {
     Settings.weblog_level = XdrvMailbox.payload;
+    UpdateLogLevelMax();
   }
   ResponseCmndNumber(Settings.weblog_level);
 }
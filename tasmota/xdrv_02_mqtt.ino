@@ -18,6 +18,7 @@
 */
 
 #define XDRV_02                2
+#define XDRV_02_TICKS          FUNC_TICK(FUNC_EVERY_50_MSECOND)
 
 // #define DEBUG_DUMP_TLS    // allow dumping of TLS Flash keys
 
@@ -37,7 +38,12 @@ const char kMqttCommands[] PROGMEM = "|"  // No prefix
 #endif
   D_CMND_MQTTHOST "|" D_CMND_MQTTPORT "|" D_CMND_MQTTRETRY "|" D_CMND_STATETEXT "|" D_CMND_MQTTCLIENT "|"
   D_CMND_FULLTOPIC "|" D_CMND_PREFIX "|" D_CMND_GROUPTOPIC "|" D_CMND_TOPIC "|" D_CMND_PUBLISH "|" D_CMND_MQTTLOG "|"
-  D_CMND_BUTTONTOPIC "|" D_CMND_SWITCHTOPIC "|" D_CMND_BUTTONRETAIN "|" D_CMND_SWITCHRETAIN "|" D_CMND_POWERRETAIN "|" D_CMND_SENSORRETAIN ;
+  D_CMND_BUTTONTOPIC "|" D_CMND_SWITCHTOPIC "|" D_CMND_BUTTONRETAIN "|" D_CMND_SWITCHRETAIN "|" D_CMND_POWERRETAIN "|" D_CMND_SENSORRETAIN "|"
+  D_CMND_MQTTQOS
+#ifdef USE_MQTT_CBOR
+  "|" D_CMND_MQTTCBOR
+#endif
+  ;
 
 void (* const MqttCommand[])(void) PROGMEM = {
 #if defined(USE_MQTT_TLS) && !defined(USE_MQTT_TLS_CA_CERT)
@@ -49,7 +55,28 @@ void (* const MqttCommand[])(void) PROGMEM = {
 #endif
   &CmndMqttHost, &CmndMqttPort, &CmndMqttRetry, &CmndStateText, &CmndMqttClient,
   &CmndFullTopic, &CmndPrefix, &CmndGroupTopic, &CmndTopic, &CmndPublish, &CmndMqttlog,
-  &CmndButtonTopic, &CmndSwitchTopic, &CmndButtonRetain, &CmndSwitchRetain, &CmndPowerRetain, &CmndSensorRetain };
+  &CmndButtonTopic, &CmndSwitchTopic, &CmndButtonRetain, &CmndSwitchRetain, &CmndPowerRetain, &CmndSensorRetain,
+  &CmndMqttQos
+#ifdef USE_MQTT_CBOR
+  , &CmndMqttCbor
+#endif
+  };
+
+const char kMqttQosClasses[] PROGMEM = "Stat|Tele|Result";
+
+enum MqttQosClasses { MQTT_QOS_STAT, MQTT_QOS_TELE, MQTT_QOS_RESULT, MQTT_QOS_NONE };
+
+#ifdef USE_MQTT_CBOR
+const char kMqttCborClasses[] PROGMEM = "Sensor|State|Result|Zigbee";
+const char kMqttCborTopics[] PROGMEM = D_RSLT_SENSOR "|" D_RSLT_STATE "|" D_RSLT_RESULT "|" D_JSON_ZIGBEEZCL_RECEIVED "|" D_JSON_ZIGBEE_STATE "|" D_JSON_ZIGBEE_RECEIVED;
+
+enum MqttCborClasses { MQTT_CBOR_SENSOR, MQTT_CBOR_STATE, MQTT_CBOR_RESULT, MQTT_CBOR_ZIGBEE, MQTT_CBOR_NONE };
+#endif  // USE_MQTT_CBOR
+
+const uint32_t MQTT_CONNECT_INTERVAL = 10;  // mSeconds between connection steps
+const uint32_t MQTT_TLS_TIMEOUT = 10000;    // mSeconds allowed for the TLS handshake
+
+enum MqttConnectSteps { MQTT_CONNECT_IDLE, MQTT_CONNECT_DNS, MQTT_CONNECT_TCP, MQTT_CONNECT_TLS, MQTT_CONNECT_MQTT, MQTT_CONNECT_CONNACK };
 
 struct MQTT {
   uint16_t connect_count = 0;            // MQTT re-connect count
@@ -58,6 +85,25 @@ struct MQTT {
   bool connected = false;                // MQTT virtual connection status
   bool allowed = false;                  // MQTT enabled and parameters valid
   bool mqtt_tls = false;                 // MQTT TLS is enabled
+  char *stream_data = nullptr;           // Parts of a payload larger than mqtt_data
+  uint32_t stream_length = 0;            // Length of stream_data
+  uint8_t stream_units = 0;              // RESPONSE_UNIT_xxx keys in stream_data
+  bool stream_capture = false;           // Hand over mqtt_data parts to stream_data
+  bool stream_full = false;              // Payload exceeds MQTT_STREAM_MAX_SIZE or memory
+  bool streaming = false;                // Streamed payload is being sent
+  uint8_t publish_class = MQTT_QOS_NONE; // MqttQosClasses of next publish
+#ifdef USE_MQTT_CBOR
+  bool cbor_zigbee = false;              // Next publish is a Zigbee message sent to RESULT
+#endif  // USE_MQTT_CBOR
+  uint8_t connect_step = 0;              // MqttConnectSteps
+  int8_t connect_timer = -1;             // Scheduler timer running MqttConnectStep
+  bool tls_resumed = false;              // TLS session of last connection was resumed
+  IPAddress broker_ip;                   // Resolved broker address
+  uint32_t connect_start = 0;            // Start of connection attempt
+  uint32_t step_start = 0;               // Start of TLS handshake
+  uint32_t connect_time = 0;             // Duration of last successful connection attempt in mS
+  uint32_t tcp_time = 0;                 // Duration of TCP connect in mS
+  uint32_t tls_time = 0;                 // Duration of TLS handshake in mS
 } Mqtt;
 
 #ifdef USE_MQTT_TLS
@@ -99,6 +145,68 @@ bool is_fingerprint_mono_value(uint8_t finger[20], uint8_t value) {
 	}
 	return true;
 }
+
+/*********************************************************************************************\
+ * TLS session cache
+ *
+ * The parameters of the last full handshake are offered to the broker on reconnect allowing
+ * an abbreviated handshake without certificate and key exchange. On ESP8266 they survive a
+ * restart in RTC user memory blocks 64 to 91 which are not used by OTA (0-31), the crash
+ * recorder (32-63) or RtcReboot and RtcSettings (92-127).
+\*********************************************************************************************/
+
+const uint16_t MQTT_TLS_SESSION_VALID = 0x5E55;
+const uint32_t MQTT_TLS_SESSION_RTC_OFFSET = 64;
+
+struct MQTT_TLS_SESSION {
+  uint16_t valid;                        // MQTT_TLS_SESSION_VALID
+  uint16_t port;                         // Broker port
+  uint32_t key;                          // Hash of broker host name and fingerprints
+  br_ssl_session_parameters params;
+} MqttTlsSession;
+
+uint32_t MqttTlsSessionKey(void)
+{
+  uint32_t key = GetHash(SettingsText(SET_MQTT_HOST), strlen(SettingsText(SET_MQTT_HOST)));
+  return key ^ GetHash((const char*)Settings.mqtt_fingerprint, sizeof(Settings.mqtt_fingerprint));
+}
+
+bool MqttTlsSessionValid(void)
+{
+#ifdef ESP8266
+  if (MqttTlsSession.valid != MQTT_TLS_SESSION_VALID) {
+    ESP.rtcUserMemoryRead(MQTT_TLS_SESSION_RTC_OFFSET, (uint32_t*)&MqttTlsSession, sizeof(MqttTlsSession));
+  }
+#endif
+  if ((MqttTlsSession.valid != MQTT_TLS_SESSION_VALID) ||
+      (MqttTlsSession.port != Settings.mqtt_port) ||
+      (MqttTlsSession.key != MqttTlsSessionKey())) {
+    return false;
+  }
+  return true;
+}
+
+void MqttTlsSessionStore(void)
+{
+#ifdef ESP8266
+  ESP.rtcUserMemoryWrite(MQTT_TLS_SESSION_RTC_OFFSET, (uint32_t*)&MqttTlsSession, sizeof(MqttTlsSession));
+#endif
+}
+
+void MqttTlsSessionSave(void)
+{
+  if (!tlsClient->getSession(&MqttTlsSession.params)) { return; }  // Server does not support resumption
+  MqttTlsSession.valid = MQTT_TLS_SESSION_VALID;
+  MqttTlsSession.port = Settings.mqtt_port;
+  MqttTlsSession.key = MqttTlsSessionKey();
+  MqttTlsSessionStore();
+}
+
+void MqttTlsSessionClear(void)
+{
+  memset(&MqttTlsSession, 0, sizeof(MqttTlsSession));
+  MqttTlsSessionStore();
+}
 #endif  // USE_MQTT_TLS
 
 void MakeValidMqtt(uint32_t option, char* str)
@@ -131,6 +239,9 @@ void MakeValidMqtt(uint32_t option, char* str)
  * void MqttDisconnect()
  * void MqttSubscribeLib(char *topic)
  * bool MqttPublishLib(const char* topic, bool retained)
+ * bool MqttPublishBeginLib(const char* topic, uint32_t length, bool retained)
+ * uint32_t MqttPublishWriteLib(const char* data, uint32_t length)
+ * bool MqttPublishEndLib(void)
 \*********************************************************************************************/
 
 #include <PubSubClient.h>
@@ -204,7 +315,7 @@ void MqttUnsubscribeLib(const char *topic)
   MqttClient.loop();  // Solve LmacRxBlk:1 messages
 }
 
-bool MqttPublishLib(const char* topic, bool retained)
+void MqttPublishLoopCheck(const char* topic)
 {
   // If Prefix1 equals Prefix2 disable next MQTT subscription to prevent loop
   if (!strcmp(SettingsText(SET_MQTTPREFIX1), SettingsText(SET_MQTTPREFIX2))) {
@@ -214,12 +325,272 @@ bool MqttPublishLib(const char* topic, bool retained)
       mqtt_cmnd_blocked++;
     }
   }
+}
+
+bool MqttPublishLib(const char* topic, bool retained)
+{
+  uint32_t publish_class = Mqtt.publish_class;
+  Mqtt.publish_class = MQTT_QOS_NONE;
+
+  if (Mqtt.streaming) { return false; }  // Do not interrupt a streamed payload
+
+  MqttPublishLoopCheck(topic);
+
+  const uint8_t* payload = (const uint8_t*)mqtt_data;
+  uint32_t payload_len = ResponseLength();
+#ifdef USE_MQTT_CBOR
+  uint8_t* cbor = nullptr;
+  if (('{' == mqtt_data[0]) && MqttCborSelected(topic)) {
+    cbor = CborFromJson(mqtt_data, &payload_len);  // nullptr if no valid JSON or low on memory
+    if (cbor) { payload = cbor; }
+    else { payload_len = ResponseLength(); }
+  }
+#endif  // USE_MQTT_CBOR
+
+  bool result;
+  if ((publish_class < MQTT_QOS_NONE) && bitRead(Settings.mqtt_qos_policy, publish_class)) {
+    result = MqttQosPublish(topic, payload, payload_len, retained);
+  } else {
+    result = MqttClient.publish(topic, payload, payload_len, retained);
+    yield();  // #3313
+  }
+#ifdef USE_MQTT_CBOR
+  free(cbor);
+#endif  // USE_MQTT_CBOR
+  return result;
+}
+
+#ifdef USE_MQTT_CBOR
+bool MqttCborSelected(const char* topic)
+{
+  // Payloads are sent as CBOR if the last topic level belongs to a class enabled with command MqttCbor
+  if (!Settings.mqtt_cbor) { return false; }
+  if (Mqtt.cbor_zigbee) { return bitRead(Settings.mqtt_cbor, MQTT_CBOR_ZIGBEE); }
+  const char* level = strrchr(topic, '/');
+  level = (level) ? level +1 : topic;
+  char stemp[16];
+  int index = GetCommandCode(stemp, sizeof(stemp), level, kMqttCborTopics);
+  if (index < 0) { return false; }
+  return bitRead(Settings.mqtt_cbor, (index > MQTT_CBOR_ZIGBEE) ? MQTT_CBOR_ZIGBEE : index);
+}
+#endif  // USE_MQTT_CBOR
+
+bool MqttPublishBeginLib(const char* topic, uint32_t length, bool retained)
+{
+  MqttPublishLoopCheck(topic);
+
+  return MqttClient.beginPublish(topic, length, retained);
+}
+
+uint32_t MqttPublishWriteLib(const char* data, uint32_t length)
+{
+  return MqttClient.write((const uint8_t*)data, length);
+}
+
+bool MqttPublishEndLib(void)
+{
+  bool result = MqttClient.endPublish();
+  yield();  // #3313
+  return result;
+}
+
+/*********************************************************************************************\
+ * QoS 1 outbound queue
+ *
+ * Messages of topic classes enabled with command MqttQos are queued in a byte ring and published
+ * with QoS 1. A message is removed from the queue when its PUBACK is received. Messages stay
+ * queued while the broker is unreachable and are sent again in order after a reconnect.
+ * Unacknowledged messages are repeated with the DUP flag after MQTT_QOS_RETRY_TIME. If the
+ * queue is full the oldest messages are dropped. Sending is done from the 50 mS tick so the
+ * main loop never waits for the broker. The queue is allocated on first use and released once
+ * it is empty with all classes back to QoS 0.
+\*********************************************************************************************/
+
+#ifndef MQTT_QOS_QUEUE_SIZE
+#define MQTT_QOS_QUEUE_SIZE        2048       // Size of outbound queue in bytes
+#endif
+#ifndef MQTT_QOS_INFLIGHT
+#define MQTT_QOS_INFLIGHT          8          // Max number of unacknowledged messages
+#endif
+#ifndef MQTT_QOS_RETRY_TIME
+#define MQTT_QOS_RETRY_TIME        10000      // mSeconds to wait for PUBACK before sending again
+#endif
+
+enum MqttQosFlags { MQTT_QOS_RETAINED = 1, MQTT_QOS_SENT = 2, MQTT_QOS_ACKED = 4 };
+
+typedef struct {
+  uint16_t size;                              // Record size including this header
+  uint16_t msg_id;                            // Packet identifier of last send
+  uint16_t flags;                             // MqttQosFlags
+  uint16_t topic_len;                         // Topic length including terminating zero
+  uint32_t sent;                              // millis() of last send
+} MqttQosRecord;                              // Followed by topic and payload
+
+struct MQTTQOS {
+  uint8_t *queue = nullptr;                   // Allocated while a topic class uses QoS 1
+  uint16_t head = 0;                          // Offset of oldest record
+  uint16_t used = 0;                          // Bytes in use
+  uint16_t count = 0;                         // Number of records
+  uint32_t queued = 0;                        // Messages queued
+  uint32_t acked = 0;                         // Messages acknowledged by the broker
+  uint32_t retried = 0;                       // Messages sent again
+  uint32_t dropped = 0;                       // Messages lost due to a full queue
+} MqttQos;
+
+void MqttQosCopy(uint32_t offset, void* data, uint32_t len, bool store)
+{
+  // Copy len bytes from (or to when store) queue offset relative to the oldest record
+  uint32_t start = (MqttQos.head + offset) % MQTT_QOS_QUEUE_SIZE;
+  uint32_t first = MQTT_QOS_QUEUE_SIZE - start;
+  if (first > len) { first = len; }
+  if (store) {
+    memcpy(MqttQos.queue + start, data, first);
+    memcpy(MqttQos.queue, (uint8_t*)data + first, len - first);
+  } else {
+    memcpy(data, MqttQos.queue + start, first);
+    memcpy((uint8_t*)data + first, MqttQos.queue, len - first);
+  }
+}
+
+void MqttQosRemoveOldest(void)
+{
+  MqttQosRecord record;
+  MqttQosCopy(0, &record, sizeof(record), false);
+  if (!(record.flags & MQTT_QOS_ACKED)) { MqttQos.dropped++; }
+  MqttQos.head = (MqttQos.head + record.size) % MQTT_QOS_QUEUE_SIZE;
+  MqttQos.used -= record.size;
+  MqttQos.count--;
+}
+
+void MqttQosTrim(void)
+{
+  // Remove acknowledged messages at the start of the queue
+  while (MqttQos.count) {
+    MqttQosRecord record;
+    MqttQosCopy(0, &record, sizeof(record), false);
+    if (!(record.flags & MQTT_QOS_ACKED)) { break; }
+    MqttQosRemoveOldest();
+  }
+  if (!MqttQos.count && !Settings.mqtt_qos_policy && MqttQos.queue) {
+    free(MqttQos.queue);
+    MqttQos.queue = nullptr;
+    MqttQos.head = 0;
+  }
+}
+
+bool MqttQosPublish(const char* topic, const uint8_t* payload, uint32_t payload_len, bool retained)
+{
+  MqttQosRecord record;
+  record.topic_len = strlen(topic) +1;
+  uint32_t size = sizeof(record) + record.topic_len + payload_len;
+  if (!MqttQos.queue) {
+    MqttQos.queue = (uint8_t*)malloc(MQTT_QOS_QUEUE_SIZE);
+  }
+  if (!MqttQos.queue || (size > MQTT_QOS_QUEUE_SIZE)) {
+    bool result = MqttClient.publish(topic, payload, payload_len, retained);  // No queue memory or too large to queue
+    yield();  // #3313
+    return result;
+  }
+
+  MqttQosTrim();
+  while (size > (uint32_t)(MQTT_QOS_QUEUE_SIZE - MqttQos.used)) {
+    MqttQosRemoveOldest();
+  }
+  record.size = size;
+  record.msg_id = 0;
+  record.flags = (retained) ? MQTT_QOS_RETAINED : 0;
+  record.sent = 0;
+  MqttQosCopy(MqttQos.used, &record, sizeof(record), true);
+  MqttQosCopy(MqttQos.used + sizeof(record), (void*)topic, record.topic_len, true);
+  MqttQosCopy(MqttQos.used + sizeof(record) + record.topic_len, (void*)payload, payload_len, true);
+  MqttQos.used += size;
+  MqttQos.count++;
+  MqttQos.queued++;
+
+  MqttQosSend();
+  return true;
+}
 
-  bool result = MqttClient.publish(topic, mqtt_data, retained);
+bool MqttQosSendRecord(uint32_t offset, bool dup)
+{
+  MqttQosRecord record;
+  MqttQosCopy(offset, &record, sizeof(record), false);
+  char topic[record.topic_len];
+  MqttQosCopy(offset + sizeof(record), topic, record.topic_len, false);
+  uint32_t payload_len = record.size - sizeof(record) - record.topic_len;
+  if (!dup) { record.msg_id = MqttClient.newMsgId(); }
+
+  MqttPublishLoopCheck(topic);
+  if (!MqttClient.beginPublish(topic, payload_len, record.flags & MQTT_QOS_RETAINED, record.msg_id, dup)) { return false; }
+  uint32_t start = (MqttQos.head + offset + sizeof(record) + record.topic_len) % MQTT_QOS_QUEUE_SIZE;
+  uint32_t first = MQTT_QOS_QUEUE_SIZE - start;
+  if (first > payload_len) { first = payload_len; }
+  MqttClient.write(MqttQos.queue + start, first);
+  MqttClient.write(MqttQos.queue, payload_len - first);
+  bool result = MqttClient.endPublish();
   yield();  // #3313
+
+  record.flags |= MQTT_QOS_SENT;
+  record.sent = millis();
+  MqttQosCopy(offset, &record, sizeof(record), true);
   return result;
 }
 
+void MqttQosSend(void)
+{
+  // Send queued messages in order within the inflight window and repeat unacknowledged ones
+  if (!MqttQos.count || Mqtt.streaming || !MqttClient.connected()) { return; }
+
+  uint32_t inflight = 0;
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < MqttQos.count; i++) {
+    MqttQosRecord record;
+    MqttQosCopy(offset, &record, sizeof(record), false);
+    if (!(record.flags & MQTT_QOS_ACKED)) {
+      if (!(record.flags & MQTT_QOS_SENT)) {
+        if (inflight >= MQTT_QOS_INFLIGHT) { break; }
+        if (!MqttQosSendRecord(offset, false)) { break; }
+      } else if (TimePassedSince(record.sent) > MQTT_QOS_RETRY_TIME) {
+        if (!MqttQosSendRecord(offset, true)) { break; }
+        MqttQos.retried++;
+      }
+      inflight++;
+    }
+    offset += record.size;
+  }
+}
+
+void MqttQosAck(uint16_t msg_id)
+{
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < MqttQos.count; i++) {
+    MqttQosRecord record;
+    MqttQosCopy(offset, &record, sizeof(record), false);
+    if ((record.msg_id == msg_id) && ((record.flags & (MQTT_QOS_SENT | MQTT_QOS_ACKED)) == MQTT_QOS_SENT)) {
+      record.flags |= MQTT_QOS_ACKED;
+      MqttQosCopy(offset, &record, sizeof(record), true);
+      MqttQos.acked++;
+      break;
+    }
+    offset += record.size;
+  }
+  MqttQosTrim();
+}
+
+void MqttQosConnected(void)
+{
+  // A new session does not know our packet identifiers so send all unacknowledged messages as new
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < MqttQos.count; i++) {
+    MqttQosRecord record;
+    MqttQosCopy(offset, &record, sizeof(record), false);
+    record.flags &= ~MQTT_QOS_SENT;
+    MqttQosCopy(offset, &record, sizeof(record), true);
+    offset += record.size;
+  }
+  MqttQosSend();
+}
+
 void MqttDataHandler(char* mqtt_topic, uint8_t* mqtt_data, unsigned int data_len)
 {
 #ifdef USE_DEBUG_DRIVER
@@ -238,33 +609,78 @@ void MqttDataHandler(char* mqtt_topic, uint8_t* mqtt_data, unsigned int data_len
     }
   }
 
-  // Save MQTT data ASAP as it's data is discarded by PubSubClient with next publish as used in MQTTlog
-  char topic[TOPSZ];
-  strlcpy(topic, mqtt_topic, sizeof(topic));
+  uint32_t topic_len = strlen(mqtt_topic);
+  if (topic_len >= TOPSZ) { topic_len = TOPSZ -1; }
   mqtt_data[data_len] = 0;
+  ResponseReset();                                        // Payload was received into mqtt_data
+
+  uint32_t json_len = data_len;
+#ifdef USE_MQTT_CBOR
+  if (Settings.mqtt_cbor && CborIsPayload(mqtt_data, data_len)) {  // Only when CBOR is enabled as binary payloads may start alike
+    int32_t len = CborToJson(mqtt_data, data_len, nullptr, 0);  // Decode CBOR commands and rule data as JSON
+    if ((len < 0) || (len >= MQTT_MAX_PACKET_SIZE)) {
+      AddLog_P2(LOG_LEVEL_DEBUG, PSTR(D_LOG_MQTT "Invalid CBOR payload on %s"), mqtt_topic);
+      return;
+    }
+    json_len = len;
+  }
+#endif  // USE_MQTT_CBOR
 
-  char data[data_len +1];
-
-  memcpy(data, mqtt_data, sizeof(data));
-  AddLog_P2(LOG_LEVEL_DEBUG_MORE, PSTR(D_LOG_MQTT D_DATA_SIZE " %d, \"%s %s\""), data_len, topic, RemoveControlCharacter(data));
-//  if (LOG_LEVEL_DEBUG_MORE <= seriallog_level) { Serial.println(data); }
-
-  memcpy(data, mqtt_data, sizeof(data));
+  // Save MQTT data ASAP as it's data is discarded by PubSubClient with next publish as used in MQTTlog
+  // Topic and payload are copied once into a single stack buffer used by all consumers. The topic
+  // keeps TOPSZ bytes as drivers like Domoticz rewrite it in place
+  char message[TOPSZ + json_len +1];
+  char* topic = message;
+  memcpy(topic, mqtt_topic, topic_len);
+  topic[topic_len] = '\0';
+  char* data = message + TOPSZ;
+  MqttDataCopy(data, json_len +1, mqtt_data, data_len);
+  data_len = json_len;
+
+  if (LOG_LEVEL_DEBUG_MORE <= log_level_max) {
+    MqttDataLog(topic, data, data_len);
+  }
 
   // MQTT pre-processing
-  XdrvMailbox.index = strlen(topic);
+  XdrvMailbox.index = topic_len;
   XdrvMailbox.data_len = data_len;
   XdrvMailbox.topic = topic;
-  XdrvMailbox.data = (char*)data;
-  if (XdrvCall(FUNC_MQTT_DATA)) { return; }
-
-  ShowSource(SRC_MQTT);
+  XdrvMailbox.data = data;
+  MqttTopicMatch(topic);                 // Resolve group topic and subscription consumers once
+  if (!XdrvCall(FUNC_MQTT_DATA)) {
+    ShowSource(SRC_MQTT);
 
-  CommandHandler(topic, data, data_len);
+    CommandHandler(topic, data, data_len);
+  }
+  MqttTopicMatch(nullptr);
 }
 
 /*********************************************************************************************/
 
+void MqttDataLog(const char* topic, const char* data, uint32_t data_len)
+{
+  // Render the received message into log_data leaving out control characters
+  uint32_t len = snprintf_P(log_data, sizeof(log_data), PSTR(D_LOG_MQTT D_DATA_SIZE " %d, \"%s "), data_len, topic);
+  if (len > sizeof(log_data) -2) { len = sizeof(log_data) -2; }
+  for (uint32_t i = 0; (i < data_len) && (len < sizeof(log_data) -2); i++) {
+    if (!iscntrl(data[i])) { log_data[len++] = data[i]; }
+  }
+  log_data[len++] = '"';
+  log_data[len] = '\0';
+  AddLog(LOG_LEVEL_DEBUG_MORE);
+}
+
+void MqttDataCopy(char* data, uint32_t size, uint8_t* mqtt_data, uint32_t data_len)
+{
+#ifdef USE_MQTT_CBOR
+  if (Settings.mqtt_cbor && CborIsPayload(mqtt_data, data_len)) {
+    CborToJson(mqtt_data, data_len, data, size);
+    return;
+  }
+#endif  // USE_MQTT_CBOR
+  memcpy(data, mqtt_data, size);
+}
+
 void MqttRetryCounter(uint8_t value)
 {
   Mqtt.retry_counter = value;
@@ -282,8 +698,241 @@ void MqttUnsubscribe(const char *topic)
   MqttUnsubscribeLib(topic);
 }
 
+/*********************************************************************************************\
+ * Topic subscription registry
+ *
+ * Topic filters of group topics and rule or script subscriptions are kept in a trie with one
+ * node per topic level supporting + and # wildcards. MqttDataHandler resolves an inbound topic
+ * to the tags (owner and id) of all its consumers in one pass before the drivers are called.
+ *
+ * Example:
+ *   MqttTopicAdd("tele/+/SENSOR", MQTT_TOPIC_RULES, id);
+ *   for (uint32_t i = 0; i < MqttTopics.matches; i++) {
+ *     int32_t id = MqttTopicMatchId(i, MQTT_TOPIC_RULES);  // -1 if consumer of other owner
+ *   }
+ *   MqttTopicRemove(MQTT_TOPIC_RULES, id);
+\*********************************************************************************************/
+
+const uint32_t MQTT_TOPIC_MATCHES = 8;       // Max consumers of one inbound topic
+const uint32_t MQTT_TOPIC_GROW = 8;          // Nodes or consumers added when full
+
+enum MqttTopicOwners { MQTT_TOPIC_NONE, MQTT_TOPIC_GROUP, MQTT_TOPIC_RULES, MQTT_TOPIC_SCRIPT };
+
+typedef struct {
+  char *level;                               // Topic level, nullptr = free (except root)
+  uint16_t child;                            // First node of next level, 0 = none
+  uint16_t next;                             // Next node of same level, 0 = none
+  uint16_t consumer;                         // First consumer of filter ending here, 0 = none
+} MqttTopicNode;
+
+typedef struct {
+  uint16_t tag;                              // Owner << 8 | id, 0 = free
+  uint16_t next;                             // Next consumer of same node, 0 = none
+} MqttTopicConsumer;
+
+struct MQTTTOPICS {
+  MqttTopicNode *node = nullptr;             // node[0] is the root
+  MqttTopicConsumer *consumer = nullptr;     // consumer[0] is unused
+  const char *topic = nullptr;               // Inbound topic being handled
+  uint16_t nodes = 0;                        // Allocated nodes
+  uint16_t consumers = 0;                    // Allocated consumers
+  uint16_t match[MQTT_TOPIC_MATCHES];        // Consumer tags of inbound topic
+  uint8_t matches = 0;
+  bool overflow = false;                     // More consumers than MQTT_TOPIC_MATCHES
+} MqttTopics;
+
+bool MqttTopicGrowNodes(void)
+{
+  // Add MQTT_TOPIC_GROW free nodes. The first allocation provides the root node[0] without level
+  MqttTopicNode *node = (MqttTopicNode*)realloc(MqttTopics.node, (MqttTopics.nodes + MQTT_TOPIC_GROW) * sizeof(MqttTopicNode));
+  if (!node) { return false; }
+  memset(node + MqttTopics.nodes, 0, MQTT_TOPIC_GROW * sizeof(MqttTopicNode));
+  MqttTopics.node = node;
+  MqttTopics.nodes += MQTT_TOPIC_GROW;
+  return true;
+}
+
+uint32_t MqttTopicNewNode(const char* level, uint32_t len)
+{
+  // Returns index of a new node or 0 if out of memory
+  uint32_t index = 1;
+  while ((index < MqttTopics.nodes) && MqttTopics.node[index].level) { index++; }
+  if ((index >= MqttTopics.nodes) && !MqttTopicGrowNodes()) { return 0; }
+  char *name = (char*)malloc(len +1);
+  if (!name) { return 0; }
+  memcpy(name, level, len);
+  name[len] = '\0';
+  memset(&MqttTopics.node[index], 0, sizeof(MqttTopicNode));
+  MqttTopics.node[index].level = name;
+  return index;
+}
+
+uint32_t MqttTopicNewConsumer(void)
+{
+  // Returns index of a free consumer or 0 if out of memory
+  uint32_t index = 1;
+  while ((index < MqttTopics.consumers) && MqttTopics.consumer[index].tag) { index++; }
+  if (index >= MqttTopics.consumers) {
+    MqttTopicConsumer *consumer = (MqttTopicConsumer*)realloc(MqttTopics.consumer, (MqttTopics.consumers + MQTT_TOPIC_GROW) * sizeof(MqttTopicConsumer));
+    if (!consumer) { return 0; }
+    memset(consumer + MqttTopics.consumers, 0, MQTT_TOPIC_GROW * sizeof(MqttTopicConsumer));
+    MqttTopics.consumer = consumer;
+    MqttTopics.consumers += MQTT_TOPIC_GROW;
+  }
+  return index;
+}
+
+bool MqttTopicAdd(const char* filter, uint32_t owner, uint32_t id)
+{
+  // Add consumer owner with id (0..255) to topic filter
+  if (!MqttTopics.nodes && !MqttTopicGrowNodes()) { return false; }  // Allocate root
+  uint32_t parent = 0;
+  const char *level = filter;
+  while (true) {
+    const char *end = strchr(level, '/');
+    uint32_t len = (end) ? end - level : strlen(level);
+    uint32_t node = MqttTopics.node[parent].child;
+    while (node && ((strlen(MqttTopics.node[node].level) != len) || strncmp(MqttTopics.node[node].level, level, len))) {
+      node = MqttTopics.node[node].next;
+    }
+    if (!node) {
+      node = MqttTopicNewNode(level, len);
+      if (!node) { return false; }
+      MqttTopics.node[node].next = MqttTopics.node[parent].child;
+      MqttTopics.node[parent].child = node;
+    }
+    parent = node;
+    if (!end) { break; }
+    level = end +1;
+  }
+  uint32_t consumer = MqttTopicNewConsumer();
+  if (!consumer) { return false; }
+  MqttTopics.consumer[consumer].tag = (owner << 8) | (id & 0xFF);
+  MqttTopics.consumer[consumer].next = MqttTopics.node[parent].consumer;
+  MqttTopics.node[parent].consumer = consumer;
+  return true;
+}
+
+bool MqttTopicPrune(uint32_t index)
+{
+  // Free unused nodes below index. Returns true if index itself is unused
+  uint16_t *link = &MqttTopics.node[index].child;
+  while (*link) {
+    uint32_t child = *link;
+    if (MqttTopicPrune(child)) {
+      *link = MqttTopics.node[child].next;
+      free(MqttTopics.node[child].level);
+      MqttTopics.node[child].level = nullptr;
+    } else {
+      link = &MqttTopics.node[child].next;
+    }
+  }
+  return (!MqttTopics.node[index].child && !MqttTopics.node[index].consumer);
+}
+
+void MqttTopicRemove(uint32_t owner, int32_t id)
+{
+  // Remove consumers of owner with id or with any id if id < 0
+  for (uint32_t i = 0; i < MqttTopics.nodes; i++) {
+    uint16_t *link = &MqttTopics.node[i].consumer;
+    while (*link) {
+      MqttTopicConsumer *consumer = &MqttTopics.consumer[*link];
+      if (((consumer->tag >> 8) == owner) && ((id < 0) || ((consumer->tag & 0xFF) == id))) {
+        consumer->tag = 0;
+        *link = consumer->next;
+      } else {
+        link = &consumer->next;
+      }
+    }
+  }
+  if (MqttTopics.nodes) { MqttTopicPrune(0); }
+}
+
+uint32_t MqttTopicFreeId(uint32_t owner)
+{
+  // Returns lowest id not in use by owner
+  uint32_t id = 0;
+  for (uint32_t i = 1; i < MqttTopics.consumers; i++) {
+    if (MqttTopics.consumer[i].tag == ((owner << 8) | id)) {
+      id++;
+      i = 0;                                 // Start over with next id
+    }
+  }
+  return id;
+}
+
+void MqttTopicAddMatches(uint32_t node)
+{
+  for (uint32_t i = MqttTopics.node[node].consumer; i; i = MqttTopics.consumer[i].next) {
+    if (MqttTopics.matches < MQTT_TOPIC_MATCHES) {
+      MqttTopics.match[MqttTopics.matches++] = MqttTopics.consumer[i].tag;
+    }
+    else if (!MqttTopics.overflow) {
+      MqttTopics.overflow = true;
+      AddLog_P2(LOG_LEVEL_ERROR, PSTR(D_LOG_MQTT "Topic %s has more than %d subscribers, ignoring the rest"), MqttTopics.topic, MQTT_TOPIC_MATCHES);
+    }
+  }
+}
+
+void MqttTopicMatchLevel(uint32_t parent, const char* level, bool wildcards)
+{
+  // Match inbound topic from level on with the children of parent
+  const char *end = strchr(level, '/');
+  uint32_t len = (end) ? end - level : strlen(level);
+  for (uint32_t node = MqttTopics.node[parent].child; node; node = MqttTopics.node[node].next) {
+    const char *name = MqttTopics.node[node].level;
+    if (!strcmp_P(name, PSTR("#"))) {
+      if (wildcards) { MqttTopicAddMatches(node); }
+    }
+    else if ((wildcards && !strcmp_P(name, PSTR("+"))) || ((strlen(name) == len) && !strncmp(name, level, len))) {
+      if (end) {
+        MqttTopicMatchLevel(node, end +1, true);
+      } else {
+        MqttTopicAddMatches(node);
+        for (uint32_t child = MqttTopics.node[node].child; child; child = MqttTopics.node[child].next) {
+          if (!strcmp_P(MqttTopics.node[child].level, PSTR("#"))) {
+            MqttTopicAddMatches(child);      // Filter a/# also matches topic a
+          }
+        }
+      }
+    }
+  }
+}
+
+void MqttTopicMatch(const char* topic)
+{
+  // Resolve consumers of inbound topic or clear them if nullptr
+  MqttTopics.topic = topic;
+  MqttTopics.matches = 0;
+  MqttTopics.overflow = false;
+  if (topic && MqttTopics.nodes) {
+    MqttTopicMatchLevel(0, topic, ('$' != topic[0]));  // Topics starting with $ are not matched by wildcards
+  }
+}
+
+int32_t MqttTopicMatchId(uint32_t index, uint32_t owner)
+{
+  // Returns id of consumer index of inbound topic if it is from owner else -1
+  if ((index < MqttTopics.matches) && ((MqttTopics.match[index] >> 8) == owner)) {
+    return MqttTopics.match[index] & 0xFF;
+  }
+  return -1;
+}
+
+bool MqttTopicGroupMatch(const char* topic)
+{
+  // Returns true if topic is the inbound topic and matches a group topic
+  if (topic != MqttTopics.topic) { return false; }
+  for (uint32_t i = 0; i < MqttTopics.matches; i++) {
+    if (MqttTopicMatchId(i, MQTT_TOPIC_GROUP) >= 0) { return true; }
+  }
+  return false;
+}
+
 void MqttPublishLogging(const char *mxtime)
 {
+  if (Mqtt.streaming) { return; }        // Do not interrupt a streamed payload
+
   char saved_mqtt_data[strlen(mqtt_data) +1];
   memcpy(saved_mqtt_data, mqtt_data, sizeof(saved_mqtt_data));
 
@@ -294,6 +943,7 @@ void MqttPublishLogging(const char *mxtime)
   MqttPublishLib(stopic, false);
 
   memcpy(mqtt_data, saved_mqtt_data, sizeof(saved_mqtt_data));
+  ResponseReset();
 }
 
 void MqttPublish(const char* topic, bool retained)
@@ -350,13 +1000,31 @@ void MqttPublishPrefixTopic_P(uint32_t prefix, const char* subtopic, bool retain
   char romram[64];
   char stopic[TOPSZ];
 
-  snprintf_P(romram, sizeof(romram), ((prefix > 3) && !Settings.flag.mqtt_response) ? S_RSLT_RESULT : subtopic);  // SetOption4 - Switch between MQTT RESULT or COMMAND
+  snprintf_P(romram, sizeof(romram), subtopic);
+#ifdef USE_MQTT_CBOR
+  char stemp[16];
+  Mqtt.cbor_zigbee = (GetCommandCode(stemp, sizeof(stemp), romram, kMqttCborTopics) >= MQTT_CBOR_ZIGBEE);  // Zigbee class also when sent to RESULT
+#endif  // USE_MQTT_CBOR
+  if ((prefix > 3) && !Settings.flag.mqtt_response) {  // SetOption4 - Switch between MQTT RESULT or COMMAND
+    strcpy_P(romram, S_RSLT_RESULT);
+  }
   for (uint32_t i = 0; i < strlen(romram); i++) {
     romram[i] = toupper(romram[i]);
   }
   prefix &= 3;
   GetTopic_P(stopic, prefix, mqtt_topic, romram);
-  MqttPublish(stopic, retained);
+  Mqtt.publish_class = (!strcmp_P(romram, S_RSLT_RESULT)) ? MQTT_QOS_RESULT : (STAT == prefix) ? MQTT_QOS_STAT : (TELE == prefix) ? MQTT_QOS_TELE : MQTT_QOS_NONE;
+  bool published = false;
+#ifdef USE_TELE_DELTA
+  published = TeleDeltaPublish(prefix, romram, stopic, retained);  // Changed keys only in delta mode
+#endif  // USE_TELE_DELTA
+  if (!published) {
+    MqttPublish(stopic, retained);
+  }
+  Mqtt.publish_class = MQTT_QOS_NONE;
+#ifdef USE_MQTT_CBOR
+  Mqtt.cbor_zigbee = false;
+#endif  // USE_MQTT_CBOR
 
 #if defined(USE_MQTT_AWS_IOT) || defined(USE_MQTT_AWS_IOT_LIGHT)
   if ((prefix > 0) && (Settings.flag4.awsiot_shadow) && (Mqtt.connected)) {    // placeholder for SetOptionXX
@@ -407,7 +1075,172 @@ void MqttPublishPrefixTopicRulesProcess_P(uint32_t prefix, const char* subtopic)
 
 void MqttPublishTeleSensor(void)
 {
-  MqttPublishPrefixTopicRulesProcess_P(TELE, PSTR(D_RSLT_SENSOR), Settings.flag.mqtt_sensor_retain);  // CMND_SENSORRETAIN
+  MqttPublishPrefixTopicStream_P(TELE, PSTR(D_RSLT_SENSOR), Settings.flag.mqtt_sensor_retain);  // CMND_SENSORRETAIN
+  XdrvRulesProcess();
+}
+
+/*********************************************************************************************\
+ * Streaming publish of payloads larger than mqtt_data
+ *
+ * The payload is rendered once. Between MqttStreamBegin() and MqttStreamEnd() the JSON parts
+ * built in mqtt_data are handed over to a growing heap buffer by MqttPublishChunk(), which is
+ * called after each driver's FUNC_JSON_APPEND, once mqtt_data is half full.
+ * MqttPublishPrefixTopicStream_P() then publishes the buffer in one go, transcoded to CBOR if
+ * selected. MqttStreamEnd() leaves the start of the payload in mqtt_data, like an unstreamed
+ * truncated payload, for rules and display.
+ *
+ * The producers are not idempotent so the payload can not be rendered twice to send it without
+ * a buffer. The buffer is limited to MQTT_STREAM_MAX_SIZE. A larger payload is published
+ * truncated to mqtt_data as without streaming.
+\*********************************************************************************************/
+
+#ifndef MQTT_STREAM_MAX_SIZE
+#ifdef ESP8266
+#define MQTT_STREAM_MAX_SIZE       4096       // Max streamed payload size in bytes
+#else
+#define MQTT_STREAM_MAX_SIZE       16384      // Max streamed payload size in bytes
+#endif
+#endif
+
+void MqttStreamFree(void)
+{
+  free(Mqtt.stream_data);
+  Mqtt.stream_data = nullptr;
+  Mqtt.stream_length = 0;
+  Mqtt.stream_units = 0;
+  Mqtt.stream_full = false;
+}
+
+void MqttStreamBegin(void)
+{
+  MqttStreamFree();
+  Mqtt.stream_capture = true;
+}
+
+bool MqttStreamAppend(void)
+{
+  // Move mqtt_data to the end of stream_data
+  if (Mqtt.stream_full) { return false; }
+  uint32_t len = ResponseLength();
+  if (!len) { return true; }
+  char *data = nullptr;
+  if (Mqtt.stream_length + len < MQTT_STREAM_MAX_SIZE) {
+    data = (char*)realloc(Mqtt.stream_data, Mqtt.stream_length + len +1);
+  }
+  if (!data) {
+    AddLog_P2(LOG_LEVEL_ERROR, PSTR(D_LOG_MQTT "Unable to stream %d bytes, max %d"), Mqtt.stream_length + len, MQTT_STREAM_MAX_SIZE -1);
+    Mqtt.stream_full = true;
+    Mqtt.stream_capture = false;         // Continue in mqtt_data, truncated if too large
+    return false;
+  }
+  memcpy(data + Mqtt.stream_length, mqtt_data, len +1);
+  Mqtt.stream_data = data;
+  Mqtt.stream_length += len;
+  Mqtt.stream_units |= ResponseUnits();  // Keep unit keys found in previous parts
+  ResponseClear();
+  return true;
+}
+
+void MqttPublishChunk(void)
+{
+  if (Mqtt.stream_capture && (ResponseLength() > sizeof(mqtt_data) / 2)) {
+    MqttStreamAppend();
+  }
+}
+
+uint32_t MqttStreamLength(void)
+{
+  return Mqtt.stream_length;
+}
+
+uint32_t MqttStreamUnits(void)
+{
+  return Mqtt.stream_units;
+}
+
+void MqttStreamView(void)
+{
+  // Show the start of the joined payload in mqtt_data
+  strlcpy(mqtt_data, Mqtt.stream_data, sizeof(mqtt_data));
+  ResponseReset();
+  ResponseSetLength(Mqtt.stream_length, 0);
+}
+
+void MqttStreamShowSensor(void)
+{
+  // Call FUNC_SHOW_SENSOR with the start of the payload in mqtt_data as if it was not streamed
+  if (Mqtt.stream_data) {
+    MqttStreamAppend();                  // A payload too large to stream ends at its start too
+    MqttStreamView();
+    XdrvCall(FUNC_SHOW_SENSOR);
+    ResponseClear();                     // Continue after the joined parts
+  } else {
+    XdrvCall(FUNC_SHOW_SENSOR);
+  }
+}
+
+void MqttStreamEnd(void)
+{
+  // Stop handing over parts and leave the start of the payload in mqtt_data
+  Mqtt.stream_capture = false;
+  if (Mqtt.stream_data) {
+    MqttStreamAppend();
+    MqttStreamView();
+    MqttStreamFree();
+  }
+}
+
+bool MqttPublishStream(const char* topic, bool retained)
+{
+  if (Settings.flag4.mqtt_no_retain) {
+    retained = false;   // Some brokers don't support retained, they will disconnect if received
+  }
+
+  uint32_t length = Mqtt.stream_length;
+  bool cbor = false;
+#ifdef USE_MQTT_CBOR
+  if (MqttCborSelected(topic)) {
+    CborBegin(nullptr, 0, CBOR_OUT_COUNT);
+    CborPut(Mqtt.stream_data, Mqtt.stream_length);
+    cbor = CborEnd();                    // Stream as is if no valid JSON
+    if (cbor) { length = Cbor.length; }
+  }
+#endif  // USE_MQTT_CBOR
+
+  bool result = false;
+  Mqtt.streaming = true;
+  if (MqttPublishBeginLib(topic, length, retained)) {
+    if (cbor) {
+#ifdef USE_MQTT_CBOR
+      CborBegin(nullptr, 0, CBOR_OUT_MQTT);
+      CborPut(Mqtt.stream_data, Mqtt.stream_length);
+      CborEnd();
+#endif  // USE_MQTT_CBOR
+    } else {
+      MqttPublishWriteLib(Mqtt.stream_data, Mqtt.stream_length);
+    }
+    result = MqttPublishEndLib();
+  }
+  Mqtt.streaming = false;
+
+  AddLog_P2(LOG_LEVEL_INFO, PSTR("%s%s = %d bytes streamed%s"), (result) ? D_LOG_MQTT : D_LOG_RESULT, topic, length,
+    (retained) ? " (" D_RETAINED ")" : "");
+  return result;
+}
+
+void MqttPublishPrefixTopicStream_P(uint32_t prefix, const char* subtopic, bool retained)
+{
+  // Publish mqtt_data or, if rendered between MqttStreamBegin and MqttStreamEnd, the whole payload. Only for prefix CMND, STAT or TELE
+  if (Mqtt.stream_data && MqttStreamAppend() && (Mqtt.stream_length >= sizeof(mqtt_data)) &&
+      Settings.flag.mqtt_enabled && MqttIsConnected()) {  // SetOption3 - Enable MQTT
+    char stopic[TOPSZ];
+    GetTopic_P(stopic, prefix, mqtt_topic, subtopic);
+    MqttPublishStream(stopic, retained);
+    MqttStreamEnd();                     // Start of payload for rules
+    return;
+  }
+  MqttStreamEnd();
+  MqttPublishPrefixTopic_P(prefix, subtopic, retained);
 }
 
 void MqttPublishPowerState(uint32_t device)
@@ -475,6 +1308,13 @@ uint16_t MqttConnectCount(void)
   return Mqtt.connect_count;
 }
 
+void MqttShowConnectTimes(void)
+{
+  // Append duration of last connection attempt and its TCP and TLS parts in mSeconds
+  ResponseAppend_P(PSTR(",\"Connect\":{\"Time\":%u,\"Tcp\":%u,\"Tls\":%u,\"Resumed\":%d}"),
+    Mqtt.connect_time, Mqtt.tcp_time, Mqtt.tls_time, Mqtt.tls_resumed);
+}
+
 void MqttDisconnected(int state)
 {
   Mqtt.connected = false;
@@ -496,6 +1336,8 @@ void MqttConnected(void)
     Mqtt.retry_counter = 0;
     Mqtt.connect_count++;
 
+    MqttQosConnected();
+
     GetTopic_P(stopic, TELE, mqtt_topic, S_LWT);
     Response_P(PSTR(MQTT_LWT_ONLINE));
     MqttPublish(stopic, true);
@@ -508,6 +1350,7 @@ void MqttConnected(void)
 
     GetTopic_P(stopic, CMND, mqtt_topic, PSTR("#"));
     MqttSubscribe(stopic);
+    MqttTopicRemove(MQTT_TOPIC_GROUP, -1);
     if (strstr_P(SettingsText(SET_MQTT_FULLTOPIC), MQTT_TOKEN_TOPIC) != nullptr) {
       uint32_t real_index = SET_MQTT_GRP_TOPIC;
       for (uint32_t i = 0; i < MAX_GROUP_TOPICS; i++) {
@@ -515,6 +1358,7 @@ void MqttConnected(void)
         if (strlen(SettingsText(real_index +i))) {
           GetGroupTopic_P(stopic, PSTR("#"), real_index +i);  // SetOption75 0: %prefix%/nothing/%topic% = cmnd/nothing/<grouptopic>/# or SetOption75 1: cmnd/<grouptopic>
           MqttSubscribe(stopic);
+          MqttTopicAdd(stopic, MQTT_TOPIC_GROUP, i);
         }
       }
       GetFallbackTopic_P(stopic, PSTR("#"));
@@ -569,8 +1413,6 @@ void MqttConnected(void)
 
 void MqttReconnect(void)
 {
-  char stopic[TOPSZ];
-
   Mqtt.allowed = Settings.flag.mqtt_enabled;  // SetOption3 - Enable MQTT
   if (Mqtt.allowed) {
 #ifdef USE_DISCOVERY
@@ -605,18 +1447,6 @@ void MqttReconnect(void)
   Mqtt.retry_counter = Settings.mqtt_retry;
   global_state.mqtt_down = 1;
 
-  char *mqtt_user = nullptr;
-  char *mqtt_pwd = nullptr;
-  if (strlen(SettingsText(SET_MQTT_USER))) {
-    mqtt_user = SettingsText(SET_MQTT_USER);
-  }
-  if (strlen(SettingsText(SET_MQTT_PWD))) {
-    mqtt_pwd = SettingsText(SET_MQTT_PWD);
-  }
-
-  GetTopic_P(stopic, TELE, mqtt_topic, S_LWT);
-  Response_P(S_LWT_OFFLINE);
-
   if (MqttClient.connected()) { MqttClient.disconnect(); }
 #ifdef USE_MQTT_TLS
   if (Mqtt.mqtt_tls) {
@@ -635,6 +1465,7 @@ void MqttReconnect(void)
   }
 
   MqttClient.setCallback(MqttDataHandler);
+  MqttClient.setPubackCallback(MqttQosAck);
 #if defined(USE_MQTT_TLS) && defined(USE_MQTT_AWS_IOT)
   // re-assign private keys in case it was updated in between
   if (Mqtt.mqtt_tls) {
@@ -647,117 +1478,231 @@ void MqttReconnect(void)
 #endif
   MqttClient.setServer(SettingsText(SET_MQTT_HOST), Settings.mqtt_port);
 
-  uint32_t mqtt_connect_time = millis();
 #if defined(USE_MQTT_TLS) && !defined(USE_MQTT_TLS_CA_CERT)
-  bool allow_all_fingerprints;
-  bool learn_fingerprint1;
-  bool learn_fingerprint2;
   if (Mqtt.mqtt_tls) {
-    allow_all_fingerprints = false;
-    learn_fingerprint1 = is_fingerprint_mono_value(Settings.mqtt_fingerprint[0], 0x00);
-    learn_fingerprint2 = is_fingerprint_mono_value(Settings.mqtt_fingerprint[1], 0x00);
+    bool allow_all_fingerprints = false;
     allow_all_fingerprints |= is_fingerprint_mono_value(Settings.mqtt_fingerprint[0], 0xff);
     allow_all_fingerprints |= is_fingerprint_mono_value(Settings.mqtt_fingerprint[1], 0xff);
-    allow_all_fingerprints |= learn_fingerprint1;
-    allow_all_fingerprints |= learn_fingerprint2;
+    allow_all_fingerprints |= is_fingerprint_mono_value(Settings.mqtt_fingerprint[0], 0x00);  // Learn fingerprint
+    allow_all_fingerprints |= is_fingerprint_mono_value(Settings.mqtt_fingerprint[1], 0x00);  // Learn fingerprint
     tlsClient->setPubKeyFingerprint(Settings.mqtt_fingerprint[0], Settings.mqtt_fingerprint[1], allow_all_fingerprints);
   }
 #endif
-  bool lwt_retain = Settings.flag4.mqtt_no_retain ? false : true;   // no retained last will if "no_retain"
-#if defined(USE_MQTT_TLS) && defined(USE_MQTT_AWS_IOT)
-  if (Mqtt.mqtt_tls) {
-    if ((nullptr != AWS_IoT_Private_Key) && (nullptr != AWS_IoT_Client_Certificate)) {
-      // if private key is there, we remove user/pwd
-      mqtt_user = nullptr;
-      mqtt_pwd  = nullptr;
+
+  MqttConnectEnd();                         // Abort a connection attempt in progress
+  Mqtt.connect_step = MQTT_CONNECT_DNS;
+  Mqtt.connect_start = millis();
+  Mqtt.connect_timer = SchedulerAdd(&MqttConnectStep, MQTT_CONNECT_INTERVAL, 0);
+  if (Mqtt.connect_timer < 0) {             // No free timer so connect blocking
+    while (Mqtt.connect_step) {
+      MqttConnectStep();
+      delay(0);
     }
   }
-#endif
+}
+
+void MqttConnectEnd(void)
+{
+  SchedulerRemove(Mqtt.connect_timer);
+  Mqtt.connect_timer = -1;
+  Mqtt.connect_step = MQTT_CONNECT_IDLE;
+}
 
-  if (MqttClient.connect(mqtt_client, mqtt_user, mqtt_pwd, stopic, 1, lwt_retain, mqtt_data, MQTT_CLEAN_SESSION)) {
+void MqttConnectFailed(void)
+{
+  MqttConnectEnd();
+  MqttDisconnected(MqttClient.state());     // status codes are documented here http://pubsubclient.knolleary.net/api.html#state
+}
+
+void MqttConnectStep(void)
+{
+  // Connect in steps to keep the loop running while waiting for the broker
+  switch (Mqtt.connect_step) {
+    case MQTT_CONNECT_DNS:
+      if (!WiFi.hostByName(SettingsText(SET_MQTT_HOST), Mqtt.broker_ip)) {
+        MqttConnectFailed();
+        return;
+      }
+      Mqtt.connect_step = MQTT_CONNECT_TCP;
+      break;
+    case MQTT_CONNECT_TCP: {
+      uint32_t tcp_start = millis();
+      bool connected;
 #ifdef USE_MQTT_TLS
-    if (Mqtt.mqtt_tls) {
-      AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "TLS connected in %d ms, max ThunkStack used %d"),
-        millis() - mqtt_connect_time, tlsClient->getMaxThunkStackUse());
-      if (!tlsClient->getMFLNStatus()) {
-        AddLog_P(LOG_LEVEL_INFO, S_LOG_MQTT, PSTR("MFLN not supported by TLS server"));
+      if (Mqtt.mqtt_tls) {
+        tlsClient->setSession((MqttTlsSessionValid()) ? &MqttTlsSession.params : nullptr);
+        connected = tlsClient->connectStart(Mqtt.broker_ip, Settings.mqtt_port, SettingsText(SET_MQTT_HOST));
+      } else
+#endif
+      {
+        connected = EspClient.connect(Mqtt.broker_ip, Settings.mqtt_port);
       }
-#ifndef USE_MQTT_TLS_CA_CERT  // don't bother with fingerprints if using CA validation
-// **** Start patch Castellucci
-/*
-    // create a printable version of the fingerprint received
-    char buf_fingerprint[64];
-    ToHex_P((unsigned char *)tlsClient->getRecvPubKeyFingerprint(), 20, buf_fingerprint, sizeof(buf_fingerprint), ' ');
-    AddLog_P2(LOG_LEVEL_DEBUG, PSTR(D_LOG_MQTT "Server fingerprint: %s"), buf_fingerprint);
-
-    if (learn_fingerprint1 || learn_fingerprint2) {
-      // we potentially need to learn the fingerprint just seen
-      bool fingerprint_matched = false;
-      const uint8_t *recv_fingerprint = tlsClient->getRecvPubKeyFingerprint();
-      if (0 == memcmp(recv_fingerprint, Settings.mqtt_fingerprint[0], 20)) {
-        fingerprint_matched = true;
+      Mqtt.step_start = millis();
+      Mqtt.tcp_time = Mqtt.step_start - tcp_start;
+      Mqtt.tls_time = 0;
+      Mqtt.tls_resumed = false;
+      if (!connected) {
+#ifdef USE_MQTT_TLS
+        if (Mqtt.mqtt_tls) {
+          AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "TLS connection error: %d"), tlsClient->getLastError());
+        }
+#endif
+        MqttConnectFailed();
+        return;
       }
-      if (0 == memcmp(recv_fingerprint, Settings.mqtt_fingerprint[1], 20)) {
-        fingerprint_matched = true;
+#ifdef USE_MQTT_TLS
+      Mqtt.connect_step = (Mqtt.mqtt_tls) ? MQTT_CONNECT_TLS : MQTT_CONNECT_MQTT;
+#else
+      Mqtt.connect_step = MQTT_CONNECT_MQTT;
+#endif
+      break;
+    }
+#ifdef USE_MQTT_TLS
+    case MQTT_CONNECT_TLS: {
+      int result = tlsClient->connectRun();  // Process received handshake records
+      if (!result && (TimePassedSince(Mqtt.step_start) < MQTT_TLS_TIMEOUT)) { return; }
+      if (result <= 0) {
+        AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "TLS connection error: %d"), tlsClient->getLastError());
+        MqttTlsSessionClear();              // Do not offer a failing session again
+        tlsClient->stop();
+        MqttConnectFailed();
+        return;
       }
-      if (!fingerprint_matched) {
-        // we had no match, so we need to change all fingerprints ready to learn
-        if (learn_fingerprint1) {
-          memcpy(Settings.mqtt_fingerprint[0], recv_fingerprint, 20);
-        }
-        if (learn_fingerprint2) {
-          memcpy(Settings.mqtt_fingerprint[1], recv_fingerprint, 20);
+      Mqtt.tls_time = TimePassedSince(Mqtt.step_start);
+      Mqtt.tls_resumed = tlsClient->isResumed();
+      Mqtt.connect_step = MQTT_CONNECT_MQTT;
+      break;
+    }
+#endif  // USE_MQTT_TLS
+    case MQTT_CONNECT_MQTT: {
+      char stopic[TOPSZ];
+      char *mqtt_user = nullptr;
+      char *mqtt_pwd = nullptr;
+      if (strlen(SettingsText(SET_MQTT_USER))) {
+        mqtt_user = SettingsText(SET_MQTT_USER);
+      }
+      if (strlen(SettingsText(SET_MQTT_PWD))) {
+        mqtt_pwd = SettingsText(SET_MQTT_PWD);
+      }
+#if defined(USE_MQTT_TLS) && defined(USE_MQTT_AWS_IOT)
+      if (Mqtt.mqtt_tls) {
+        if ((nullptr != AWS_IoT_Private_Key) && (nullptr != AWS_IoT_Client_Certificate)) {
+          // if private key is there, we remove user/pwd
+          mqtt_user = nullptr;
+          mqtt_pwd  = nullptr;
         }
-        AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "Fingerprint learned: %s"), buf_fingerprint);
-
-        SettingsSaveAll();  // save settings
       }
+#endif
+      bool lwt_retain = Settings.flag4.mqtt_no_retain ? false : true;   // no retained last will if "no_retain"
+      GetTopic_P(stopic, TELE, mqtt_topic, S_LWT);
+      Response_P(S_LWT_OFFLINE);
+      if (!MqttClient.connectSend(mqtt_client, mqtt_user, mqtt_pwd, stopic, 1, lwt_retain, mqtt_data, MQTT_CLEAN_SESSION)) {
+        MqttConnectFailed();
+        return;
+      }
+      Mqtt.connect_step = MQTT_CONNECT_CONNACK;
+      break;
     }
-*/
-      const uint8_t *recv_fingerprint = tlsClient->getRecvPubKeyFingerprint();
-      // create a printable version of the fingerprint received
-      char buf_fingerprint[64];
-      ToHex_P(recv_fingerprint, 20, buf_fingerprint, sizeof(buf_fingerprint), ' ');
-      AddLog_P2(LOG_LEVEL_DEBUG, PSTR(D_LOG_MQTT "Server fingerprint: %s"), buf_fingerprint);
-
-      bool learned = false;
-
-      // If the fingerprint slot is marked for update, we'll do so.
-      // Otherwise, if the fingerprint slot had the magic trust-on-first-use
-      // value, we will save the current fingerprint there, but only if the other fingerprint slot
-      // *didn't* match it.
-      if (recv_fingerprint[20] & 0x1 || (learn_fingerprint1 && 0 != memcmp(recv_fingerprint, Settings.mqtt_fingerprint[1], 20))) {
-        memcpy(Settings.mqtt_fingerprint[0], recv_fingerprint, 20);
-        learned = true;
+    case MQTT_CONNECT_CONNACK: {
+      int result = MqttClient.connectPoll();
+      if (!result) { return; }
+      if (result < 0) {
+        MqttConnectFailed();
+        return;
       }
-      // As above, but for the other slot.
-      if (recv_fingerprint[20] & 0x2 || (learn_fingerprint2 && 0 != memcmp(recv_fingerprint, Settings.mqtt_fingerprint[0], 20))) {
-        memcpy(Settings.mqtt_fingerprint[1], recv_fingerprint, 20);
-        learned = true;
+      MqttConnectEnd();
+      Mqtt.connect_time = TimePassedSince(Mqtt.connect_start);
+#ifdef USE_MQTT_TLS
+      if (Mqtt.mqtt_tls) {
+        MqttTlsConnected();
       }
+#endif
+      MqttConnected();
+      break;
+    }
+  }
+}
 
-      if (learned) {
-        AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "Fingerprint learned: %s"), buf_fingerprint);
+#ifdef USE_MQTT_TLS
+void MqttTlsConnected(void)
+{
+  AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "TLS connected in %d ms%s, max ThunkStack used %d"),
+    Mqtt.tls_time, (Mqtt.tls_resumed) ? " (resumed)" : "", tlsClient->getMaxThunkStackUse());
+  if (!tlsClient->getMFLNStatus()) {
+    AddLog_P(LOG_LEVEL_INFO, S_LOG_MQTT, PSTR("MFLN not supported by TLS server"));
+  }
+  if (Mqtt.tls_resumed) { return; }         // No server certificate received on an abbreviated handshake
 
-        SettingsSaveAll();  // save settings
-      }
-  // **** End patch Castellucci
-#endif // !USE_MQTT_TLS_CA_CERT
+#ifndef USE_MQTT_TLS_CA_CERT  // don't bother with fingerprints if using CA validation
+  bool learn_fingerprint1 = is_fingerprint_mono_value(Settings.mqtt_fingerprint[0], 0x00);
+  bool learn_fingerprint2 = is_fingerprint_mono_value(Settings.mqtt_fingerprint[1], 0x00);
+// **** Start patch Castellucci
+/*
+  // create a printable version of the fingerprint received
+  char buf_fingerprint[64];
+  ToHex_P((unsigned char *)tlsClient->getRecvPubKeyFingerprint(), 20, buf_fingerprint, sizeof(buf_fingerprint), ' ');
+  AddLog_P2(LOG_LEVEL_DEBUG, PSTR(D_LOG_MQTT "Server fingerprint: %s"), buf_fingerprint);
+
+  if (learn_fingerprint1 || learn_fingerprint2) {
+    // we potentially need to learn the fingerprint just seen
+    bool fingerprint_matched = false;
+    const uint8_t *recv_fingerprint = tlsClient->getRecvPubKeyFingerprint();
+    if (0 == memcmp(recv_fingerprint, Settings.mqtt_fingerprint[0], 20)) {
+      fingerprint_matched = true;
     }
-#endif // USE_MQTT_TLS
-    MqttConnected();
-  } else {
-#ifdef USE_MQTT_TLS
-    if (Mqtt.mqtt_tls) {
-      AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "TLS connection error: %d"), tlsClient->getLastError());
+    if (0 == memcmp(recv_fingerprint, Settings.mqtt_fingerprint[1], 20)) {
+      fingerprint_matched = true;
     }
-#endif
-    MqttDisconnected(MqttClient.state());  // status codes are documented here http://pubsubclient.knolleary.net/api.html#state
+    if (!fingerprint_matched) {
+      // we had no match, so we need to change all fingerprints ready to learn
+      if (learn_fingerprint1) {
+        memcpy(Settings.mqtt_fingerprint[0], recv_fingerprint, 20);
+      }
+      if (learn_fingerprint2) {
+        memcpy(Settings.mqtt_fingerprint[1], recv_fingerprint, 20);
+      }
+      AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "Fingerprint learned: %s"), buf_fingerprint);
+
+      SettingsSaveAll();  // save settings
+    }
+  }
+*/
+  const uint8_t *recv_fingerprint = tlsClient->getRecvPubKeyFingerprint();
+  // create a printable version of the fingerprint received
+  char buf_fingerprint[64];
+  ToHex_P(recv_fingerprint, 20, buf_fingerprint, sizeof(buf_fingerprint), ' ');
+  AddLog_P2(LOG_LEVEL_DEBUG, PSTR(D_LOG_MQTT "Server fingerprint: %s"), buf_fingerprint);
+
+  bool learned = false;
+
+  // If the fingerprint slot is marked for update, we'll do so.
+  // Otherwise, if the fingerprint slot had the magic trust-on-first-use
+  // value, we will save the current fingerprint there, but only if the other fingerprint slot
+  // *didn't* match it.
+  if (recv_fingerprint[20] & 0x1 || (learn_fingerprint1 && 0 != memcmp(recv_fingerprint, Settings.mqtt_fingerprint[1], 20))) {
+    memcpy(Settings.mqtt_fingerprint[0], recv_fingerprint, 20);
+    learned = true;
   }
+  // As above, but for the other slot.
+  if (recv_fingerprint[20] & 0x2 || (learn_fingerprint2 && 0 != memcmp(recv_fingerprint, Settings.mqtt_fingerprint[0], 20))) {
+    memcpy(Settings.mqtt_fingerprint[1], recv_fingerprint, 20);
+    learned = true;
+  }
+
+  if (learned) {
+    AddLog_P2(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT "Fingerprint learned: %s"), buf_fingerprint);
+
+    SettingsSaveAll();  // save settings
+  }
+// **** End patch Castellucci
+#endif // !USE_MQTT_TLS_CA_CERT
+  MqttTlsSessionSave();                     // Offer this session on next connect
 }
+#endif  // USE_MQTT_TLS
 
 void MqttCheck(void)
 {
+  if (Mqtt.connect_step) { return; }        // Connection attempt in progress
   if (Settings.flag.mqtt_enabled) {  // SetOption3 - Enable MQTT
     if (!MqttIsConnected()) {
       global_state.mqtt_down = 1;
@@ -833,6 +1778,7 @@ void CmndMqttlog(void)
 {
   if ((XdrvMailbox.payload >= LOG_LEVEL_NONE) && (XdrvMailbox.payload <= LOG_LEVEL_DEBUG_MORE)) {
     Settings.mqttlog_level = XdrvMailbox.payload;
+    UpdateLogLevelMax();
   }
   ResponseCmndNumber(Settings.mqttlog_level);
 }
@@ -864,6 +1810,43 @@ void CmndMqttRetry(void)
   ResponseCmndNumber(Settings.mqtt_retry);
 }
 
+void CmndMqttQos(void)
+{
+  // MqttQos1 1 - Publish stat topics with QoS 1
+  // MqttQos2 1 - Publish tele topics with QoS 1
+  // MqttQos3 1 - Publish RESULT topics with QoS 1
+  if (XdrvMailbox.usridx && (XdrvMailbox.index > 0) && (XdrvMailbox.index <= MQTT_QOS_NONE) && (XdrvMailbox.payload >= 0) && (XdrvMailbox.payload <= 1)) {
+    bitWrite(Settings.mqtt_qos_policy, XdrvMailbox.index -1, XdrvMailbox.payload);
+    MqttQosTrim();                       // Release queue if no longer used
+  }
+  Response_P(PSTR("{\"%s\":{"), XdrvMailbox.command);
+  for (uint32_t i = 0; i < MQTT_QOS_NONE; i++) {
+    char stemp[10];
+    ResponseAppend_P(PSTR("\"%s\":%d,"), GetTextIndexed(stemp, sizeof(stemp), i, kMqttQosClasses), bitRead(Settings.mqtt_qos_policy, i));
+  }
+  ResponseAppend_P(PSTR("\"Pending\":%d,\"Queued\":%u,\"Acked\":%u,\"Retried\":%u,\"Dropped\":%u}}"),
+    MqttQos.count, MqttQos.queued, MqttQos.acked, MqttQos.retried, MqttQos.dropped);
+}
+
+#ifdef USE_MQTT_CBOR
+void CmndMqttCbor(void)
+{
+  // MqttCbor1 1 - Publish SENSOR topics as CBOR
+  // MqttCbor2 1 - Publish STATE topics as CBOR
+  // MqttCbor3 1 - Publish RESULT topics as CBOR
+  // MqttCbor4 1 - Publish ZbState, ZbReceived and ZbZCLReceived messages as CBOR, also when sent to RESULT
+  if (XdrvMailbox.usridx && (XdrvMailbox.index > 0) && (XdrvMailbox.index <= MQTT_CBOR_NONE) && (XdrvMailbox.payload >= 0) && (XdrvMailbox.payload <= 1)) {
+    bitWrite(Settings.mqtt_cbor, XdrvMailbox.index -1, XdrvMailbox.payload);
+  }
+  Response_P(PSTR("{\"%s\":{"), XdrvMailbox.command);
+  for (uint32_t i = 0; i < MQTT_CBOR_NONE; i++) {
+    char stemp[10];
+    ResponseAppend_P(PSTR("%s\"%s\":%d"), (i) ? "," : "", GetTextIndexed(stemp, sizeof(stemp), i, kMqttCborClasses), bitRead(Settings.mqtt_cbor, i));
+  }
+  ResponseJsonEndEnd();
+}
+#endif  // USE_MQTT_CBOR
+
 void CmndStateText(void)
 {
   if ((XdrvMailbox.index > 0) && (XdrvMailbox.index <= MAX_STATE_TEXT)) {
@@ -933,7 +1916,7 @@ void CmndPublish(void)
       char stemp1[TOPSZ];
       strlcpy(stemp1, mqtt_part, sizeof(stemp1));
       if ((payload_part != nullptr) && strlen(payload_part)) {
-        strlcpy(mqtt_data, payload_part, sizeof(mqtt_data));
+        Response_P(PSTR("%s"), payload_part);
       } else {
         mqtt_data[0] = '\0';
       }
@@ -1388,6 +2371,7 @@ bool Xdrv02(uint8_t function)
         break;
       case FUNC_EVERY_50_MSECOND:  // https://github.com/knolleary/pubsubclient/issues/556
         MqttClient.loop();
+        MqttQosSend();
         break;
 #ifdef USE_WEBSERVER
       case FUNC_WEB_ADD_BUTTON:
@@ -23,7 +23,9 @@
 \*********************************************************************************************/
 
 #define XDRV_03                3
+#define XDRV_03_TICKS          (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_250_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 #define XSNS_03                3
+#define XSNS_03_TICKS          FUNC_TICK(FUNC_EVERY_SECOND)
 
 //#define USE_ENERGY_MARGIN_DETECTION
 //  #define USE_ENERGY_POWER_LIMIT
@@ -58,6 +58,7 @@ def ir_expand(ir_compact):
 \*********************************************************************************************/
 
 #define XDRV_05             5
+#define XDRV_05_TICKS       FUNC_TICK(FUNC_EVERY_50_MSECOND)
 
 #include <IRremoteESP8266.h>
 #include <IRsend.h>
@@ -320,7 +321,7 @@ void IrReceiveCheck(void)
             prev_number = true;
           }
           ir_high = !ir_high;
-          if (strlen(mqtt_data) > sizeof(mqtt_data) - 40) { break; }  // Quit if char string becomes too long
+          if (ResponseLength() > sizeof(mqtt_data) - 40) { break; }  // Quit if char string becomes too long
         }
         uint16_t extended_length = getCorrectedRawLength(&results);
         ResponseAppend_P(PSTR("\",\"" D_JSON_IR_RAWDATA "Info\":[%d,%d,%d]"), extended_length, i -1, results.overflow);
@@ -20,6 +20,7 @@
 #ifdef USE_DOMOTICZ
 
 #define XDRV_07             7
+#define XDRV_07_TICKS       FUNC_TICK(FUNC_EVERY_SECOND)
 
 //#define D_PRFX_DOMOTICZ "Domoticz"
 #define D_PRFX_DOMOTICZ "Dz"
@@ -384,6 +385,7 @@ void DomoticzSensor(uint8_t idx, char *data) {
     memcpy(dmess, mqtt_data, sizeof(dmess));
     DomoticzSendData(idx, Settings.domoticz_sensor_idx[idx], data);
     memcpy(mqtt_data, dmess, sizeof(dmess));
+    ResponseReset();
   }
 }
 
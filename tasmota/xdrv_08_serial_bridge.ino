@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XDRV_08                    8
+#define XDRV_08_TICKS              FUNC_TICK(FUNC_LOOP)
 #define HARDWARE_FALLBACK          2
 
 const uint8_t SERIAL_BRIDGE_BUFFER_SIZE = 130;
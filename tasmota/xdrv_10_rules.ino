@@ -66,6 +66,7 @@
 \*********************************************************************************************/
 
 #define XDRV_10             10
+#define XDRV_10_TICKS       (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_100_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #include <unishox.h>
 
@@ -150,6 +151,7 @@ void (* const RulesCommand[])(void) PROGMEM = {
     String Event;
     String Topic;
     String Key;
+    uint8_t Id;                           // Consumer id in MQTT topic registry
   } MQTT_Subscription;
   LinkedList<MQTT_Subscription> subscriptions;
 #endif  // SUPPORT_MQTT_EVENT
@@ -173,6 +175,27 @@ struct RULES {
   char event_data[100];
 } Rules;
 
+enum RuleTriggerFlags { RULE_TRIGGER_TELE = 1, RULE_TRIGGER_BREAK = 2, RULE_TRIGGER_BACKLOG = 4, RULE_TRIGGER_VARIABLE = 8 };
+
+typedef struct {
+  uint16_t expr;                           // Offset of trigger expression like "TELE-INA219#CURRENT>0.100" in names
+  uint16_t name;                           // Offset of event key path like "INA219#CURRENT" in names
+  uint16_t param;                          // Offset of compare operand like "0.100" or "%VAR1%" in names
+  uint16_t commands;                       // Offset of commands in rule text
+  uint16_t commands_len;
+  float value;                             // Compare operand value if not a %variable%
+  int8_t compare;                          // COMPARE_OPERATOR_xxx
+  uint8_t index;                           // Array index of "CURRENT[1]" or 0
+  uint8_t flags;                           // RuleTriggerFlags
+} RuleTrigger;
+
+struct RULES_COMPILED {
+  RuleTrigger *trigger = nullptr;
+  char *names = nullptr;                   // Upper case trigger expressions, key paths and operands
+  uint8_t count = 0;
+  bool valid = false;                      // Compiled from current rule text
+} RulesCompiled[MAX_RULE_SETS];
+
 char rules_vars[MAX_RULE_VARS][33] = {{ 0 }};
 
 #if (MAX_RULE_VARS>16)
@@ -320,6 +343,7 @@ int32_t SetRule_compress(uint32_t idx, const char *in, size_t in_len, char *out,
 //   >= 0 : the actual stored size
 //   <0 : not enough space
 int32_t SetRule(uint32_t idx, const char *content, bool append = false) {
+  RulesCompiled[idx].valid = false;          // Compile trigger table on next event
   if (nullptr == content) { content = ""; }   // if nullptr, use empty string
   size_t len_in = strlen(content);
   bool needsCompress = false;
@@ -401,151 +425,222 @@ int32_t SetRule(uint32_t idx, const char *content, bool append = false) {
 
 /*******************************************************************************************/
 
-bool RulesRuleMatch(uint8_t rule_set, String &event, String &rule)
-{
-  // event = {"INA219":{"Voltage":4.494,"Current":0.020,"Power":0.089}}
-  // event = {"System":{"Boot":1}}
-  // rule = "INA219#CURRENT>0.100"
-
-  bool match = false;
-  char stemp[10];
+/*******************************************************************************************/
+/*
+ * Rule trigger table
+ *
+ * A rule set is compiled into a table of triggers when it is first processed after it has been
+ * changed. A trigger holds the upper case trigger expression, event key path, compare operator
+ * and operand and the offset of its commands in the rule text. Events are parsed once and each
+ * trigger is matched by looking up its key path. The rule text is only read when a trigger matches.
+ */
+/*******************************************************************************************/
 
-  // Step1: Analyse rule
-  String rule_expr = rule;                             // "TELE-INA219#CURRENT>0.100"
-  if (Rules.teleperiod) {
-    int ppos = rule_expr.indexOf("TELE-");             // "TELE-INA219#CURRENT>0.100" or "INA219#CURRENT>0.100"
-    if (ppos == -1) { return false; }                  // No pre-amble in rule
-    rule_expr = rule.substring(5);                     // "INA219#CURRENT>0.100" or "SYSTEM#BOOT"
+float RulesOperandValue(const char* operand)
+{
+  int temp_value = GetStateNumber((char*)operand);
+  if (temp_value > -1) {
+    return temp_value;
   }
+  return CharToFloat(operand);                           // 0.1      - This saves 9k code over toFLoat()!
+}
 
-  String rule_name, rule_param;
-  int8_t compareOperator = parseCompareExpression(rule_expr, rule_name, rule_param);  // Parse the compare expression.Return operator and the left, right part of expression
-
-  // rule_name  = "INA219#CURRENT"
-  // rule_param = "0.100" or "%VAR1%"
-
-//AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: expr %s, name %s, param %s"), rule_expr.c_str(), rule_name.c_str(), rule_param.c_str());
-
-  char rule_svalue[80] = { 0 };
-  float rule_value = 0;
-  if (compareOperator != COMPARE_OPERATOR_NONE) {
-    for (uint32_t i = 0; i < MAX_RULE_VARS; i++) {
-      snprintf_P(stemp, sizeof(stemp), PSTR("%%VAR%d%%"), i +1);
-      if (rule_param.startsWith(stemp)) {
-        rule_param = rules_vars[i];
-        break;
+float RulesOperand(const char* param, char* svalue, uint32_t size)
+{
+  // Resolve operand like "%VAR1%" into upper case svalue and return its value
+  String operand = param;
+  if (!strncmp_P(param, PSTR("%VAR"), 4) || !strncmp_P(param, PSTR("%MEM"), 4)) {
+    char* end;
+    uint32_t index = strtoul(param + 4, &end, 10);
+    if ('%' == *end) {
+      if (('V' == param[1]) && (index > 0) && (index <= MAX_RULE_VARS)) {
+        operand = rules_vars[index -1];
       }
-    }
-    for (uint32_t i = 0; i < MAX_RULE_MEMS; i++) {
-      snprintf_P(stemp, sizeof(stemp), PSTR("%%MEM%d%%"), i +1);
-      if (rule_param.startsWith(stemp)) {
-        rule_param = SettingsText(SET_MEM1 + i);
-        break;
+      else if (('M' == param[1]) && (index > 0) && (index <= MAX_RULE_MEMS)) {
+        operand = SettingsText(SET_MEM1 + index -1);
       }
     }
-    if (rule_param.startsWith(F("%TIME%"))) {
-      rule_param = String(MinutesPastMidnight());
-    }
-    if (rule_param.startsWith(F("%UPTIME%"))) {
-      rule_param = String(MinutesUptime());
-    }
-    if (rule_param.startsWith(F("%TIMESTAMP%"))) {
-      rule_param = GetDateAndTime(DT_LOCAL).c_str();
-    }
+  }
+  else if (!strncmp_P(param, PSTR("%TIME%"), 6)) {
+    operand = String(MinutesPastMidnight());
+  }
+  else if (!strncmp_P(param, PSTR("%UPTIME%"), 8)) {
+    operand = String(MinutesUptime());
+  }
+  else if (!strncmp_P(param, PSTR("%TIMESTAMP%"), 11)) {
+    operand = GetDateAndTime(DT_LOCAL);
+  }
 #if defined(USE_TIMERS) && defined(USE_SUNRISE)
-    if (rule_param.startsWith(F("%SUNRISE%"))) {
-      rule_param = String(SunMinutes(0));
-    }
-    if (rule_param.startsWith(F("%SUNSET%"))) {
-      rule_param = String(SunMinutes(1));
-    }
-#endif  // USE_TIMERS and USE_SUNRISE
-// #ifdef USE_ZIGBEE
-//     if (rule_param.startsWith(F("%ZBDEVICE%"))) {
-//       snprintf_P(stemp, sizeof(stemp), PSTR("0x%04X"), Z_GetLastDevice());
-//       rule_param = String(stemp);
-//     }
-//     if (rule_param.startsWith(F("%ZBGROUP%"))) {
-//       rule_param = String(Z_GetLastGroup());
-//     }
-//     if (rule_param.startsWith(F("%ZBCLUSTER%"))) {
-//       rule_param = String(Z_GetLastCluster());
-//     }
-//     if (rule_param.startsWith(F("%ZBENDPOINT%"))) {
-//       rule_param = String(Z_GetLastEndpoint());
-//     }
-// #endif
-    rule_param.toUpperCase();
-    strlcpy(rule_svalue, rule_param.c_str(), sizeof(rule_svalue));
-
-    int temp_value = GetStateNumber(rule_svalue);
-    if (temp_value > -1) {
-      rule_value = temp_value;
-    } else {
-      rule_value = CharToFloat((char*)rule_svalue);    // 0.1      - This saves 9k code over toFLoat()!
-    }
+  else if (!strncmp_P(param, PSTR("%SUNRISE%"), 9)) {
+    operand = String(SunMinutes(0));
   }
-
-  // Step2: Search rule_name
-  int pos;
-  int rule_name_idx = 0;
-  if ((pos = rule_name.indexOf("[")) > 0) {            // "SUBTYPE1#CURRENT[1]"
-    rule_name_idx = rule_name.substring(pos +1).toInt();
-    if ((rule_name_idx < 1) || (rule_name_idx > 6)) {  // Allow indexes 1 to 6
-      rule_name_idx = 1;
-    }
-    rule_name = rule_name.substring(0, pos);           // "SUBTYPE1#CURRENT"
+  else if (!strncmp_P(param, PSTR("%SUNSET%"), 8)) {
+    operand = String(SunMinutes(1));
   }
+#endif  // USE_TIMERS and USE_SUNRISE
+  operand.toUpperCase();
+  strlcpy(svalue, operand.c_str(), size);
+  return RulesOperandValue(svalue);
+}
 
-  String buf = event;   // copy the string into a new buffer that will be modified
+void RulesFreeTriggers(uint32_t rule_set)
+{
+  free(RulesCompiled[rule_set].trigger);
+  free(RulesCompiled[rule_set].names);
+  RulesCompiled[rule_set].trigger = nullptr;
+  RulesCompiled[rule_set].names = nullptr;
+  RulesCompiled[rule_set].count = 0;
+}
 
-//AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: RulesRuleMatch |%s|"), buf.c_str());
+void RulesCompile(uint32_t rule_set)
+{
+  RulesFreeTriggers(rule_set);
+  RulesCompiled[rule_set].valid = true;
+
+  String rules = GetRule(rule_set);
+  rules.toUpperCase();                                    // "ON INA219#CURRENT>0.100 DO BACKLOG DIMMER 10;COLOR 100000 ENDON"
+  const char* text = rules.c_str();
+  uint32_t len = rules.length();
+  if (!len) { return; }
+  uint32_t names_size = len * 2 +3;                       // Trigger expression, name and operand of each rule
+  char* names = (char*)malloc(names_size);
+  if (!names) { return; }
+  uint32_t names_len = 0;
+  RuleTrigger* triggers = nullptr;
+  uint32_t count = 0;
+
+  uint32_t pos = 0;
+  while (true) {
+    while (isspace(text[pos])) { pos++; }
+    const char* rule = text + pos;
+    if (strncmp_P(rule, PSTR("ON "), 3)) { break; }       // Bad syntax - Nothing to start on or no more rules
+    if (count >= 32) {                                    // Once flags support 32 triggers
+      AddLog_P2(LOG_LEVEL_ERROR, PSTR("RUL: Rule%d has more than 32 triggers, ignoring the rest"), rule_set +1);
+      break;
+    }
+    const char* pdo = strstr_P(rule, PSTR(" DO "));
+    if (!pdo) { break; }                                  // Bad syntax - Nothing to do
+    const char* endon = strstr_P(rule, PSTR(" ENDON"));
+    const char* brk = strstr_P(rule, PSTR(" BREAK"));
+    if (!endon && !brk) { break; }                        // Bad syntax - No ENDON neither BREAK
+    const char* end = (!endon || (brk && (brk < endon))) ? brk : endon;
+    if (end < pdo) { break; }
+
+    if (!(count % 4)) {
+      RuleTrigger* grown = (RuleTrigger*)realloc(triggers, (count + 4) * sizeof(RuleTrigger));
+      if (!grown) { break; }
+      triggers = grown;
+    }
+    RuleTrigger* trigger = &triggers[count];
+    memset(trigger, 0, sizeof(RuleTrigger));
+    if (end == brk) { trigger->flags |= RULE_TRIGGER_BREAK; }  // Stop execution of this rule set when triggered
+
+    uint32_t start = pdo - text +4;                       // "BACKLOG DIMMER 10;COLOR 100000"
+    uint32_t stop = end - text;
+    while ((start < stop) && isspace(text[start])) { start++; }
+    while ((stop > start) && isspace(text[stop -1])) { stop--; }
+    trigger->commands = start;
+    trigger->commands_len = stop - start;
+    // Use Backlog with event to prevent rule event loop exception unless IF is used which uses an implicit backlog
+    String ucommand = rules.substring(start, stop);
+    if ((ucommand.indexOf("IF ") == -1) &&
+        (ucommand.indexOf("EVENT ") != -1) &&
+        (ucommand.indexOf("BACKLOG ") == -1)) {
+      trigger->flags |= RULE_TRIGGER_BACKLOG;
+    }
+
+    String expr = rules.substring(pos +3, pdo - text);    // "TELE-INA219#CURRENT[1]>%VAR1%"
+    String name, param;
+    trigger->compare = parseCompareExpression(expr, name, param);
+    name.trim();
+    if (name.startsWith(F("TELE-"))) {
+      trigger->flags |= RULE_TRIGGER_TELE;
+      name = name.substring(5);                           // "INA219#CURRENT[1]"
+    }
+    int bracket = name.indexOf("[");
+    if (bracket > 0) {
+      int index = name.substring(bracket +1).toInt();
+      trigger->index = ((index < 1) || (index > 6)) ? 1 : index;  // Allow indexes 1 to 6
+      name = name.substring(0, bracket);                  // "INA219#CURRENT"
+    }
+    if (names_len + expr.length() + name.length() + param.length() +3 > names_size) { break; }
+    trigger->expr = names_len;
+    strcpy(names + names_len, expr.c_str());
+    names_len += expr.length() +1;
+    trigger->name = names_len;
+    strcpy(names + names_len, name.c_str());
+    names_len += name.length() +1;
+    trigger->param = names_len;
+    strcpy(names + names_len, param.c_str());
+    names_len += param.length() +1;
+    if ('%' == param[0]) {
+      trigger->flags |= RULE_TRIGGER_VARIABLE;            // Resolved when matched
+    } else {
+      trigger->value = RulesOperandValue(param.c_str());
+    }
 
-  JsonParser parser((char*)buf.c_str());
-  JsonParserObject obj = parser.getRootObject();
-  if (!obj) {
-//    AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Event too long (%d)"), event.length());
-    AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: No valid JSON (%s)"), buf.c_str());
-    return false; // No valid JSON data
+    count++;
+    pos = end - text +6;
   }
-  String subtype;
-  uint32_t i = 0;
-  while ((pos = rule_name.indexOf("#")) > 0) {         // "SUBTYPE1#SUBTYPE2#CURRENT"
-    subtype = rule_name.substring(0, pos);
-    obj = obj[subtype.c_str()].getObject();
-    if (!obj) { return false; }             // not found
 
-    rule_name = rule_name.substring(pos +1);
-    if (i++ > 10) { return false; }                    // Abandon possible loop
+  if (!count) {
+    free(names);
+    free(triggers);
+    return;
+  }
+  RulesCompiled[rule_set].names = (char*)realloc(names, names_len);
+  if (!RulesCompiled[rule_set].names) { RulesCompiled[rule_set].names = names; }
+  RulesCompiled[rule_set].trigger = triggers;
+  RulesCompiled[rule_set].count = count;
+}
 
-    yield();
+bool RulesTriggerMatch(uint32_t rule_set, uint32_t index, JsonParserObject root)
+{
+  // root = {"INA219":{"VOLTAGE":4.494,"CURRENT":0.020,"POWER":0.089}}
+  // trigger name = "INA219#CURRENT", param = "0.100"
+  RuleTrigger* trigger = &RulesCompiled[rule_set].trigger[index];
+  if (Rules.teleperiod != (bool)(trigger->flags & RULE_TRIGGER_TELE)) { return false; }
+
+  const char* name = RulesCompiled[rule_set].names + trigger->name;
+  char key[strlen(name) +1];
+  strcpy(key, name);
+  char* level = key;
+  char* separator;
+  JsonParserObject obj = root;
+  uint32_t i = 0;
+  while ((separator = strchr(level, '#')) && (separator > level)) {  // "SUBTYPE1#SUBTYPE2#CURRENT"
+    *separator = '\0';
+    obj = obj[level].getObject();
+    if (!obj) { return false; }                           // not found
+    level = separator +1;
+    if (i++ > 10) { return false; }                       // Abandon possible loop
   }
 
-  JsonParserToken val = obj[rule_name.c_str()];
-  if (!val) { return false; }               // last level not found
+  JsonParserToken val = obj[level];
+  if (!val) { return false; }                             // last level not found
   const char* str_value;
-  if (rule_name_idx) {
-    if (val.isArray()) {
-      str_value = (val.getArray())[rule_name_idx -1].getStr();
-    } else {
-      str_value = val.getStr();
-    }
+  if (trigger->index && val.isArray()) {
+    str_value = (val.getArray())[trigger->index -1].getStr();
   } else {
-    str_value = val.getStr();                     // "CURRENT"
+    str_value = val.getStr();
   }
 
-//AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Name %s, Value |%s|, TrigCnt %d, TrigSt %d, Source %s, Json %s"),
-//  rule_name.c_str(), rule_svalue, Rules.trigger_count[rule_set], bitRead(Rules.triggers[rule_set], Rules.trigger_count[rule_set]), event.c_str(), (str_value) ? str_value : "none");
-
-  Rules.event_value = str_value;                       // Prepare %value%
+  Rules.event_value = str_value;                          // Prepare %value%
 
-  // Step 3: Compare rule (value)
-  float value = 0;
+  bool match = true;
   if (str_value) {
-    value = CharToFloat((char*)str_value);
+    const char* rule_svalue = RulesCompiled[rule_set].names + trigger->param;
+    float rule_value = trigger->value;
+    char svalue[80];
+    if ((trigger->flags & RULE_TRIGGER_VARIABLE) && (trigger->compare != COMPARE_OPERATOR_NONE)) {
+      rule_value = RulesOperand(rule_svalue, svalue, sizeof(svalue));
+      rule_svalue = svalue;
+    }
+
+    float value = CharToFloat((char*)str_value);
     int int_value = int(value);
     int int_rule_value = int(rule_value);
-    switch (compareOperator) {
+    switch (trigger->compare) {
       case COMPARE_OPERATOR_EXACT_DIVISION:
         match = (int_rule_value && (int_value % int_rule_value) == 0);
         break;
@@ -570,27 +665,21 @@ bool RulesRuleMatch(uint8_t rule_set, String &event, String &rule)
       case COMPARE_OPERATOR_SMALLER_EQUAL:
         match = (value <= rule_value);
         break;
-      default:
-        match = true;
     }
-  } else match = true;
-
-//AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Match 1 %d"), match);
+  }
 
   if (bitRead(Settings.rule_once, rule_set)) {
-    if (match) {                                       // Only allow match state changes
-      if (!bitRead(Rules.triggers[rule_set], Rules.trigger_count[rule_set])) {
-        bitSet(Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
+    if (match) {                                          // Only allow match state changes
+      if (!bitRead(Rules.triggers[rule_set], index)) {
+        bitSet(Rules.triggers[rule_set], index);
       } else {
         match = false;
       }
     } else {
-      bitClear(Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
+      bitClear(Rules.triggers[rule_set], index);
     }
   }
 
-//AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Match 2 %d"), match);
-
   return match;
 }
 
@@ -629,135 +718,176 @@ int8_t parseCompareExpression(String &expr, String &leftExpr, String &rightExpr)
   return compare;
 }
 
-void RulesVarReplace(String &commands, const String &sfind, const String &replace)
-{
-//  String ufind = sfind;
-//  ufind.toUpperCase();
-//  char *find = (char*)ufind.c_str();
-  char *find = (char*)sfind.c_str();
-  uint32_t flen = strlen(find);
-
-  String ucommand = commands;
-  ucommand.toUpperCase();
-  char *read_from = (char*)ucommand.c_str();
-  char *write_to = (char*)commands.c_str();
-  char *found_at;
-  while ((found_at = strstr(read_from, find)) != nullptr) {
-    write_to += (found_at - read_from);
-    memmove_P(write_to, find, flen);                      // Make variable Uppercase
-    write_to += flen;
-    read_from = found_at + flen;
-  }
+/*******************************************************************************************\
+ * Rule command variables
+ *
+ * Commands are scanned once for %name% tokens. Only the variables present are resolved using
+ * the kRulesVarNames table. Unknown tokens are copied as is and resolved values are not rescanned.
+\*******************************************************************************************/
 
-  commands.replace(find, replace);
-}
+const char kRulesVarNames[] PROGMEM =
+  "VALUE|TIME|UTCTIME|UPTIME|TIMESTAMP|TOPIC|DEVICEID|MACADDR|SUNRISE|SUNSET|ZBDEVICE|ZBGROUP|ZBCLUSTER|ZBENDPOINT";
 
-/*******************************************************************************************/
+enum RulesVarNames { RULE_VAR_VALUE, RULE_VAR_TIME, RULE_VAR_UTCTIME, RULE_VAR_UPTIME, RULE_VAR_TIMESTAMP, RULE_VAR_TOPIC,
+                     RULE_VAR_DEVICEID, RULE_VAR_MACADDR, RULE_VAR_SUNRISE, RULE_VAR_SUNSET,
+                     RULE_VAR_ZBDEVICE, RULE_VAR_ZBGROUP, RULE_VAR_ZBCLUSTER, RULE_VAR_ZBENDPOINT };
 
-bool RuleSetProcess(uint8_t rule_set, String &event_saved)
+bool RulesVarResolve(String &out, const char* name)
 {
-  bool serviced = false;
-  char stemp[10];
-
-  delay(0);                                               // Prohibit possible loop software watchdog
-
-//AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Event = %s, Rule = %s"), event_saved.c_str(), Settings.rules[rule_set]);
-
-  String rules = GetRule(rule_set);
-
-  Rules.trigger_count[rule_set] = 0;
-  int plen = 0;
-  int plen2 = 0;
-  bool stop_all_rules = false;
-  while (true) {
-    rules = rules.substring(plen);                        // Select relative to last rule
-    rules.trim();
-    if (!rules.length()) { return serviced; }             // No more rules
-
-    String rule = rules;
-    rule.toUpperCase();                                   // "ON INA219#CURRENT>0.100 DO BACKLOG DIMMER 10;COLOR 100000 ENDON"
-    if (!rule.startsWith("ON ")) { return serviced; }     // Bad syntax - Nothing to start on
-
-    int pevt = rule.indexOf(" DO ");
-    if (pevt == -1) { return serviced; }                  // Bad syntax - Nothing to do
-    String event_trigger = rule.substring(3, pevt);       // "INA219#CURRENT>0.100"
-
-    plen = rule.indexOf(" ENDON");
-    plen2 = rule.indexOf(" BREAK");
-    if ((plen == -1) && (plen2 == -1)) { return serviced; } // Bad syntax - No ENDON neither BREAK
-
-    if (plen == -1) { plen = 9999; }
-    if (plen2 == -1) { plen2 = 9999; }
-    plen = tmin(plen, plen2);
-
-    String commands = rules.substring(pevt +4, plen);     // "Backlog Dimmer 10;Color 100000"
-    Rules.event_value = "";
-    String event = event_saved;
-
-//AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Event |%s|, Rule |%s|, Command(s) |%s|"), event.c_str(), event_trigger.c_str(), commands.c_str());
-
-    if (RulesRuleMatch(rule_set, event, event_trigger)) {
-      if (plen == plen2) { stop_all_rules = true; }         // If BREAK was used on a triggered rule, Stop execution of this rule set
-      commands.trim();
-      String ucommand = commands;
-      ucommand.toUpperCase();
-
-//      if (!ucommand.startsWith("BACKLOG")) { commands = "backlog " + commands; }  // Always use Backlog to prevent power race exception
-      // Use Backlog with event to prevent rule event loop exception unless IF is used which uses an implicit backlog
-      if ((ucommand.indexOf("IF ") == -1) &&
-          (ucommand.indexOf("EVENT ") != -1) &&
-          (ucommand.indexOf("BACKLOG ") == -1)) {
-        commands = "backlog " + commands;
-      }
-
-      RulesVarReplace(commands, F("%VALUE%"), Rules.event_value);
-      for (uint32_t i = 0; i < MAX_RULE_VARS; i++) {
-        snprintf_P(stemp, sizeof(stemp), PSTR("%%VAR%d%%"), i +1);
-        RulesVarReplace(commands, stemp, rules_vars[i]);
+  // Append value of variable name like "VAR1" or "TIME" to out. Returns false if unknown
+  if (!strncasecmp_P(name, PSTR("VAR"), 3) || !strncasecmp_P(name, PSTR("MEM"), 3)) {
+    char* end;
+    uint32_t index = strtoul(name + 3, &end, 10);
+    if (('\0' == *end) && isdigit(name[3])) {
+      if (('V' == toupper(name[0])) && (index > 0) && (index <= MAX_RULE_VARS)) {
+        out += rules_vars[index -1];
+        return true;
       }
-      for (uint32_t i = 0; i < MAX_RULE_MEMS; i++) {
-        snprintf_P(stemp, sizeof(stemp), PSTR("%%MEM%d%%"), i +1);
-        RulesVarReplace(commands, stemp, SettingsText(SET_MEM1 +i));
+      if (('M' == toupper(name[0])) && (index > 0) && (index <= MAX_RULE_MEMS)) {
+        out += SettingsText(SET_MEM1 + index -1);
+        return true;
       }
-      RulesVarReplace(commands, F("%TIME%"), String(MinutesPastMidnight()));
-      RulesVarReplace(commands, F("%UTCTIME%"), String(UtcTime()));
-      RulesVarReplace(commands, F("%UPTIME%"), String(MinutesUptime()));
-      RulesVarReplace(commands, F("%TIMESTAMP%"), GetDateAndTime(DT_LOCAL));
-      RulesVarReplace(commands, F("%TOPIC%"), mqtt_topic);
+    }
+    return false;
+  }
+
+  char stemp[12];
+  switch (GetCommandCode(stemp, sizeof(stemp), name, kRulesVarNames)) {
+    case RULE_VAR_VALUE:
+      out += Rules.event_value;
+      break;
+    case RULE_VAR_TIME:
+      out += MinutesPastMidnight();
+      break;
+    case RULE_VAR_UTCTIME:
+      out += UtcTime();
+      break;
+    case RULE_VAR_UPTIME:
+      out += MinutesUptime();
+      break;
+    case RULE_VAR_TIMESTAMP:
+      out += GetDateAndTime(DT_LOCAL);
+      break;
+    case RULE_VAR_TOPIC:
+      out += mqtt_topic;
+      break;
+    case RULE_VAR_DEVICEID:
       snprintf_P(stemp, sizeof(stemp), PSTR("%06X"), ESP_getChipId());
-      RulesVarReplace(commands, F("%DEVICEID%"), stemp);
+      out += stemp;
+      break;
+    case RULE_VAR_MACADDR: {
       String mac_address = WiFi.macAddress();
       mac_address.replace(":", "");
-      RulesVarReplace(commands, F("%MACADDR%"), mac_address);
+      out += mac_address;
+      break;
+    }
 #if defined(USE_TIMERS) && defined(USE_SUNRISE)
-      RulesVarReplace(commands, F("%SUNRISE%"), String(SunMinutes(0)));
-      RulesVarReplace(commands, F("%SUNSET%"), String(SunMinutes(1)));
+    case RULE_VAR_SUNRISE:
+      out += SunMinutes(0);
+      break;
+    case RULE_VAR_SUNSET:
+      out += SunMinutes(1);
+      break;
 #endif  // USE_TIMERS and USE_SUNRISE
 #ifdef USE_ZIGBEE
+    case RULE_VAR_ZBDEVICE:
       snprintf_P(stemp, sizeof(stemp), PSTR("0x%04X"), Z_GetLastDevice());
-      RulesVarReplace(commands, F("%ZBDEVICE%"), String(stemp));
-      RulesVarReplace(commands, F("%ZBGROUP%"), String(Z_GetLastGroup()));
-      RulesVarReplace(commands, F("%ZBCLUSTER%"), String(Z_GetLastCluster()));
-      RulesVarReplace(commands, F("%ZBENDPOINT%"), String(Z_GetLastEndpoint()));
-#endif
+      out += stemp;
+      break;
+    case RULE_VAR_ZBGROUP:
+      out += Z_GetLastGroup();
+      break;
+    case RULE_VAR_ZBCLUSTER:
+      out += Z_GetLastCluster();
+      break;
+    case RULE_VAR_ZBENDPOINT:
+      out += Z_GetLastEndpoint();
+      break;
+#endif  // USE_ZIGBEE
+    default:
+      return false;
+  }
+  return true;
+}
 
-      char command[commands.length() +1];
-      strlcpy(command, commands.c_str(), sizeof(command));
+String RulesExpandVars(const char* commands, uint32_t len)
+{
+  String out;
+  out.reserve(len + 16);
+
+  const char* end = commands + len;
+  const char* copied = commands;                          // Start of text not yet copied to out
+  const char* start = commands;
+  while ((start = (const char*)memchr(start, '%', end - start)) != nullptr) {
+    const char* close = start +1;
+    while ((close < end) && isalnum(*close)) { close++; }
+    uint32_t name_len = close - start -1;
+    if ((close >= end) || ('%' != *close) || !name_len || (name_len > 11)) {
+      start = close;                                      // No variable name. Next % might open one
+      continue;
+    }
+    char name[12];
+    memcpy(name, start +1, name_len);
+    name[name_len] = '\0';
+    while (copied < start) { out += *copied++; }
+    if (RulesVarResolve(out, name)) {
+      copied = close +1;
+      start = close +1;
+    } else {
+      copied = start;                                     // Keep unknown token as is
+      start = close;
+    }
+  }
+  while (copied < end) { out += *copied++; }
+  return out;
+}
 
-      AddLog_P2(LOG_LEVEL_INFO, PSTR("RUL: %s performs \"%s\""), event_trigger.c_str(), command);
+/*******************************************************************************************/
 
-//      Response_P(S_JSON_COMMAND_SVALUE, D_CMND_RULE, D_JSON_INITIATED);
-//      MqttPublishPrefixTopic_P(RESULT_OR_STAT, PSTR(D_CMND_RULE));
+void RulesTriggerExecute(uint32_t rule_set, uint32_t index, String &rules)
+{
+  RuleTrigger* trigger = &RulesCompiled[rule_set].trigger[index];
+  String commands = RulesExpandVars(rules.c_str() + trigger->commands, trigger->commands_len);  // "Backlog Dimmer 10;Color 100000"
+  if (trigger->flags & RULE_TRIGGER_BACKLOG) {
+    commands = "backlog " + commands;
+  }
+
+  char command[commands.length() +1];
+  strlcpy(command, commands.c_str(), sizeof(command));
+
+  AddLog_P2(LOG_LEVEL_INFO, PSTR("RUL: %s performs \"%s\""), RulesCompiled[rule_set].names + trigger->expr, command);
+
+//  Response_P(S_JSON_COMMAND_SVALUE, D_CMND_RULE, D_JSON_INITIATED);
+//  MqttPublishPrefixTopic_P(RESULT_OR_STAT, PSTR(D_CMND_RULE));
 #ifdef SUPPORT_IF_STATEMENT
-      char *pCmd = command;
-      RulesPreprocessCommand(pCmd);                       // Do pre-process for IF statement
+  char *pCmd = command;
+  RulesPreprocessCommand(pCmd);                           // Do pre-process for IF statement
 #endif
-      ExecuteCommand(command, SRC_RULE);
+  ExecuteCommand(command, SRC_RULE);
+}
+
+bool RuleSetProcess(uint8_t rule_set, JsonParserObject root)
+{
+  bool serviced = false;
+
+  delay(0);                                               // Prohibit possible loop software watchdog
+
+  if (!RulesCompiled[rule_set].valid) {
+    RulesCompile(rule_set);
+  }
+
+  String rules;                                           // Rule text is only read when a trigger matches
+  for (uint32_t i = 0; i < RulesCompiled[rule_set].count; i++) {
+    if (!RulesCompiled[rule_set].valid) { break; }        // Rule set changed by an executed command
+    Rules.trigger_count[rule_set] = i;
+    Rules.event_value = "";
+    if (RulesTriggerMatch(rule_set, i, root)) {
+      bool stop_all_rules = (RulesCompiled[rule_set].trigger[i].flags & RULE_TRIGGER_BREAK);
+      if (!rules.length()) { rules = GetRule(rule_set); }
+      RulesTriggerExecute(rule_set, i, rules);
       serviced = true;
-      if (stop_all_rules) { return serviced; }            // If BREAK was used, Stop execution of this rule set
+      if (stop_all_rules) { break; }                      // If BREAK was used, Stop execution of this rule set
     }
-    plen += 6;
-    Rules.trigger_count[rule_set]++;
   }
   return serviced;
 }
@@ -768,6 +898,12 @@ bool RulesProcessEvent(char *json_event)
 {
   if (Rules.busy) { return false; }
 
+  bool active = false;
+  for (uint32_t i = 0; i < MAX_RULE_SETS; i++) {
+    if (GetRuleLen(i) && bitRead(Settings.rule_enabled, i)) { active = true; }
+  }
+  if (!active) { return false; }
+
   Rules.busy = true;
   bool serviced = false;
 
@@ -791,9 +927,15 @@ bool RulesProcessEvent(char *json_event)
 
 //AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Event |%s|"), event_saved.c_str());
 
-  for (uint32_t i = 0; i < MAX_RULE_SETS; i++) {
-    if (GetRuleLen(i) && bitRead(Settings.rule_enabled, i)) {
-      if (RuleSetProcess(i, event_saved)) { serviced = true; }
+  JsonParser parser((char*)event_saved.c_str());         // Parsed once for all triggers
+  JsonParserObject root = parser.getRootObject();
+  if (!root) {
+    AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: No valid JSON (%s)"), json_event);
+  } else {
+    for (uint32_t i = 0; i < MAX_RULE_SETS; i++) {
+      if (GetRuleLen(i) && bitRead(Settings.rule_enabled, i)) {
+        if (RuleSetProcess(i, root)) { serviced = true; }
+      }
     }
   }
 
@@ -1023,16 +1165,17 @@ bool RulesMqttData(void)
     return false;
   }
   bool serviced = false;
-  String sTopic = XdrvMailbox.topic;
   String sData = XdrvMailbox.data;
   //AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: MQTT Topic %s, Event %s"), XdrvMailbox.topic, XdrvMailbox.data);
   MQTT_Subscription event_item;
-  //Looking for matched topic
-  for (uint32_t index = 0; index < subscriptions.size(); index++) {
-    event_item = subscriptions.get(index);
-
-    //AddLog_P2(LOG_LEVEL_DEBUG, PSTR("RUL: Match MQTT message Topic %s with subscription topic %s"), sTopic.c_str(), event_item.Topic.c_str());
-    if (sTopic.startsWith(event_item.Topic)) {
+  //Looking for subscriptions matched by the MQTT topic registry
+  for (uint32_t match = 0; match < MqttTopics.matches; match++) {
+    int32_t id = MqttTopicMatchId(match, MQTT_TOPIC_RULES);
+    if (id < 0) { continue; }
+    int32_t index = 0;
+    while ((index < subscriptions.size()) && (subscriptions[index].Id != id)) { index++; }
+    if (index < subscriptions.size()) {
+      event_item = subscriptions.get(index);
       //This topic is subscribed by us, so serve it
       serviced = true;
       String value;
@@ -1117,6 +1260,7 @@ void CmndSubscribe(void)
           //If find exists one, remove it.
           String stopic = subscriptions.get(index).Topic + "/#";
           MqttUnsubscribe(stopic.c_str());
+          MqttTopicRemove(MQTT_TOPIC_RULES, subscriptions.get(index).Id);
           subscriptions.remove(index);
           break;
         }
@@ -1134,9 +1278,11 @@ void CmndSubscribe(void)
       subscription_item.Event = event_name;
       subscription_item.Topic = topic.substring(0, topic.length() - 2);   //Remove "/#" so easy to match
       subscription_item.Key = key;
+      subscription_item.Id = MqttTopicFreeId(MQTT_TOPIC_RULES);
       subscriptions.add(subscription_item);
 
       MqttSubscribe(topic.c_str());
+      MqttTopicAdd(topic.c_str(), MQTT_TOPIC_RULES, subscription_item.Id);
       events.concat(event_name + "," + topic
         + (key.length()>0 ? "," : "")
         + key);
@@ -1176,6 +1322,7 @@ void CmndUnsubscribe(void)
       if (subscription_item.Event.equalsIgnoreCase(XdrvMailbox.data)) {
         String stopic = subscription_item.Topic + "/#";
         MqttUnsubscribe(stopic.c_str());
+        MqttTopicRemove(MQTT_TOPIC_RULES, subscription_item.Id);
         events = subscription_item.Event;
         subscriptions.remove(index);
         break;
@@ -1188,6 +1335,7 @@ void CmndUnsubscribe(void)
       events.concat(subscriptions.get(0).Event + "; ");
       stopic = subscriptions.get(0).Topic + "/#";
       MqttUnsubscribe(stopic.c_str());
+      MqttTopicRemove(MQTT_TOPIC_RULES, subscriptions.get(0).Id);
       subscriptions.remove(0);
     }
   }
@@ -1234,6 +1382,91 @@ char * findClosureBracket(char * pStart)
   }
 }
 
+/********************************************************************************************/
+/*
+ * Compiled expressions
+ *
+ * Expressions are compiled into a postfix bytecode with variables resolved to opcodes and run on
+ * a float stack. Expressions compiled a second time are kept in a small cache keyed by their text.
+ * Text with substituted values like %value% rarely repeats and is run from the compiler buffer
+ * without being cached. Compiled entries hold the expression text followed by the bytecode:
+ *   RULES_EXPR_CONST <float>      - Push constant
+ *   RULES_EXPR_VAR <index>        - Push value of VAR<index>, same for RULES_EXPR_MEM
+ *   RULES_EXPR_TIME .. SUNSET     - Push value of named variable
+ *   RULES_EXPR_OPERATOR +op       - Replace top two values by result of arithmetic operator
+ *   RULES_EXPR_COMPARE +op        - Replace top two values by result of compare operator (0 or 1)
+ *   RULES_EXPR_AND, RULES_EXPR_OR - Replace top two values by logical result (0 or 1)
+ */
+
+#ifndef RULES_EXPR_CACHE
+#define RULES_EXPR_CACHE           8          // Number of compiled expressions kept
+#endif
+
+enum RulesExprOpcodes { RULES_EXPR_CONST, RULES_EXPR_VAR, RULES_EXPR_MEM,
+                        RULES_EXPR_TIME, RULES_EXPR_UPTIME, RULES_EXPR_UTCTIME, RULES_EXPR_LOCALTIME, RULES_EXPR_SUNRISE, RULES_EXPR_SUNSET,
+                        RULES_EXPR_OPERATOR,                                  // + EXPRESSION_OPERATOR_ADD .. EXPRESSION_OPERATOR_POWER
+                        RULES_EXPR_COMPARE = RULES_EXPR_OPERATOR + 6,         // + COMPARE_OPERATOR_EQUAL .. COMPARE_OPERATOR_SMALLER_EQUAL
+                        RULES_EXPR_AND = RULES_EXPR_COMPARE + MAXIMUM_COMPARE_OPERATOR +1, RULES_EXPR_OR };
+
+const char kRulesExprVariables[] PROGMEM = "TIME|UPTIME|UTCTIME|LOCALTIME"
+#if defined(USE_TIMERS) && defined(USE_SUNRISE)
+  "|SUNRISE|SUNSET"
+#endif
+  ;
+
+typedef struct {
+  uint8_t *code;                              // Expression text followed by bytecode
+  uint32_t hash;                              // Hash of expression text
+  uint16_t text_len;
+  uint16_t code_len;
+  uint16_t depth;                             // Maximum stack depth
+  bool logical;                               // Logical expression as used by IF
+} RulesExprEntry;
+
+struct RULES_EXPR {
+  RulesExprEntry cache[RULES_EXPR_CACHE];
+  uint32_t missed[RULES_EXPR_CACHE];          // Hashes of recently compiled expressions not cached
+  uint8_t *code;                              // Compiler output, kept for the next compilation
+  uint32_t len;
+  uint32_t size;
+  uint16_t depth;
+  uint16_t max_depth;
+  uint8_t next;                               // Cache entry to be replaced next
+  uint8_t next_missed;
+  bool stop;                                  // Compiler found end of (sub) expression
+  bool error;                                 // Compiler out of memory
+} RulesExpr;
+
+void RulesExprEmit(const void *data, uint32_t len, int32_t stack)
+{
+  if (RulesExpr.error || !len) { return; }
+  if (RulesExpr.len + len > RulesExpr.size) {
+    uint32_t size = RulesExpr.len + len + 32;
+    uint8_t *code = (uint8_t*)realloc(RulesExpr.code, size);
+    if (!code) {
+      RulesExpr.error = true;
+      return;
+    }
+    RulesExpr.code = code;
+    RulesExpr.size = size;
+  }
+  memcpy(RulesExpr.code + RulesExpr.len, data, len);
+  RulesExpr.len += len;
+  RulesExpr.depth += stack;
+  if (RulesExpr.depth > RulesExpr.max_depth) { RulesExpr.max_depth = RulesExpr.depth; }
+}
+
+void RulesExprEmitCode(uint8_t opcode, int32_t stack)
+{
+  RulesExprEmit(&opcode, 1, stack);
+}
+
+void RulesExprEmitValue(uint8_t opcode, float value)
+{
+  RulesExprEmitCode(opcode, 1);
+  RulesExprEmit(&value, sizeof(value), 0);
+}
+
 /********************************************************************************************/
 /*
  * Parse a number value
@@ -1272,90 +1505,64 @@ bool findNextNumber(char * &pNumber, float &value)
 
 /********************************************************************************************/
 /*
- * Parse a variable (like VAR1, MEM3) and get its value (float type)
+ * Parse a variable (like VAR1, MEM3) and compile its value lookup
  * Input:
  *      pVarname    - A char pointer point to a variable name string
- *      value       - Reference a float variable used to accept the result
  * Output:
  *      pVarname    - Pointer forward to next character after the variable
- *      value       - float type, the result value
  * Return:
  *      true    - succeed
  *      false   - failed
  */
-bool findNextVariableValue(char * &pVarname, float &value)
+bool findNextVariable(char * &pVarname)
 {
+  char *name = pVarname;
+  while (isalpha(*pVarname) || isdigit(*pVarname)) {
+    pVarname++;
+  }
+  char last = *pVarname;
+  *pVarname = '\0';                           // Expression is a copy
+
   bool succeed = true;
-  value = 0;
-  String sVarName = "";
-  while (*pVarname) {
-    if (isalpha(*pVarname) || isdigit(*pVarname)) {
-      sVarName.concat(*pVarname);
-      pVarname++;
+  if (!strncasecmp_P(name, PSTR("VAR"), 3) || !strncasecmp_P(name, PSTR("MEM"), 3)) {
+    bool mem = ('M' == toupper(name[0]));
+    int index = atoi(name + 3);
+    if ((index > 0) && (index <= ((mem) ? MAX_RULE_MEMS : MAX_RULE_VARS))) {
+      RulesExprEmitCode((mem) ? RULES_EXPR_MEM : RULES_EXPR_VAR, 1);
+      RulesExprEmitCode(index -1, 0);
     } else {
-      break;
+      RulesExprEmitValue(RULES_EXPR_CONST, 0);
     }
-  }
-  sVarName.toUpperCase();
-  if (sVarName.startsWith(F("VAR"))) {
-    int index = sVarName.substring(3).toInt();
-    if (index > 0 && index <= MAX_RULE_VARS) {
-      value = CharToFloat(rules_vars[index -1]);
-    }
-  } else if (sVarName.startsWith(F("MEM"))) {
-    int index = sVarName.substring(3).toInt();
-    if (index > 0 && index <= MAX_RULE_MEMS) {
-      value = CharToFloat(SettingsText(SET_MEM1 + index -1));
-    }
-  } else if (sVarName.equals(F("TIME"))) {
-    value = MinutesPastMidnight();
-  } else if (sVarName.equals(F("UPTIME"))) {
-    value = MinutesUptime();
-  } else if (sVarName.equals(F("UTCTIME"))) {
-    value = UtcTime();
-  } else if (sVarName.equals(F("LOCALTIME"))) {
-    value = LocalTime();
-#if defined(USE_TIMERS) && defined(USE_SUNRISE)
-  } else if (sVarName.equals(F("SUNRISE"))) {
-    value = SunMinutes(0);
-  } else if (sVarName.equals(F("SUNSET"))) {
-    value = SunMinutes(1);
-#endif
-// #ifdef USE_ZIGBEE
-//   // } else if (sVarName.equals(F("ZBDEVICE"))) {
-//   //   value = Z_GetLastDevice();
-//   } else if (sVarName.equals(F("ZBGROUP"))) {
-//     value = Z_GetLastGroup();
-//   } else if (sVarName.equals(F("ZBCLUSTER"))) {
-//     value = Z_GetLastCluster();
-//   } else if (sVarName.equals(F("ZBENDPOINT"))) {
-//     value = Z_GetLastEndpoint();
-// #endif
   } else {
-    succeed = false;
+    char stemp[12];
+    int variable = GetCommandCode(stemp, sizeof(stemp), name, kRulesExprVariables);
+    if (variable >= 0) {
+      RulesExprEmitCode(RULES_EXPR_TIME + variable, 1);
+    } else {
+      succeed = false;
+    }
   }
 
+  *pVarname = last;
   return succeed;
 }
 
 /********************************************************************************************/
 /*
- * Find next object in expression and evaluate it
+ * Find next object in expression and compile it
  *     An object could be:
  *     - A float number start with a digit or minus, like 0.787, -3
  *     - A variable name, like VAR1, MEM3
  *     - An expression enclosed with a pair of round brackets, (.....)
  * Input:
  *      pointer     - A char pointer point to a place of the expression string
- *      value       - Reference a float variable used to accept the result
  * Output:
  *      pointer     - Pointer forward to next character after next object
- *      value       - float type, the result value
  * Return:
  *      true    - succeed
  *      false   - failed
  */
-bool findNextObjectValue(char * &pointer, float &value)
+bool findNextObject(char * &pointer)
 {
   bool bSucceed = false;
   while (*pointer)
@@ -1365,15 +1572,17 @@ bool findNextObjectValue(char * &pointer, float &value)
       continue;
     }
     if (isdigit(*pointer) || (*pointer) == '-') {      //This object is a number
+      float value;
       bSucceed = findNextNumber(pointer, value);
+      RulesExprEmitValue(RULES_EXPR_CONST, value);
       break;
     } else if (isalpha(*pointer)) {     //Should be a variable like VAR12, MEM1
-      bSucceed = findNextVariableValue(pointer, value);
+      bSucceed = findNextVariable(pointer);
       break;
     } else if (*pointer == '(') {     //It is a sub expression bracketed with ()
       char * closureBracket = findClosureBracket(pointer);        //Get the position of closure bracket ")"
       if (closureBracket != nullptr) {
-        value = evaluateExpression(pointer+1, closureBracket - pointer - 1);
+        RulesExprCompileArithmetic(pointer+1, closureBracket - pointer - 1);
         pointer = closureBracket + 1;
         bSucceed = true;
       }
@@ -1427,14 +1636,10 @@ bool findNextOperator(char * &pointer, int8_t &op)
 /*
  * Calculate a simple expression composed by 2 value and 1 operator, like 2 * 3
  * Input:
- *      pointer     - A char pointer point to a place of the expression string
- *      value       - Reference a float variable used to accept the result
- * Output:
- *      pointer     - Pointer forward to next character after next object
- *      value       - float type, the result value
+ *      v1, v2      - Operands
+ *      op          - The operator. 0, 1, 2, 3, 4, 5
  * Return:
- *      true    - succeed
- *      false   - failed
+ *      float       - result
  */
 float calculateTwoValues(float v1, float v2, uint8_t op)
 {
@@ -1458,7 +1663,41 @@ float calculateTwoValues(float v1, float v2, uint8_t op)
 
 /********************************************************************************************/
 /*
- * Parse and evaluate an expression.
+ * Compile the operators following an object with at least min_priority
+ *     Operators of higher priority are compiled first. Operators of equal priority are compiled
+ *     left to right. Compilation stops at the first missing operator or object.
+ * Input:
+ *      pointer       - A char pointer point to the character after an object
+ *      min_priority  - Lowest operator priority to compile
+ * Output:
+ *      pointer       - Pointer forward to next character after the compiled operators
+ */
+void RulesExprCompileOperators(char * &pointer, uint32_t min_priority)
+{
+  while (!RulesExpr.stop && *pointer) {
+    char *start = pointer;
+    int8_t op;
+    if (!findNextOperator(pointer, op)) {
+      RulesExpr.stop = true;
+      break;
+    }
+    uint32_t priority = pgm_read_byte(kExpressionOperatorsPriorities + op);
+    if (priority < min_priority) {
+      pointer = start;                        // Leave operator to the caller
+      break;
+    }
+    if (!*pointer || !findNextObject(pointer)) {
+      RulesExpr.stop = true;
+      break;
+    }
+    RulesExprCompileOperators(pointer, priority +1);
+    RulesExprEmitCode(RULES_EXPR_OPERATOR + op, -1);
+  }
+}
+
+/********************************************************************************************/
+/*
+ * Compile an expression.
  * For example: "10 * ( MEM2 + 1) / 2"
  * Right now, only support operators listed here:  (order by priority)
  *      Priority 4: ^ (power)
@@ -1466,76 +1705,197 @@ float calculateTwoValues(float v1, float v2, uint8_t op)
  *      Priority 2: *, /
  *      Priority 1: +, -
  * Input:
- *      expression  - The expression to be evaluated
+ *      expression  - The expression to be compiled
  *      len         - Length of the expression
- * Return:
- *      float      - result.
- *      0           - if the expression is invalid
  * An example:
- * MEM1 = 3, MEM2 = 6, VAR2 = 15, VAR10 = 80
- * At beginning, the expression might be complicated like: 3.14 * (MEM1 * (10 + VAR2 ^2) - 100) % 10 + VAR10 / (2 + MEM2)
- * We are going to scan the whole expression, evaluate each object.
- * Finally we will have a value list:.
- * Order          Object                              Value
- *  0             3.14                                3.14
- *  1             (MEM1 * (10 + VAR2 ^2) - 100)       605
- *  2             10                                  10
- *  3             VAR10                               80
- *  4             (2 + MEM2)                          8
- * And an operator list:
- * Order          Operator                            Priority
- *  0             *                                   2
- *  1             %                                   3
- *  2             +                                   1
- *  3             /                                   2
+ * 3.14 * (MEM1 * (10 + VAR2 ^2) - 100) % 10 + VAR10 / (2 + MEM2)
+ * compiles to
+ * 3.14 MEM1 10 VAR2 2 ^ + * 100 - 10 % * VAR10 2 MEM2 + / +
+ * An invalid expression compiles to 0
  */
-float evaluateExpression(const char * expression, unsigned int len)
+void RulesExprCompileArithmetic(const char * expression, unsigned int len)
 {
   char expbuf[len + 1];
   memcpy(expbuf, expression, len);
   expbuf[len] = '\0';
   char * scan_pointer = expbuf;
 
-  LinkedList<float> object_values;
-  LinkedList<int8_t> operators;
-  int8_t op;
-  float va;
-  //Find and add the value of first object
-  if (findNextObjectValue(scan_pointer, va)) {
-    object_values.add(va);
+  bool stop = RulesExpr.stop;
+  RulesExpr.stop = false;
+  if (findNextObject(scan_pointer)) {
+    RulesExprCompileOperators(scan_pointer, 1);
   } else {
-    return 0;
+    RulesExprEmitValue(RULES_EXPR_CONST, 0);
   }
-  while (*scan_pointer)
-  {
-    if (findNextOperator(scan_pointer, op)
-        && *scan_pointer
-        && findNextObjectValue(scan_pointer, va))
-    {
-      operators.add(op);
-      object_values.add(va);
-    } else {
-      //No operator followed or no more object after this operator, we done.
-      break;
+  RulesExpr.stop = stop;
+}
+
+/********************************************************************************************/
+/*
+ * Run compiled expression
+ */
+float RulesExprRun(const uint8_t *code, uint32_t code_len, uint32_t depth)
+{
+  const uint8_t *end = code + code_len;
+  float stack[depth +1];
+  uint32_t sp = 0;
+
+  while (code < end) {
+    uint32_t opcode = *code++;
+    if (opcode >= RULES_EXPR_OPERATOR) {
+      float right = stack[--sp];
+      float left = stack[sp -1];
+      bool result = false;
+      if (opcode < RULES_EXPR_COMPARE) {
+        stack[sp -1] = calculateTwoValues(left, right, opcode - RULES_EXPR_OPERATOR);
+        continue;
+      }
+      switch (opcode - RULES_EXPR_COMPARE) {
+        case COMPARE_OPERATOR_EXACT_DIVISION:
+          result = (right != 0 && left == int(left) && right == int(right) && (int(left) % int(right)) == 0);
+          break;
+        case COMPARE_OPERATOR_BIGGER:
+          result = (left > right);
+          break;
+        case COMPARE_OPERATOR_SMALLER:
+          result = (left < right);
+          break;
+        case COMPARE_OPERATOR_NUMBER_EQUAL:
+          result = (left == right);
+          break;
+        case COMPARE_OPERATOR_NOT_EQUAL:
+          result = (left != right);
+          break;
+        case COMPARE_OPERATOR_BIGGER_EQUAL:
+          result = (left >= right);
+          break;
+        case COMPARE_OPERATOR_SMALLER_EQUAL:
+          result = (left <= right);
+          break;
+        default:
+          if (RULES_EXPR_AND == opcode) {
+            result = ((left != 0) && (right != 0));
+          } else {
+            result = ((left != 0) || (right != 0));
+          }
+      }
+      stack[sp -1] = result;
+      continue;
     }
+
+    float value = 0;
+    switch (opcode) {
+      case RULES_EXPR_CONST:
+        memcpy(&value, code, sizeof(value));
+        code += sizeof(value);
+        break;
+      case RULES_EXPR_VAR:
+        value = CharToFloat(rules_vars[*code++]);
+        break;
+      case RULES_EXPR_MEM:
+        value = CharToFloat(SettingsText(SET_MEM1 + *code++));
+        break;
+      case RULES_EXPR_TIME:
+        value = MinutesPastMidnight();
+        break;
+      case RULES_EXPR_UPTIME:
+        value = MinutesUptime();
+        break;
+      case RULES_EXPR_UTCTIME:
+        value = UtcTime();
+        break;
+      case RULES_EXPR_LOCALTIME:
+        value = LocalTime();
+        break;
+#if defined(USE_TIMERS) && defined(USE_SUNRISE)
+      case RULES_EXPR_SUNRISE:
+        value = SunMinutes(0);
+        break;
+      case RULES_EXPR_SUNSET:
+        value = SunMinutes(1);
+        break;
+#endif
+    }
+    stack[sp++] = value;
   }
+  return (sp) ? stack[0] : 0;
+}
 
-  //Going to evaluate the whole expression
-  //Calculate by order of operator priorities. Looking for all operators with specified priority (from High to Low)
-  for (int32_t priority = MAX_EXPRESSION_OPERATOR_PRIORITY; priority>0; priority--) {
-    int index = 0;
-    while (index < operators.size()) {
-      if (priority == pgm_read_byte(kExpressionOperatorsPriorities + operators.get(index))) {     //need to calculate the operator first
-        //get current object value and remove the next object with current operator
-        va = calculateTwoValues(object_values.get(index), object_values.remove(index + 1), operators.remove(index));
-        //Replace the current value with the result
-        object_values.set(index, va);
-      } else {
-        index++;
-      }
+/********************************************************************************************/
+/*
+ * Evaluate an expression using its cached compiled form
+ * Input:
+ *      expression  - The expression to be evaluated
+ *      len         - Length of the expression
+ *      logical     - Logical expression as used by IF
+ * Return:
+ *      float       - result.
+ *      0           - if the expression is invalid
+ */
+float RulesExprEvaluate(const char * expression, unsigned int len, bool logical)
+{
+  uint32_t hash = GetHash(expression, len);
+  for (uint32_t i = 0; i < RULES_EXPR_CACHE; i++) {
+    RulesExprEntry *entry = &RulesExpr.cache[i];
+    if (entry->code && (entry->hash == hash) && (entry->text_len == len) && (entry->logical == logical) &&
+        !memcmp(entry->code, expression, len)) {
+      return RulesExprRun(entry->code + len, entry->code_len, entry->depth);
+    }
+  }
+
+  RulesExpr.len = 0;
+  RulesExpr.depth = 0;
+  RulesExpr.max_depth = 0;
+  RulesExpr.stop = false;
+  RulesExpr.error = false;
+  RulesExprEmit(expression, len, 0);          // Keep text to verify cache hits
+#ifdef SUPPORT_IF_STATEMENT
+  if (logical) {
+    RulesExprCompileLogical(expression, len);
+  } else
+#endif  // SUPPORT_IF_STATEMENT
+  {
+    RulesExprCompileArithmetic(expression, len);
+  }
+  if (RulesExpr.error || (len > 0xFFFF) || (RulesExpr.len - len > 0xFFFF)) {
+    return 0;
+  }
+
+  bool seen = false;
+  for (uint32_t i = 0; i < RULES_EXPR_CACHE; i++) {
+    if (RulesExpr.missed[i] == hash) {
+      RulesExpr.missed[i] = 0;
+      seen = true;
+      break;
     }
   }
-  return object_values.get(0);
+  uint8_t *code = nullptr;
+  if (seen) {                                 // Compiled before so likely to be used again
+    code = (uint8_t*)malloc(RulesExpr.len);
+  } else {
+    RulesExpr.missed[RulesExpr.next_missed] = hash;
+    RulesExpr.next_missed = (RulesExpr.next_missed +1) % RULES_EXPR_CACHE;
+  }
+  if (!code) {                                // Run from compiler buffer
+    return RulesExprRun(RulesExpr.code + len, RulesExpr.len - len, RulesExpr.max_depth);
+  }
+
+  memcpy(code, RulesExpr.code, RulesExpr.len);
+  RulesExprEntry *entry = &RulesExpr.cache[RulesExpr.next];
+  RulesExpr.next = (RulesExpr.next +1) % RULES_EXPR_CACHE;
+  free(entry->code);
+  entry->code = code;
+  entry->hash = hash;
+  entry->text_len = len;
+  entry->code_len = RulesExpr.len - len;
+  entry->depth = RulesExpr.max_depth;
+  entry->logical = logical;
+  return RulesExprRun(entry->code + len, entry->code_len, entry->depth);
+}
+
+float evaluateExpression(const char * expression, unsigned int len)
+{
+  return RulesExprEvaluate(expression, len, false);
 }
 #endif  // USE_EXPRESSION
 
@@ -1553,19 +1913,16 @@ void CmndIf(void)
 
 /********************************************************************************************/
 /*
- * Evaluate a comparison expression.
+ * Compile a comparison expression.
  * Get the logic value of expression, true or false
  * Input:
  *      expression    - A comparison expression like VAR1 >= MEM1 + 10
  *      len           - Length of expression
  * Output:
  *      N/A
- * Return:
- *      logic value of comparison expression
  */
-bool evaluateComparisonExpression(const char *expression, int len)
+void RulesExprCompileComparison(const char *expression, int len)
 {
-  bool bResult = true;
   char expbuf[len + 1];
   memcpy(expbuf, expression, len);
   expbuf[len] = '\0';
@@ -1573,36 +1930,18 @@ bool evaluateComparisonExpression(const char *expression, int len)
   String leftExpr, rightExpr;
   int8_t compareOp = parseCompareExpression(compare_expression, leftExpr, rightExpr);
 
-  double leftValue = evaluateExpression(leftExpr.c_str(), leftExpr.length());
-  double rightValue = evaluateExpression(rightExpr.c_str(), rightExpr.length());
   switch (compareOp) {
-    case COMPARE_OPERATOR_EXACT_DIVISION:
-      bResult = (rightValue != 0 && leftValue == int(leftValue)
-          && rightValue == int(rightValue) && (int(leftValue) % int(rightValue)) == 0);
+    case COMPARE_OPERATOR_NONE:
+      RulesExprEmitValue(RULES_EXPR_CONST, 1);
       break;
     case COMPARE_OPERATOR_EQUAL:
-      bResult = leftExpr.equalsIgnoreCase(rightExpr);  // Compare strings - this also works for hexadecimals
-      break;
-    case COMPARE_OPERATOR_BIGGER:
-      bResult = (leftValue > rightValue);
-      break;
-    case COMPARE_OPERATOR_SMALLER:
-      bResult = (leftValue < rightValue);
-      break;
-    case COMPARE_OPERATOR_NUMBER_EQUAL:
-      bResult = (leftValue == rightValue);
-      break;
-    case COMPARE_OPERATOR_NOT_EQUAL:
-      bResult = (leftValue != rightValue);
-      break;
-    case COMPARE_OPERATOR_BIGGER_EQUAL:
-      bResult = (leftValue >= rightValue);
-      break;
-    case COMPARE_OPERATOR_SMALLER_EQUAL:
-      bResult = (leftValue <= rightValue);
+      RulesExprEmitValue(RULES_EXPR_CONST, leftExpr.equalsIgnoreCase(rightExpr));  // Compare strings - this also works for hexadecimals
       break;
+    default:
+      RulesExprCompileArithmetic(leftExpr.c_str(), leftExpr.length());
+      RulesExprCompileArithmetic(rightExpr.c_str(), rightExpr.length());
+      RulesExprEmitCode(RULES_EXPR_COMPARE + compareOp, -1);
   }
-  return bResult;
 }
 
 /********************************************************************************************/
@@ -1642,21 +1981,19 @@ bool findNextLogicOperator(char * &pointer, int8_t &op)
 
 /********************************************************************************************/
 /*
- * Find next logical object and get its value
+ * Find next logical object and compile it
  *      A logical object could be:
  *        - A comparison expression.
  *        - A logical expression bracketed with a pair of parenthesis.
  * Input:
  *      pointer     - A char pointer point to a start of logical object
- *      value       - Used to accept the result value
  * Output:
  *      pointer     - Pointer forward to next character after the object
- *      value       - boolean type, the value of the logical object.
  * Return:
  *      true    - succeed
  *      false   - failed
  */
-bool findNextLogicObjectValue(char * &pointer, bool &value)
+bool findNextLogicObject(char * &pointer)
 {
   bool bSucceed = false;
   while (*pointer && isspace(*pointer)) {
@@ -1669,13 +2006,13 @@ bool findNextLogicObjectValue(char * &pointer, bool &value)
        && (strncasecmp_P(pointer, PSTR("AND "), 4) == 0
        || strncasecmp_P(pointer, PSTR("OR "), 3) == 0))
     {      //We have a logic operator, should stop
-      value = evaluateComparisonExpression(pExpr, pointer - pExpr);
+      RulesExprCompileComparison(pExpr, pointer - pExpr);
       bSucceed = true;
       break;
     } else if (*pointer == '(') {     //It is a sub expression bracketed with ()
       char * closureBracket = findClosureBracket(pointer);        //Get the position of closure bracket ")"
       if (closureBracket != nullptr) {
-        value = evaluateLogicalExpression(pointer+1, closureBracket - pointer - 1);
+        RulesExprCompileLogical(pointer+1, closureBracket - pointer - 1);
         pointer = closureBracket + 1;
         bSucceed = true;
       }
@@ -1685,7 +2022,7 @@ bool findNextLogicObjectValue(char * &pointer, bool &value)
   }
   if (!bSucceed && pointer > pExpr) {
     //The whole buffer is an comparison expression
-    value = evaluateComparisonExpression(pExpr, pointer - pExpr);
+    RulesExprCompileComparison(pExpr, pointer - pExpr);
     bSucceed = true;
   }
   return bSucceed;
@@ -1693,71 +2030,73 @@ bool findNextLogicObjectValue(char * &pointer, bool &value)
 
 /********************************************************************************************/
 /*
- * Evaluate a logical expression
+ * Compile the logical operators following a logical object with at least min_priority
+ *     "AND" is compiled before "OR". Compilation stops at the first missing operator or object.
+ */
+void RulesExprCompileLogicOperators(char * &pointer, uint32_t min_priority)
+{
+  while (!RulesExpr.stop && *pointer) {
+    char *start = pointer;
+    int8_t op;
+    if (!findNextLogicOperator(pointer, op)) {
+      RulesExpr.stop = true;
+      break;
+    }
+    uint32_t priority = (LOGIC_OPERATOR_AND == op) ? 2 : 1;
+    if (priority < min_priority) {
+      pointer = start;                        // Leave operator to the caller
+      break;
+    }
+    if (!*pointer || !findNextLogicObject(pointer)) {
+      RulesExpr.stop = true;
+      break;
+    }
+    RulesExprCompileLogicOperators(pointer, priority +1);
+    RulesExprEmitCode((LOGIC_OPERATOR_AND == op) ? RULES_EXPR_AND : RULES_EXPR_OR, -1);
+  }
+}
+
+/********************************************************************************************/
+/*
+ * Compile a logical expression
  *    Logic expression is constructed with multiple comparison expressions and logical
  *    operators between them. For example: Mem1==0 AND (time > sunrise + 60).
  *    Parenthesis are allowed to change the priority of logical operators.
  * Input:
  *      expression  - A logical expression
  *      len         - Length of the expression
- * Output:
- *      N/A
- * Return:
- *      boolean     - the value of logical expression
+ * An invalid expression compiles to false
  */
-bool evaluateLogicalExpression(const char * expression, int len)
+void RulesExprCompileLogical(const char * expression, int len)
 {
-  bool bResult = false;
   //Make a copy first
   char expbuff[len + 1];
   memcpy(expbuff, expression, len);
   expbuff[len] = '\0';
-
-  //AddLog_P2(LOG_LEVEL_DEBUG, PSTR("EvalLogic: |%s|"), expbuff);
   char * pointer = expbuff;
-  LinkedList<bool> values;
-  LinkedList<int8_t> logicOperators;
-  //Find first comparison expression
-  bool bValue;
-  if (findNextLogicObjectValue(pointer, bValue)) {
-    values.add(bValue);
+
+  bool stop = RulesExpr.stop;
+  RulesExpr.stop = false;
+  if (findNextLogicObject(pointer)) {
+    RulesExprCompileLogicOperators(pointer, 1);
   } else {
-    return false;
-  }
-  int8_t op;
-  while (*pointer) {
-    if (findNextLogicOperator(pointer, op)
-      && (*pointer) && findNextLogicObjectValue(pointer, bValue))
-    {
-      logicOperators.add(op);
-      values.add(bValue);
-    } else {
-      break;
-    }
+    RulesExprEmitValue(RULES_EXPR_CONST, 0);
   }
-  //Calculate all "AND" first
-  int index = 0;
-  while (index < logicOperators.size()) {
-    if (logicOperators.get(index) == LOGIC_OPERATOR_AND) {
-      values.set(index, values.get(index) && values.get(index+1));
-      values.remove(index + 1);
-      logicOperators.remove(index);
-    } else {
-      index++;
-    }
-  }
-  //Then, calculate all "OR"
-  index = 0;
-  while (index < logicOperators.size()) {
-    if (logicOperators.get(index) == LOGIC_OPERATOR_OR) {
-      values.set(index, values.get(index) || values.get(index+1));
-      values.remove(index + 1);
-      logicOperators.remove(index);
-    } else {
-      index++;
-    }
-  }
-  return values.get(0);
+  RulesExpr.stop = stop;
+}
+
+/********************************************************************************************/
+/*
+ * Evaluate a logical expression
+ * Input:
+ *      expression  - A logical expression
+ *      len         - Length of the expression
+ * Return:
+ *      boolean     - the value of logical expression
+ */
+bool evaluateLogicalExpression(const char * expression, int len)
+{
+  return (RulesExprEvaluate(expression, len, true) != 0);
 }
 
 /********************************************************************************************/
@@ -1841,10 +2180,12 @@ void ExecuteCommandBlock(const char * commands, int len)
 
   //AddLog_P2(LOG_LEVEL_DEBUG, PSTR("ExecCmd: |%s|"), cmdbuff);
   char oneCommand[len + 1];     //To put one command
-  int insertPosition = 0;       //When insert into backlog, we should do it by 0, 1, 2 ...
+  uint16_t cmdStart[MAX_BACKLOG];   //Position of each command found in cmdbuff
+  uint16_t cmdLength[MAX_BACKLOG];
+  uint32_t cmdCount = 0;
   char * pos = cmdbuff;
   int lenEndBlock = 0;
-  while (*pos) {
+  while (*pos && (cmdCount < MAX_BACKLOG)) {
     if (isspace(*pos) || '\x1e' == *pos || ';' == *pos) {
       pos++;
       continue;
@@ -1854,6 +2195,7 @@ void ExecuteCommandBlock(const char * commands, int len)
       pos += 8;
       continue;
     }
+    char *pStart = pos;
     if (strncasecmp_P(pos, PSTR("IF "), 3) == 0) {
       //Has a nested IF statement
       //Find the matched ENDIF
@@ -1862,9 +2204,7 @@ void ExecuteCommandBlock(const char * commands, int len)
         //Cannot find matched endif, stop execution.
         break;
       }
-      //We has the whole IF statement, copy to oneCommand
-      memcpy(oneCommand, pos, pEndif - pos);
-      oneCommand[pEndif - pos] = '\0';
+      //We has the whole IF statement
       pos = pEndif;
     } else {    //Normal command
       //Looking for the command end single - '\x1e'
@@ -1872,24 +2212,24 @@ void ExecuteCommandBlock(const char * commands, int len)
       if (NULL == pEndOfCommand) {
         pEndOfCommand = pos + strlen(pos);
       }
-      memcpy(oneCommand, pos, pEndOfCommand - pos);
-      oneCommand[pEndOfCommand - pos] = '\0';
       pos = pEndOfCommand;
     }
-    //Start to process current command we found
-    //Going to insert the command into backlog
-    String sCurrentCommand = oneCommand;
-    sCurrentCommand.trim();
-    if (sCurrentCommand.length() > 0
-      && backlog.size() < MAX_BACKLOG && !backlog_mutex)
-    {
-      //Insert into backlog
-      backlog_mutex = true;
-      backlog.add(insertPosition, sCurrentCommand);
-      backlog_mutex = false;
-      insertPosition++;
+    //Remember the trimmed command we found
+    char *pEnd = pos;
+    while ((pEnd > pStart) && isspace(*(pEnd -1))) { pEnd--; }
+    if (pEnd > pStart) {
+      cmdStart[cmdCount] = pStart - cmdbuff;
+      cmdLength[cmdCount] = pEnd - pStart;
+      cmdCount++;
     }
   }
+  //Insert the commands in front of the backlog keeping their order
+  while (cmdCount) {
+    cmdCount--;
+    memcpy(oneCommand, cmdbuff + cmdStart[cmdCount], cmdLength[cmdCount]);
+    oneCommand[cmdLength[cmdCount]] = '\0';
+    BacklogInsert(oneCommand);
+  }
   return;
 }
 
@@ -2101,7 +2441,7 @@ void CmndRule(void)
     // snprintf_P (mqtt_data, sizeof(mqtt_data), PSTR("{\"%s%d\":\"%s\",\"Once\":\"%s\",\"StopOnError\":\"%s\",\"Free\":%d,\"Rules\":\"%s\"}"),
     //   XdrvMailbox.command, index, GetStateText(bitRead(Settings.rule_enabled, index -1)), GetStateText(bitRead(Settings.rule_once, index -1)),
     //   GetStateText(bitRead(Settings.rule_stop, index -1)), sizeof(Settings.rules[index -1]) - strlen(Settings.rules[index -1]) -1, Settings.rules[index -1]);
-    snprintf_P (mqtt_data, sizeof(mqtt_data), PSTR("{\"%s%d\":\"%s\",\"Once\":\"%s\",\"StopOnError\":\"%s\",\"Length\":%d,\"Free\":%d,\"Rules\":\"%s\"}"),
+    Response_P(PSTR("{\"%s%d\":\"%s\",\"Once\":\"%s\",\"StopOnError\":\"%s\",\"Length\":%d,\"Free\":%d,\"Rules\":\"%s\"}"),
       XdrvMailbox.command, index, GetStateText(bitRead(Settings.rule_enabled, index -1)), GetStateText(bitRead(Settings.rule_once, index -1)),
       GetStateText(bitRead(Settings.rule_stop, index -1)),
       rule_len, MAX_RULE_SIZE - GetRuleLenStorage(index - 1),
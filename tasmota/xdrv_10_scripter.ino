@@ -39,6 +39,7 @@ keywords if then else endif, or, and are better readable for beginners (others m
 \*********************************************************************************************/
 
 #define XDRV_10             10
+#define XDRV_10_TICKS       (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_100_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 #define XI2C_37             37  // See I2CDEVICES.md
 
 #define SCRIPT_DEBUG 0
@@ -264,6 +265,7 @@ SDClass *fsp;
     String Event;
     String Topic;
     String Key;
+    uint8_t Id;                           // Consumer id in MQTT topic registry
   } MQTT_Subscription;
   LinkedList<MQTT_Subscription> subscriptions;
 #endif    //SUPPORT_MQTT_EVENT
@@ -309,7 +311,8 @@ struct M_FILT {
   uint8_t numvals;
   uint8_t index;
 #endif // LARGE_ARRAYS
-  float maccu;
+  double maccu;   // running sum and sum of squares, double to keep variance of long windows
+  double msqu;
   float rbuff[1];
 };
 
@@ -406,6 +409,13 @@ struct SCRIPT_MEM {
     uint8_t siro_num[3];
     uint8_t sind_num;
     char *last_index_string[3];
+    struct SCRIPT_CODE *code; // compiled expressions
+    uint16_t code_slots;
+    uint16_t code_used;
+    uint16_t *section_index; // offsets of section and label lines
+    uint16_t section_num;
+    uint8_t *var_hash; // variable indices by name hash
+    uint16_t var_hash_size;
 
 #ifdef USE_SCRIPT_FATFS
     File files[SFS_MAX];
@@ -441,6 +451,77 @@ uint8_t fast_script=0;
 uint8_t glob_script=0;
 uint32_t script_lastmillis;
 
+#if defined(ESP32) && defined(USE_SCRIPT_TASK)
+#ifndef STASK_QUEUE_SIZE
+#define STASK_QUEUE_SIZE 32
+#endif
+
+#ifndef STASK_LOCK_WAIT
+#define STASK_LOCK_WAIT 20
+#endif
+
+// main loop and tasks share all script variables, so sections run one at a time, tasks have no
+// local variables. tasks and event sections wait for the lock, the main loop skips periodic
+// (>S, >F) and web display sections after STASK_LOCK_WAIT mS
+SemaphoreHandle_t script_mutex;
+
+bool script_lock(bool skip) {
+  if (!script_mutex) return true;
+  TickType_t wait = (skip && !script_task_num()) ? pdMS_TO_TICKS(STASK_LOCK_WAIT) : portMAX_DELAY;
+  if (xSemaphoreTakeRecursive(script_mutex, wait)==pdTRUE) return true;
+  AddLog_P(LOG_LEVEL_DEBUG, PSTR("Script: task busy, section skipped"));
+  return false;
+}
+
+// periodic sections run again soon
+bool script_periodic(const char *type) {
+  return (type[0]=='>' && type[1] && strchr("SFWwJ", type[1]) && !type[2]);
+}
+
+#define SCRIPT_LOCK script_lock(true)
+#define SCRIPT_LOCK_SECTION(type) script_lock(script_periodic(type))
+#define SCRIPT_LOCK_WAIT if (script_mutex) xSemaphoreTakeRecursive(script_mutex, portMAX_DELAY);
+#define SCRIPT_UNLOCK if (script_mutex) xSemaphoreGiveRecursive(script_mutex);
+
+// single producer single consumer queue per task, task posts and main loop gets
+// queue 0 belongs to task 1 (>t1) and queue 1 to task 2 (>t2)
+struct STASK_QUEUE {
+  volatile uint16_t head;
+  volatile uint16_t tail;
+  float buff[STASK_QUEUE_SIZE];
+} stask_queue[2];
+
+bool stask_put(uint8_t num, float val) {
+  struct STASK_QUEUE *qp = &stask_queue[num];
+  uint16_t next = (qp->head + 1) % STASK_QUEUE_SIZE;
+  if (next==qp->tail) return false;
+  qp->buff[qp->head] = val;
+  __sync_synchronize();
+  qp->head = next;
+  return true;
+}
+
+bool stask_get(uint8_t num, float *val) {
+  struct STASK_QUEUE *qp = &stask_queue[num];
+  if (qp->tail==qp->head) return false;
+  __sync_synchronize();
+  *val = qp->buff[qp->tail];
+  __sync_synchronize();
+  qp->tail = (qp->tail + 1) % STASK_QUEUE_SIZE;
+  return true;
+}
+
+uint16_t stask_count(uint8_t num) {
+  struct STASK_QUEUE *qp = &stask_queue[num];
+  return (qp->head + STASK_QUEUE_SIZE - qp->tail) % STASK_QUEUE_SIZE;
+}
+#else
+#define SCRIPT_LOCK true
+#define SCRIPT_LOCK_SECTION(type) true
+#define SCRIPT_LOCK_WAIT
+#define SCRIPT_UNLOCK
+#endif // USE_SCRIPT_TASK
+
 void flt2char(float num, char *nbuff) {
   dtostrfd(num, glob_script_mem.script_dprec, nbuff);
 }
@@ -547,6 +628,8 @@ char *script;
 
     glob_script_mem.max_ssize = SCRIPT_SVARSIZE;
     glob_script_mem.scriptptr = 0;
+    clr_code();
+    index_sections();
 
     if (!*script) return -999;
 
@@ -827,6 +910,7 @@ char *script;
     }
 
     glob_script_mem.numvars = vars;
+    index_vars();
     glob_script_mem.script_dprec = SCRIPT_FLOAT_PRECISION;
     glob_script_mem.script_lzero = 0;
     glob_script_mem.script_loglevel = LOG_LEVEL_INFO;
@@ -858,6 +942,7 @@ char *script;
             while (len--) {
               *fa++ = *fp++;
             }
+            Sum_MFilter(Get_MFilt(index));
         } else {
           if (!isnan(*fp)) {
             glob_script_mem.fvars[index] = *fp;
@@ -916,6 +1001,7 @@ char *script;
     // store start of actual program here
     glob_script_mem.scriptptr = lp - 1;
     glob_script_mem.scriptptr_bu = glob_script_mem.scriptptr;
+    index_sections();
 
 #ifdef USE_SCRIPT_GLOBVARS
     if (glob_script_mem.udp_flags.udp_used) {
@@ -1110,35 +1196,84 @@ void ws2812_set_array(float *array ,uint32_t len, uint32_t offset) {
 
 
 
+#define MEDIAN_STACK_SIZE 16
+
+// median of array by quickselect on a copy, array order is kept
 float median_array(float *array, uint16_t len) {
-    uint8_t ind[len];
-    uint8_t mind = 0;
-    uint8_t index = 0;
-    uint8_t flg;
-    float min = FLT_MAX;
-
-    for (uint8_t hcnt = 0; hcnt<len/2+1; hcnt++) {
-        for (uint8_t mcnt = 0; mcnt<len; mcnt++) {
-            flg = 0;
-            for (uint8_t icnt = 0; icnt<index; icnt++) {
-                if (ind[icnt] == mcnt) {
-                    flg = 1;
-                }
-            }
-            if (!flg) {
-                if (array[mcnt]<min) {
-                    min = array[mcnt];
-                    mind = mcnt;
-                }
-            }
-        }
-        ind[index] = mind;
-        index++;
-        min = FLT_MAX;
+  if (!len) return 0;
+  uint16_t mid = len / 2;
+  float sbuf[MEDIAN_STACK_SIZE];
+  float *tmp = sbuf;
+  if (len>MEDIAN_STACK_SIZE) {
+    tmp = (float*)malloc(len * sizeof(float));
+    if (!tmp) {
+      // no memory for a copy, count smaller values instead
+      for (uint16_t cnt = 0; cnt<len; cnt++) {
+        uint16_t less = 0, equal = 0;
+        for (uint16_t icnt = 0; icnt<len; icnt++) {
+          if (array[icnt]<array[cnt]) less++;
+          else if (array[icnt]==array[cnt]) equal++;
+        }
+        if (less<=mid && mid<less + equal) return array[cnt];
+      }
+      return array[mid];
+    }
+  }
+  memcpy(tmp, array, len * sizeof(float));
+  int32_t lo = 0, hi = len - 1;
+  while (lo<hi) {
+    float pivot = tmp[(lo + hi) / 2];
+    int32_t i = lo, j = hi;
+    while (i<=j) {
+      while (tmp[i]<pivot) i++;
+      while (tmp[j]>pivot) j--;
+      if (i<=j) {
+        float swp = tmp[i];
+        tmp[i] = tmp[j];
+        tmp[j] = swp;
+        i++;
+        j--;
+      }
     }
-    return array[ind[len / 2]];
+    if (mid<=j) hi = j;
+    else if (mid>=i) lo = i;
+    else break;
+  }
+  float median = tmp[mid];
+  if (tmp!=sbuf) free(tmp);
+  return median;
 }
 
+enum {ASTAT_MEAN, ASTAT_VAR, ASTAT_MIN, ASTAT_MAX, ASTAT_SUM, ASTAT_MEDIAN};
+
+// mean, variance, min, max, sum or median of array
+float array_stat(float *array, uint16_t len, uint8_t sel) {
+  if (!len) return 0;
+  if (sel==ASTAT_MEDIAN) return median_array(array, len);
+  float sum = 0, min = array[0], max = array[0];
+  for (uint16_t cnt = 0; cnt<len; cnt++) {
+    sum += array[cnt];
+    if (array[cnt]<min) min = array[cnt];
+    if (array[cnt]>max) max = array[cnt];
+  }
+  switch (sel) {
+    case ASTAT_MEAN:
+      return sum / len;
+    case ASTAT_VAR: {
+      float mean = sum / len;
+      float var = 0;
+      for (uint16_t cnt = 0; cnt<len; cnt++) {
+        var += (array[cnt] - mean) * (array[cnt] - mean);
+      }
+      return var / len;
+    }
+    case ASTAT_MIN:
+      return min;
+    case ASTAT_MAX:
+      return max;
+  }
+  return sum;
+}
 
 float *Get_MFAddr(uint8_t index, uint16_t *len, uint16_t *ipos) {
   *len = 0;
@@ -1173,6 +1308,19 @@ float *get_array_by_name(char *name, uint16_t *alen) {
   return 0;
 }
 
+// parse array variable argument, index is filter index or -1
+char *get_array_arg(char *lp, int16_t *index) {
+  struct T_INDEX ind;
+  uint8_t vtype;
+  lp = isvar(lp, &vtype, &ind, 0, 0, 0);
+  *index = -1;
+  if (vtype!=VAR_NV && (vtype&STYPE)==0 && glob_script_mem.type[ind.index].bits.is_filter) {
+    *index = glob_script_mem.type[ind.index].index;
+  }
+  SCRIPT_SKIP_SPACES
+  return lp;
+}
+
 float Get_MFVal(uint8_t index, int16_t bind) {
   uint8_t *mp = (uint8_t*)glob_script_mem.mfilt;
   for (uint8_t count = 0; count<MAXFILT; count++) {
@@ -1203,6 +1351,11 @@ void Set_MFVal(uint8_t index, uint16_t bind, float val) {
           mflp->index = val;
         } else {
           if (bind<1 || bind>maxind) bind = maxind;
+          if (mflp->numvals & OR_FILT_MASK) {
+            double ovar = mflp->rbuff[bind-1];
+            mflp->maccu += val - ovar;
+            mflp->msqu += (double)val * val - ovar * ovar;
+          }
           mflp->rbuff[bind-1] = val;
         }
         return;
@@ -1212,6 +1365,43 @@ void Set_MFVal(uint8_t index, uint16_t bind, float val) {
 }
 
 
+void Sum_MFilter(struct M_FILT *mflp) {
+  uint16_t maxind = mflp->numvals & AND_FILT_MASK;
+  mflp->maccu = 0;
+  mflp->msqu = 0;
+  for (uint16_t cnt = 0; cnt<maxind; cnt++) {
+    double val = mflp->rbuff[cnt];
+    mflp->maccu += val;
+    mflp->msqu += val * val;
+  }
+}
+
+struct M_FILT *Get_MFilt(uint8_t index) {
+  uint8_t *mp = (uint8_t*)glob_script_mem.mfilt;
+  for (uint8_t count = 0; count<MAXFILT; count++) {
+    struct M_FILT *mflp = (struct M_FILT*)mp;
+    if (count==index) {
+      return mflp;
+    }
+    mp += sizeof(struct M_FILT) + ((mflp->numvals & AND_FILT_MASK) - 1) * sizeof(float);
+  }
+  return 0;
+}
+
+// array statistics, moving average mean and variance from running sums
+float Get_MFStat(uint8_t index, uint8_t sel) {
+  struct M_FILT *mflp = Get_MFilt(index);
+  if (!mflp) return 0;
+  uint16_t maxind = mflp->numvals & AND_FILT_MASK;
+  if ((mflp->numvals & OR_FILT_MASK) && sel<=ASTAT_VAR) {
+    double mean = mflp->maccu / maxind;
+    if (sel==ASTAT_MEAN) return mean;
+    double var = mflp->msqu / maxind - mean * mean;
+    return var>0 ? var : 0;
+  }
+  return array_stat(mflp->rbuff, maxind, sel);
+}
+
 float Get_MFilter(uint8_t index) {
   uint8_t *mp = (uint8_t*)glob_script_mem.mfilt;
   for (uint8_t count = 0; count<MAXFILT; count++) {
@@ -1236,12 +1426,17 @@ void Set_MFilter(uint8_t index, float invar) {
     struct M_FILT *mflp = (struct M_FILT*)mp;
     if (count==index) {
       if (mflp->numvals & OR_FILT_MASK) {
-        // moving average
-        mflp->maccu -= mflp->rbuff[mflp->index];
-        mflp->maccu += invar;
+        // moving average, running sum and sum of squares
+        double ovar = mflp->rbuff[mflp->index];
+        mflp->maccu += invar - ovar;
+        mflp->msqu += (double)invar * invar - ovar * ovar;
         mflp->rbuff[mflp->index] = invar;
         mflp->index++;
-        if (mflp->index>=(mflp->numvals&AND_FILT_MASK)) mflp->index = 0;
+        if (mflp->index>=(mflp->numvals&AND_FILT_MASK)) {
+          mflp->index = 0;
+          // resum once per window to drop accumulated rounding errors
+          Sum_MFilter(mflp);
+        }
       } else {
         // median
         mflp->rbuff[mflp->index] = invar;
@@ -1408,29 +1603,23 @@ uint32_t MeasurePulseTime(int32_t in) {
 
 #ifdef USE_SCRIPT_GLOBVARS
 uint32_t match_vars(char *dvnam, float **fp, char **sp, uint32_t *ind) {
-  uint16_t olen = strlen(dvnam);
   struct T_INDEX *vtp = glob_script_mem.type;
-  for (uint32_t count = 0; count<glob_script_mem.numvars; count++) {
-    char *cp = glob_script_mem.glob_vnp + glob_script_mem.vnp_offset[count];
-    uint8_t slen = strlen(cp);
-    if (slen==olen && *cp==dvnam[0]) {
-      if (!strncmp(cp, dvnam, olen)) {
-        uint8_t index = vtp[count].index;
-        if (vtp[count].bits.is_string==0) {
-          if (vtp[count].bits.is_filter) {
-            // error
-            return 0;
-          } else {
-            *fp = &glob_script_mem.fvars[index];
-            *ind = count;
-            return NUM_RES;
-          }
-        } else {
-          *sp = glob_script_mem.glob_snp + (index * glob_script_mem.max_ssize);
-          *ind = count;
-          return STR_RES;
-        }
+  int16_t count = find_var(dvnam, strlen(dvnam));
+  if (count>=0) {
+    uint8_t index = vtp[count].index;
+    if (vtp[count].bits.is_string==0) {
+      if (vtp[count].bits.is_filter) {
+        // error
+        return 0;
+      } else {
+        *fp = &glob_script_mem.fvars[index];
+        *ind = count;
+        return NUM_RES;
       }
+    } else {
+      *sp = glob_script_mem.glob_snp + (index * glob_script_mem.max_ssize);
+      *ind = count;
+      return STR_RES;
     }
   }
   return 0;
@@ -1513,6 +1702,62 @@ float fvar;
   return lp;
 }
 
+// FNV-1a hash of variable name
+uint32_t hash_name(const char *vname, uint8_t olen) {
+  uint32_t hash = 2166136261;
+  while (olen--) {
+    hash ^= (uint8_t)*vname++;
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+// build open addressing hash table of variable indices over variable names
+void index_vars(void) {
+  if (glob_script_mem.var_hash) free(glob_script_mem.var_hash);
+  glob_script_mem.var_hash = 0;
+  uint16_t size = 8;
+  while (size < glob_script_mem.numvars * 2) size <<= 1;
+  uint8_t *table = (uint8_t*)malloc(size);
+  if (!table) return;
+  memset(table, VAR_NV, size);
+  for (uint16_t count = 0; count<glob_script_mem.numvars; count++) {
+    char *cp = glob_script_mem.glob_vnp + glob_script_mem.vnp_offset[count];
+    uint32_t slot = hash_name(cp, strlen(cp)) & (size - 1);
+    while (table[slot]!=VAR_NV) slot = (slot + 1) & (size - 1);
+    table[slot] = count;
+  }
+  glob_script_mem.var_hash = table;
+  glob_script_mem.var_hash_size = size;
+}
+
+int16_t find_var(const char *vname, uint8_t olen) {
+  // return index of script variable vname with length olen or -1
+  if (glob_script_mem.var_hash) {
+    uint16_t mask = glob_script_mem.var_hash_size - 1;
+    uint32_t slot = hash_name(vname, olen) & mask;
+    uint8_t count;
+    while ((count = glob_script_mem.var_hash[slot])!=VAR_NV) {
+      char *cp = glob_script_mem.glob_vnp + glob_script_mem.vnp_offset[count];
+      if (!strncmp(cp, vname, olen) && !cp[olen]) {
+        return count;
+      }
+      slot = (slot + 1) & mask;
+    }
+    return -1;
+  }
+  for (uint16_t count = 0; count<glob_script_mem.numvars; count++) {
+    char *cp = glob_script_mem.glob_vnp + glob_script_mem.vnp_offset[count];
+    uint8_t slen = strlen(cp);
+    if (slen==olen && *cp==vname[0]) {
+      if (!strncmp(cp, vname, olen)) {
+        return count;
+      }
+    }
+  }
+  return -1;
+}
+
 // vtype => ff=nothing found, fe=constant number,fd = constant string else bit 7 => 80 = string, 0 = number
 // no flash strings here for performance reasons!!!
 char *isvar(char *lp, uint8_t *vtype, struct T_INDEX *tind, float *fp, char *sp, JsonParserObject *jo) {
@@ -1611,38 +1856,34 @@ char *isvar(char *lp, uint8_t *vtype, struct T_INDEX *tind, float *fp, char *sp,
       ja++;
       olen = strlen(dvnam);
     }
-    for (count = 0; count<glob_script_mem.numvars; count++) {
-        char *cp = glob_script_mem.glob_vnp + glob_script_mem.vnp_offset[count];
-        uint8_t slen = strlen(cp);
-        if (slen==olen && *cp==dvnam[0]) {
-            if (!strncmp(cp, dvnam, olen)) {
-                uint8_t index = vtp[count].index;
-                *tind = vtp[count];
-                tind->index = count; // overwrite with global var index
-                if (vtp[count].bits.is_string==0) {
-                    *vtype = NTYPE | index;
-                    if (vtp[count].bits.is_filter) {
-                      if (ja) {
-                        lp += olen + 1;
-                        lp = GetNumericArgument(lp, OPER_EQU, &fvar, 0);
-                        last_findex = fvar;
-                        fvar = Get_MFVal(index, fvar);
-                        len = 1;
-                      } else {
-                        fvar = Get_MFilter(index);
-                      }
-                    } else {
-                      fvar = glob_script_mem.fvars[index];
-                    }
-                    if (nres) fvar = -fvar;
-                    if (fp) *fp = fvar;
-                } else {
-                    *vtype = STYPE|index;
-                    if (sp) strlcpy(sp, glob_script_mem.glob_snp + (index * glob_script_mem.max_ssize), SCRIPT_MAXSSIZE);
-                }
-                return lp + len;
+    int16_t vindex = find_var(dvnam, olen);
+    if (vindex>=0) {
+        count = vindex;
+        uint8_t index = vtp[count].index;
+        *tind = vtp[count];
+        tind->index = count; // overwrite with global var index
+        if (vtp[count].bits.is_string==0) {
+            *vtype = NTYPE | index;
+            if (vtp[count].bits.is_filter) {
+              if (ja) {
+                lp += olen + 1;
+                lp = GetNumericArgument(lp, OPER_EQU, &fvar, 0);
+                last_findex = fvar;
+                fvar = Get_MFVal(index, fvar);
+                len = 1;
+              } else {
+                fvar = Get_MFilter(index);
+              }
+            } else {
+              fvar = glob_script_mem.fvars[index];
             }
+            if (nres) fvar = -fvar;
+            if (fp) *fp = fvar;
+        } else {
+            *vtype = STYPE|index;
+            if (sp) strlcpy(sp, glob_script_mem.glob_snp + (index * glob_script_mem.max_ssize), SCRIPT_MAXSSIZE);
         }
+        return lp + len;
     }
 
     if (jo) {
@@ -1804,6 +2045,42 @@ chknext:
           len = 0;
           goto exit;
         }
+        if (!strncmp(vname, "aop(", 4)) {
+          // scale and offset array in place
+          int16_t index;
+          lp = get_array_arg(lp + 4, &index);
+          float mul, add;
+          lp = GetNumericArgument(lp, OPER_EQU, &mul, 0);
+          SCRIPT_SKIP_SPACES
+          lp = GetNumericArgument(lp, OPER_EQU, &add, 0);
+          fvar = 0;
+          if (index>=0) {
+            struct M_FILT *mflp = Get_MFilt(index);
+            uint16_t alen = mflp->numvals & AND_FILT_MASK;
+            for (uint16_t cnt = 0; cnt<alen; cnt++) {
+              mflp->rbuff[cnt] = mflp->rbuff[cnt] * mul + add;
+            }
+            Sum_MFilter(mflp);
+            fvar = alen;
+          }
+          lp++;
+          len = 0;
+          goto exit;
+        }
+        if (!strncmp(vname, "ast(", 4)) {
+          // array statistics
+          int16_t index;
+          lp = get_array_arg(lp + 4, &index);
+          float sel;
+          lp = GetNumericArgument(lp, OPER_EQU, &sel, 0);
+          fvar = 0;
+          if (index>=0) {
+            fvar = Get_MFStat(index, sel);
+          }
+          lp++;
+          len = 0;
+          goto exit;
+        }
         break;
 
       case 'b':
@@ -1875,6 +2152,53 @@ chknext:
           fvar = RtcTime.day_of_month;
           goto exit;
         }
+        if (!strncmp(vname, "dec(", 4)) {
+          // decimate array by averaging blocks of n values into destination array
+          int16_t dindex, sindex;
+          lp = get_array_arg(lp + 4, &dindex);
+          lp = get_array_arg(lp, &sindex);
+          float fvar1;
+          lp = GetNumericArgument(lp, OPER_EQU, &fvar1, 0);
+          uint16_t num = fvar1;
+          fvar = 0;
+          if (dindex>=0 && sindex>=0 && dindex!=sindex && num) {
+            uint16_t dlen, slen;
+            float *da = Get_MFAddr(dindex, &dlen, 0);
+            float *sa = Get_MFAddr(sindex, &slen, 0);
+            uint16_t cnt;
+            for (cnt = 0; cnt<dlen && (cnt + 1) * num<=slen; cnt++) {
+              float sum = 0;
+              for (uint16_t icnt = 0; icnt<num; icnt++) {
+                sum += *sa++;
+              }
+              da[cnt] = sum / num;
+            }
+            Sum_MFilter(Get_MFilt(dindex));
+            fvar = cnt;
+          }
+          lp++;
+          len = 0;
+          goto exit;
+        }
+        if (!strncmp(vname, "dot(", 4)) {
+          // dot product of two arrays
+          int16_t index1, index2;
+          lp = get_array_arg(lp + 4, &index1);
+          lp = get_array_arg(lp, &index2);
+          fvar = 0;
+          if (index1>=0 && index2>=0) {
+            uint16_t len1, len2;
+            float *fa1 = Get_MFAddr(index1, &len1, 0);
+            float *fa2 = Get_MFAddr(index2, &len2, 0);
+            if (len2<len1) len1 = len2;
+            for (uint16_t cnt = 0; cnt<len1; cnt++) {
+              fvar += fa1[cnt] * fa2[cnt];
+            }
+          }
+          lp++;
+          len = 0;
+          goto exit;
+        }
         break;
       case 'e':
         if (!strncmp(vname, "epoch", 5)) {
@@ -2284,6 +2608,7 @@ chknext:
               *cp = 0;
               *fa++=CharToFloat(str);
             }
+            Sum_MFilter(Get_MFilt(glob_script_mem.type[ind.index].index));
           } else {
             fvar = 0;
           }
@@ -2983,6 +3308,43 @@ chknext:
 
 #endif //USE_TOUCH_BUTTONS
 #endif //USE_DISPLAY
+
+#if defined(ESP32) && defined(USE_SCRIPT_TASK)
+        if (!strncmp(vname, "tqp(", 4)) {
+          // post value from task n to main loop queue, only allowed in its own task
+          lp = GetNumericArgument(lp + 4, OPER_EQU, &fvar, 0);
+          SCRIPT_SKIP_SPACES
+          float fvar1;
+          lp = GetNumericArgument(lp, OPER_EQU, &fvar1, 0);
+          uint8_t num = script_task_num();
+          if (num && (num==fvar)) {
+            fvar = stask_put(num - 1, fvar1);
+          } else {
+            fvar = 0;
+          }
+          lp++;
+          len = 0;
+          goto exit;
+        }
+        if (!strncmp(vname, "tqg(", 4)) {
+          // get next value queued by task n, 0 if empty, only allowed in main loop
+          lp = GetNumericArgument(lp + 4, OPER_EQU, &fvar, 0);
+          uint8_t num = fvar>1;
+          fvar = 0;
+          if (!script_task_num()) stask_get(num, &fvar);
+          lp++;
+          len = 0;
+          goto exit;
+        }
+        if (!strncmp(vname, "tqc(", 4)) {
+          // number of values queued by task n
+          lp = GetNumericArgument(lp + 4, OPER_EQU, &fvar, 0);
+          fvar = stask_count(fvar>1);
+          lp++;
+          len = 0;
+          goto exit;
+        }
+#endif //USE_SCRIPT_TASK
         break;
       case 'u':
         if (!strncmp(vname, "uptime", 6)) {
@@ -3327,12 +3689,53 @@ char *GetStringArgument(char *lp, uint8_t lastop, char *cp, JsonParserObject *jo
   return lp;
 }
 
+void calc_oper(uint8_t lastop, float *fp, float fvar1) {
+  float fvar = *fp;
+  switch (lastop) {
+      case OPER_EQU:
+          fvar = fvar1;
+          break;
+      case OPER_PLS:
+          fvar += fvar1;
+          break;
+      case OPER_MIN:
+          fvar -= fvar1;
+          break;
+      case OPER_MUL:
+          fvar *= fvar1;
+          break;
+      case OPER_DIV:
+          fvar /= fvar1;
+          break;
+      case OPER_PERC:
+          fvar = fmodf(fvar, fvar1);
+          break;
+      case OPER_XOR:
+          fvar = (uint32_t)fvar ^ (uint32_t)fvar1;
+          break;
+      case OPER_AND:
+          fvar = (uint32_t)fvar & (uint32_t)fvar1;
+          break;
+      case OPER_OR:
+          fvar = (uint32_t)fvar | (uint32_t)fvar1;
+          break;
+      default:
+          break;
+  }
+  *fp = fvar;
+}
+
 char *GetNumericArgument(char *lp, uint8_t lastop, float *fp, JsonParserObject *jo) {
 uint8_t operand = 0;
 float fvar1,fvar;
 char *slp;
 uint8_t vtype;
 struct T_INDEX ind;
+    if (lastop==OPER_EQU && lp>=glob_script_mem.script_ram && lp<glob_script_mem.script_ram + glob_script_mem.script_size) {
+      // compiled expression
+      char *elp = run_code(lp, fp);
+      if (elp) return elp;
+    }
     while (1) {
         // get 1. value
         if (*lp=='(') {
@@ -3347,38 +3750,7 @@ struct T_INDEX ind;
               glob_script_mem.glob_error = 1;
             }
         }
-        switch (lastop) {
-            case OPER_EQU:
-                fvar = fvar1;
-                break;
-            case OPER_PLS:
-                fvar += fvar1;
-                break;
-            case OPER_MIN:
-                fvar -= fvar1;
-                break;
-            case OPER_MUL:
-                fvar *= fvar1;
-                break;
-            case OPER_DIV:
-                fvar /= fvar1;
-                break;
-            case OPER_PERC:
-                fvar = fmodf(fvar, fvar1);
-                break;
-            case OPER_XOR:
-                fvar = (uint32_t)fvar ^ (uint32_t)fvar1;
-                break;
-            case OPER_AND:
-                fvar = (uint32_t)fvar & (uint32_t)fvar1;
-                break;
-            case OPER_OR:
-                fvar = (uint32_t)fvar | (uint32_t)fvar1;
-                break;
-            default:
-                break;
-
-        }
+        calc_oper(lastop, &fvar, fvar1);
         slp = lp;
         lp = getop(lp, &operand);
         switch (operand) {
@@ -3404,6 +3776,197 @@ struct T_INDEX ind;
 }
 
 
+/*********************************************************************************************\
+ * Compiled numeric expressions
+ *
+ * Numeric expressions in the script text are compiled on first use into postfix code with
+ * constants converted and variables resolved to their slot. Code is kept in a hash table
+ * keyed by the offset of the expression in the script and cleared by Init_Scripter. The table
+ * is sized from the number of lines and operators in the script and filled up to 3/4 so a
+ * lookup ends at a free slot. Expressions using functions, system, string, array or json
+ * variables are not compiled. Their slot is kept without code so they are interpreted by
+ * GetNumericArgument without trying to compile them again.
+\*********************************************************************************************/
+
+#ifndef SCRIPT_CODE_SLOTS
+#define SCRIPT_CODE_SLOTS 32    // minimum number of slots
+#endif
+#define SCRIPT_CODE_SIZE 64
+
+enum {SCODE_CONST, SCODE_VAR, SCODE_NVAR, SCODE_OPER};  // SCODE_OPER + OPER_EQU .. OPER_PERCEQU
+
+struct SCRIPT_CODE {
+  uint16_t offset;  // offset of expression in script + 1, 0 = free slot
+  uint16_t len;     // length of expression text
+  uint8_t *code;    // [depth][size][code], 0 = not compilable
+};
+
+struct {
+  uint8_t code[SCRIPT_CODE_SIZE];
+  uint8_t size;
+  uint8_t depth;
+  uint8_t max_depth;
+} script_cc;
+
+void clr_code(void) {
+  if (!glob_script_mem.code) return;
+  for (uint32_t count = 0; count<glob_script_mem.code_slots; count++) {
+    if (glob_script_mem.code[count].code) free(glob_script_mem.code[count].code);
+  }
+  free(glob_script_mem.code);
+  glob_script_mem.code = 0;
+}
+
+// one slot per line, assignment and compare of the script
+uint16_t code_slots(void) {
+  uint32_t num = 0;
+  for (char *lp = glob_script_mem.script_ram; *lp; lp++) {
+    if (*lp==SCRIPT_EOL || *lp=='=' || *lp=='<' || *lp=='>') num++;
+  }
+  if (num<SCRIPT_CODE_SLOTS) num = SCRIPT_CODE_SLOTS;
+  if (num>0xffff) num = 0xffff;
+  return num;
+}
+
+bool emit_code(uint8_t opcode, const void *data, uint8_t len, int8_t stack) {
+  if (script_cc.size + 1 + len > SCRIPT_CODE_SIZE) return false;
+  script_cc.code[script_cc.size++] = opcode;
+  if (len) {
+    memcpy(&script_cc.code[script_cc.size], data, len);
+    script_cc.size += len;
+  }
+  script_cc.depth += stack;
+  if (script_cc.depth>script_cc.max_depth) script_cc.max_depth = script_cc.depth;
+  return true;
+}
+
+// compile operand as parsed by GetNumericArgument, returns 0 if not compilable
+char *compile_operand(char *lp) {
+  if (*lp=='(') {
+    lp = compile_expression(lp + 1);
+    if (!lp || *lp!=')') return 0;
+    return lp + 1;
+  }
+  if (isdigit(*lp) || (*lp=='-' && isdigit(*(lp+1))) || *lp=='.') {
+    uint8_t vtype;
+    struct T_INDEX ind;
+    float fvar;
+    lp = isvar(lp, &vtype, &ind, &fvar, 0, 0);
+    if (!emit_code(SCODE_CONST, &fvar, sizeof(fvar), 1)) return 0;
+    return lp;
+  }
+  uint8_t opcode = SCODE_VAR;
+  if (*lp=='-') {
+    // inverted var
+    opcode = SCODE_NVAR;
+    lp++;
+  }
+  const char *term="\n\r ])=+-/*%><!^&|}{";
+  uint8_t len = 0;
+  while (lp[len] && !strchr(term, lp[len])) {
+    if (lp[len]=='[') return 0;
+    len++;
+    if (len>=32) return 0;
+  }
+  if (!len) return 0;
+  int16_t vindex = find_var(lp, len);
+  if (vindex<0) return 0;
+  struct T_INDEX *vtp = &glob_script_mem.type[vindex];
+  if (vtp->bits.is_string || vtp->bits.is_filter) return 0;
+  if (!emit_code(opcode, &vtp->index, 1, 1)) return 0;
+  return lp + len;
+}
+
+// compile expression as parsed by GetNumericArgument, returns 0 if not compilable
+char *compile_expression(char *lp) {
+  lp = compile_operand(lp);
+  while (lp) {
+    uint8_t operand;
+    char *slp = lp;
+    lp = getop(lp, &operand);
+    switch (operand) {
+      case OPER_EQUEQU:
+      case OPER_NOTEQU:
+      case OPER_LOW:
+      case OPER_LOWEQU:
+      case OPER_GRT:
+      case OPER_GRTEQU:
+        return slp;
+    }
+    if (!operand) return lp;
+    lp = compile_operand(lp);
+    if (lp && !emit_code(SCODE_OPER + operand, 0, 0, -1)) return 0;
+  }
+  return 0;
+}
+
+// evaluate compiled expression at lp, returns end of expression or 0 if not compiled
+char *run_code(char *lp, float *fp) {
+  if (!glob_script_mem.code) {
+    glob_script_mem.code_slots = code_slots();
+    glob_script_mem.code = (struct SCRIPT_CODE*)calloc(glob_script_mem.code_slots, sizeof(struct SCRIPT_CODE));
+    if (!glob_script_mem.code) return 0;
+    glob_script_mem.code_used = 0;
+  }
+  uint16_t offset = lp - glob_script_mem.script_ram + 1;
+  uint32_t slot = (offset * 2654435761) % glob_script_mem.code_slots;
+  struct SCRIPT_CODE *entry = 0;
+  for (uint32_t count = 0; count<glob_script_mem.code_slots; count++) {
+    entry = &glob_script_mem.code[slot];
+    if (entry->offset==offset) break;
+    if (!entry->offset) {
+      // compile on first use, table filled up to 3/4 keeps lookups short
+      if (glob_script_mem.code_used>=glob_script_mem.code_slots - glob_script_mem.code_slots / 4) return 0;
+      glob_script_mem.code_used++;
+      entry->offset = offset;
+      script_cc.size = 0;
+      script_cc.depth = 0;
+      script_cc.max_depth = 0;
+      char *elp = compile_expression(lp);
+      if (elp) {
+        entry->code = (uint8_t*)malloc(script_cc.size + 2);
+        if (entry->code) {
+          entry->code[0] = script_cc.max_depth;
+          entry->code[1] = script_cc.size;
+          memcpy(&entry->code[2], script_cc.code, script_cc.size);
+          entry->len = elp - lp;
+        }
+      }
+      break;
+    }
+    slot++;
+    if (slot>=glob_script_mem.code_slots) slot = 0;
+    entry = 0;
+  }
+  if (!entry || !entry->code) return 0;  // interpret expressions marked not compilable
+
+  float stack[entry->code[0]];
+  uint8_t sp = 0;
+  uint8_t *cp = &entry->code[2];
+  uint8_t *ep = cp + entry->code[1];
+  while (cp<ep) {
+    uint8_t opcode = *cp++;
+    switch (opcode) {
+      case SCODE_CONST:
+        memcpy(&stack[sp++], cp, sizeof(float));
+        cp += sizeof(float);
+        break;
+      case SCODE_VAR:
+        stack[sp++] = glob_script_mem.fvars[*cp++];
+        break;
+      case SCODE_NVAR:
+        stack[sp++] = -glob_script_mem.fvars[*cp++];
+        break;
+      default:
+        sp--;
+        calc_oper(opcode - SCODE_OPER, &stack[sp - 1], stack[sp]);
+        break;
+    }
+  }
+  *fp = stack[0];
+  return lp + entry->len;
+}
+
 char *ForceStringVar(char *lp, char *dstr) {
   float fvar;
   char *slp = lp;
@@ -3703,6 +4266,63 @@ void esp32_beep(int32_t freq ,uint32_t len) {
 }
 #endif // ESP32
 
+// index lines where Run_script_sub looks for a section or label
+void index_sections(void) {
+  if (glob_script_mem.section_index) free(glob_script_mem.section_index);
+  glob_script_mem.section_index = 0;
+  glob_script_mem.section_num = 0;
+  if (!glob_script_mem.scriptptr) return;
+
+  for (uint8_t pass = 0; pass<2; pass++) {
+    uint16_t num = 0;
+    char *lp = glob_script_mem.scriptptr;
+    while (1) {
+      // same line walk as Run_script_sub outside of a section
+      SCRIPT_SKIP_SPACES
+      SCRIPT_SKIP_EOL
+      if (!*lp) break;
+      if (*lp=='>' || *lp=='#') {
+        if (pass) glob_script_mem.section_index[num] = lp - glob_script_mem.scriptptr;
+        num++;
+      }
+      lp = strchr(lp, SCRIPT_EOL);
+      if (!lp) break;
+      lp++;
+    }
+    if (!pass) {
+      if (!num) return;
+      glob_script_mem.section_index = (uint16_t*)malloc(num * sizeof(uint16_t));
+      if (!glob_script_mem.section_index) return;
+    }
+    glob_script_mem.section_num = num;
+  }
+}
+
+// return first indexed line matching section type
+char *find_section(const char *type, int8_t tlen) {
+  for (uint16_t count = 0; count<glob_script_mem.section_num; count++) {
+    char *lp = glob_script_mem.scriptptr_bu + glob_script_mem.section_index[count];
+    if (!strncmp(lp, type, tlen)) return lp;
+  }
+  return 0;
+}
+
+void show_sections(void) {
+  Response_P(PSTR("{\"script\":{\"Sections\":{"));
+  for (uint16_t count = 0; count<glob_script_mem.section_num; count++) {
+    if (ResponseLength() > sizeof(mqtt_data) - 40) break;
+    char *lp = glob_script_mem.scriptptr_bu + glob_script_mem.section_index[count];
+    char label[24];
+    uint8_t len = 0;
+    while (len<sizeof(label) - 1 && *lp && *lp!=SCRIPT_EOL && *lp!='\r' && *lp!='"' && *lp!='\\') {
+      label[len++] = *lp++;
+    }
+    label[len] = 0;
+    ResponseAppend_P(PSTR("%s\"%d\":\"%s\""), (count) ? "," : "", glob_script_mem.section_index[count], label);
+  }
+  ResponseAppend_P(PSTR("}}}"));
+}
+
 //#define IFTHEN_DEBUG
 
 #define IF_NEST 8
@@ -3710,14 +4330,13 @@ void esp32_beep(int32_t freq ,uint32_t len) {
 int16_t Run_Scripter(const char *type, int8_t tlen, char *js) {
 int16_t retval;
 
+    if (!SCRIPT_LOCK_SECTION(type)) return -1;  // task busy, skip periodic section
     if (!glob_script_mem.scriptptr) {
-      return -99;
-    }
-
-    if (tasm_cmd_activ && tlen>0) return 0;
-
-    JsonParserObject jo;
-    if (js) {
+      retval = -99;
+    } else if (tasm_cmd_activ && tlen>0) {
+      retval = 0;
+    } else if (js) {
+      JsonParserObject jo;
       //String jss = js;    // copy the string to a new buffer, not sure we can change the original buffer
       //JsonParser parser((char*)jss.c_str());
       JsonParser parser(js);
@@ -3726,6 +4345,7 @@ int16_t retval;
     } else {
       retval = Run_script_sub(type, tlen, 0);
     }
+    SCRIPT_UNLOCK
     return retval;
 }
 
@@ -3751,6 +4371,11 @@ int16_t Run_script_sub(const char *type, int8_t tlen, JsonParserObject *jo) {
     uint8_t section = 0,sysv_type = 0,swflg = 0;
 
     char *lp = glob_script_mem.scriptptr;
+    if (glob_script_mem.section_index && lp==glob_script_mem.scriptptr_bu && tlen>1 && (*type=='>' || *type=='#')) {
+      // start at first matching section or label
+      lp = find_section(type, tlen);
+      if (!lp) return -1;
+    }
 
     while (1) {
         // check line
@@ -5151,8 +5776,11 @@ void SaveScriptEnd(void) {
 
 
 
+    // tasks must not run while script memory is rebuilt
+    SCRIPT_LOCK_WAIT
     int16_t res = Init_Scripter();
     if (res) {
+      SCRIPT_UNLOCK
       AddLog_P2(LOG_LEVEL_INFO, PSTR("script init error: %d"), res);
       return;
     }
@@ -5161,6 +5789,7 @@ void SaveScriptEnd(void) {
     Run_Scripter(">BS", 3, 0);
 
     fast_script = Run_Scripter(">F", -2, 0);
+    SCRIPT_UNLOCK
   }
 }
 
@@ -5380,9 +6009,13 @@ void Script_HueStatus(String *response, uint16_t hue_devs) {
 
 void Script_Check_Hue(String *response) {
   if (!bitRead(Settings.rule_enabled, 0)) return;
+  if (!SCRIPT_LOCK) return;
 
   uint8_t hue_script_found = Run_Scripter(">H", -2, 0);
-  if (hue_script_found!=99) return;
+  if (hue_script_found!=99) {
+    SCRIPT_UNLOCK
+    return;
+  }
 
   char tmp[256];
   uint8_t hue_devs = 0;
@@ -5500,6 +6133,7 @@ void Script_Check_Hue(String *response) {
     toLog(response->c_str()+LOGSZ);
   }
 #endif
+  SCRIPT_UNLOCK
 }
 
 const char sHUE_LIGHT_RESPONSE_JSON[] PROGMEM =
@@ -5693,11 +6327,13 @@ bool Script_SubCmd(void) {
 #endif //USE_SCRIPT_SUB_COMMAND
 
 void execute_script(char *script) {
+  SCRIPT_LOCK_WAIT
   char *svd_sp = glob_script_mem.scriptptr;
   strcat(script, "\n#");
   glob_script_mem.scriptptr = script;
   Run_Scripter(">", 1, 0);
   glob_script_mem.scriptptr = svd_sp;
+  SCRIPT_UNLOCK
 }
 #define D_CMND_SCRIPT "Script"
 #define D_CMND_SUBSCRIBE "Subscribe"
@@ -5737,7 +6373,7 @@ bool ScriptCommand(void) {
     } else {
       if ('>' == XdrvMailbox.data[0]) {
         // execute script
-        snprintf_P (mqtt_data, sizeof(mqtt_data), PSTR("{\"%s\":\"%s\"}"), command,XdrvMailbox.data);
+        Response_P(PSTR("{\"%s\":\"%s\"}"), command,XdrvMailbox.data);
         if (bitRead(Settings.rule_enabled, 0)) {
           for (uint8_t count = 0; count<XdrvMailbox.data_len; count++) {
             if (XdrvMailbox.data[count]==';') XdrvMailbox.data[count] = '\n';
@@ -5749,22 +6385,29 @@ bool ScriptCommand(void) {
         char *lp = XdrvMailbox.data;
         lp++;
         while (*lp==' ') lp++;
+        if ('>' == *lp) {
+          // show section index
+          show_sections();
+          return serviced;
+        }
         float fvar;
         char str[SCRIPT_MAXSSIZE];
+        SCRIPT_LOCK_WAIT
         glob_script_mem.glob_error = 0;
         GetNumericArgument(lp, OPER_EQU, &fvar, 0);
         if (glob_script_mem.glob_error==1) {
           // was string, not number
           GetStringArgument(lp, OPER_EQU, str, 0);
-          snprintf_P (mqtt_data, sizeof(mqtt_data), PSTR("{\"script\":{\"%s\":\"%s\"}}"), lp, str);
+          Response_P(PSTR("{\"script\":{\"%s\":\"%s\"}}"), lp, str);
         } else {
           dtostrfd(fvar, 6, str);
-          snprintf_P (mqtt_data, sizeof(mqtt_data), PSTR("{\"script\":{\"%s\":%s}}"), lp, str);
+          Response_P(PSTR("{\"script\":{\"%s\":%s}}"), lp, str);
         }
+        SCRIPT_UNLOCK
       }
       return serviced;
     }
-    snprintf_P (mqtt_data, sizeof(mqtt_data), PSTR("{\"%s\":\"%s\",\"Free\":%d}"),command, GetStateText(bitRead(Settings.rule_enabled, 0)), glob_script_mem.script_size - strlen(glob_script_mem.script_ram));
+    Response_P(PSTR("{\"%s\":\"%s\",\"Free\":%d}"),command, GetStateText(bitRead(Settings.rule_enabled, 0)), glob_script_mem.script_size - strlen(glob_script_mem.script_ram));
 #ifdef SUPPORT_MQTT_EVENT
   } else if (CMND_SUBSCRIBE == command_code) {			//MQTT Subscribe command. Subscribe <Event>, <Topic> [, <Key>]
       String result = ScriptSubscribe(XdrvMailbox.data, XdrvMailbox.data_len);
@@ -5825,16 +6468,17 @@ bool ScriptMqttData(void)
   if (XdrvMailbox.data_len < 1 || XdrvMailbox.data_len > MQTT_EVENT_MSIZE) {
     return false;
   }
-  String sTopic = XdrvMailbox.topic;
   String sData = XdrvMailbox.data;
   //AddLog_P2(LOG_LEVEL_DEBUG, PSTR("Script: MQTT Topic %s, Event %s"), XdrvMailbox.topic, XdrvMailbox.data);
   MQTT_Subscription event_item;
-  //Looking for matched topic
-  for (uint32_t index = 0; index < subscriptions.size(); index++) {
-    event_item = subscriptions.get(index);
-
-    //AddLog_P2(LOG_LEVEL_DEBUG, PSTR("Script: Match MQTT message Topic %s with subscription topic %s"), sTopic.c_str(), event_item.Topic.c_str());
-    if (sTopic.startsWith(event_item.Topic)) {
+  //Looking for subscriptions matched by the MQTT topic registry
+  for (uint32_t match = 0; match < MqttTopics.matches; match++) {
+    int32_t id = MqttTopicMatchId(match, MQTT_TOPIC_SCRIPT);
+    if (id < 0) { continue; }
+    int32_t index = 0;
+    while ((index < subscriptions.size()) && (subscriptions[index].Id != id)) { index++; }
+    if (index < subscriptions.size()) {
+      event_item = subscriptions.get(index);
       //This topic is subscribed by us, so serve it
       serviced = true;
       String value;
@@ -5925,6 +6569,7 @@ String ScriptSubscribe(const char *data, int data_len)
           //If find exists one, remove it.
           String stopic = subscriptions.get(index).Topic + "/#";
           MqttUnsubscribe(stopic.c_str());
+          MqttTopicRemove(MQTT_TOPIC_SCRIPT, subscriptions.get(index).Id);
           subscriptions.remove(index);
           break;
         }
@@ -5942,9 +6587,11 @@ String ScriptSubscribe(const char *data, int data_len)
       subscription_item.Event = event_name;
       subscription_item.Topic = topic.substring(0, topic.length() - 2);   //Remove "/#" so easy to match
       subscription_item.Key = key;
+      subscription_item.Id = MqttTopicFreeId(MQTT_TOPIC_SCRIPT);
       subscriptions.add(subscription_item);
 
       MqttSubscribe(topic.c_str());
+      MqttTopicAdd(topic.c_str(), MQTT_TOPIC_SCRIPT, subscription_item.Id);
       events.concat(event_name + "," + topic
         + (key.length()>0 ? "," : "")
         + key);
@@ -5984,6 +6631,7 @@ String ScriptUnsubscribe(const char * data, int data_len)
       if (subscription_item.Event.equalsIgnoreCase(data)) {
         String stopic = subscription_item.Topic + "/#";
         MqttUnsubscribe(stopic.c_str());
+        MqttTopicRemove(MQTT_TOPIC_SCRIPT, subscription_item.Id);
         events = subscription_item.Event;
         subscriptions.remove(index);
         break;
@@ -5996,6 +6644,7 @@ String ScriptUnsubscribe(const char * data, int data_len)
       events.concat(subscriptions.get(0).Event + "; ");
       stopic = subscriptions.get(0).Topic + "/#";
       MqttUnsubscribe(stopic.c_str());
+      MqttTopicRemove(MQTT_TOPIC_SCRIPT, subscriptions.get(0).Id);
       subscriptions.remove(0);
     }
   }
@@ -6454,6 +7103,7 @@ uint32_t cnt;
 
 void ScriptWebShow(char mc) {
   uint8_t web_script,xflg = 0;
+  if (!SCRIPT_LOCK) return;
   if (mc=='w' || mc=='x') {
     if (mc=='x') {
       xflg = 1;
@@ -6948,6 +7598,7 @@ nextwebline:
       }
     }
   }
+  SCRIPT_UNLOCK
 }
 #endif //USE_SCRIPT_WEB_DISPLAY
 
@@ -6955,6 +7606,7 @@ nextwebline:
 #ifdef USE_SENDMAIL
 
 void script_send_email_body(void(*func)(char *)) {
+SCRIPT_LOCK_WAIT
 uint8_t msect = Run_Scripter(">m", -2, 0);
   if (msect==99) {
     char tmp[256];
@@ -6984,11 +7636,13 @@ uint8_t msect = Run_Scripter(">m", -2, 0);
     //client->println("*");
     func((char*)"*");
   }
+  SCRIPT_UNLOCK
 }
 #endif //USE_SENDMAIL
 
 #ifdef USE_SCRIPT_JSON_EXPORT
 void ScriptJsonAppend(void) {
+  if (!SCRIPT_LOCK) return;
   uint8_t web_script = Run_Scripter(">J", -2, 0);
   if (web_script==99) {
     char tmp[256];
@@ -7014,6 +7668,7 @@ void ScriptJsonAppend(void) {
       }
     }
   }
+  SCRIPT_UNLOCK
 }
 #endif //USE_SCRIPT_JSON_EXPORT
 
@@ -7041,6 +7696,14 @@ struct ESP32_Task {
   TaskHandle_t task_t;
 } esp32_tasks[2];
 
+// number of the script task running this code, 0 for main loop
+uint8_t script_task_num(void) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  if (esp32_tasks[0].task_t==task) return 1;
+  if (esp32_tasks[1].task_t==task) return 2;
+  return 0;
+}
+
 
 void script_task1(void *arg) {
   //uint32_t lastms=millis();
@@ -7095,6 +7758,13 @@ uint16_t task_timer2;
 TaskHandle_t task_t1;
 TaskHandle_t task_t2;
 
+uint8_t script_task_num(void) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  if (task_t1==task) return 1;
+  if (task_t2==task) return 2;
+  return 0;
+}
+
 void script_task1(void *arg) {
   while (1) {
     delay(task_timer1);
@@ -7356,15 +8026,20 @@ bool Xdrv10(uint8_t function)
       glob_script_mem.script_pram_size -= 4;
       }
 
+#if defined(ESP32) && defined(USE_SCRIPT_TASK)
+      script_mutex = xSemaphoreCreateRecursiveMutex();
+#endif
       if (bitRead(Settings.rule_enabled, 0)) Init_Scripter();
       break;
     case FUNC_INIT:
       if (bitRead(Settings.rule_enabled, 0)) {
+        SCRIPT_LOCK_WAIT
         Run_Scripter(">B\n", 3, 0);
         fast_script = Run_Scripter(">F", -2, 0);
 #if defined(USE_SCRIPT_HUE) && defined(USE_WEBSERVER) && defined(USE_EMULATION) && defined(USE_EMULATION_HUE) && defined(USE_LIGHT)
         Script_Check_Hue(0);
 #endif //USE_SCRIPT_HUE
+        SCRIPT_UNLOCK
       }
       break;
     case FUNC_EVERY_100_MSECOND:
@@ -7401,15 +8076,18 @@ bool Xdrv10(uint8_t function)
       if (bitRead(Settings.rule_enabled, 0)) {
         ScriptWebShow('$');
 #ifdef SCRIPT_FULL_WEBPAGE
-        uint8_t web_script = Run_Scripter(">w", -2, 0);
-        if (web_script==99) {
-            char bname[48];
-            cpy2lf(bname, sizeof(bname), glob_script_mem.section_ptr + 3);
-            WSContentSend_PD(HTTP_WEB_FULL_DISPLAY, bname);
-            Webserver->on("/sfd", ScriptFullWebpage);
+        if (SCRIPT_LOCK) {
+          uint8_t web_script = Run_Scripter(">w", -2, 0);
+          if (web_script==99) {
+              char bname[48];
+              cpy2lf(bname, sizeof(bname), glob_script_mem.section_ptr + 3);
+              WSContentSend_PD(HTTP_WEB_FULL_DISPLAY, bname);
+              Webserver->on("/sfd", ScriptFullWebpage);
 #ifdef USE_SCRIPT_FATFS
-            Webserver->onNotFound(ScriptGetSDCard);
+              Webserver->onNotFound(ScriptGetSDCard);
 #endif
+          }
+          SCRIPT_UNLOCK
         }
 #endif // SCRIPT_FULL_WEBPAGE
       }
@@ -7430,8 +8108,10 @@ bool Xdrv10(uint8_t function)
 #endif // USE_WEBSERVER
     case FUNC_SAVE_BEFORE_RESTART:
       if (bitRead(Settings.rule_enabled, 0)) {
+        SCRIPT_LOCK_WAIT
         Run_Scripter(">R", 2, 0);
         Scripter_save_pvars();
+        SCRIPT_UNLOCK
       }
 #ifdef USE_SCRIPT_GLOBVARS
       Script_Stop_UDP();
@@ -49,6 +49,7 @@ uint8_t       Settings.knx_CB_param[MAX_KNX_CB]     Type of Output (set relay, t
 \*********************************************************************************************/
 
 #define XDRV_11  11
+#define XDRV_11_TICKS (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_50_MSECOND))
 
 #include <esp-knx-ip.h>         // KNX Library
 
@@ -20,6 +20,7 @@
 #ifdef USE_HOME_ASSISTANT
 
 #define XDRV_12 12
+#define XDRV_12_TICKS FUNC_TICK(FUNC_EVERY_SECOND)
 
 // List of sensors ready for discovery
 const char kHAssJsonSensorTypes[] PROGMEM =
@@ -348,7 +349,7 @@ void TryResponseAppend_P(const char *format, ...)
   char dummy[2];
   int dlen = vsnprintf_P(dummy, 1, format, args);
 
-  int mlen = strlen(mqtt_data);
+  int mlen = ResponseLength();
   int slen = sizeof(mqtt_data) - 1 - mlen;
   if (dlen >= slen)
   {
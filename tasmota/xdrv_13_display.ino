@@ -21,6 +21,7 @@
 #ifdef USE_DISPLAY
 
 #define XDRV_13       13
+#define XDRV_13_TICKS (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #include <renderer.h>
 
@@ -68,6 +68,7 @@
 \*********************************************************************************************/
 
 #define XDRV_14             14
+#define XDRV_14_TICKS       0
 
 #include <TasmotaSerial.h>
 
@@ -21,6 +21,7 @@
 #ifdef USE_TUYA_MCU
 
 #define XDRV_16                16
+#define XDRV_16_TICKS          (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_SECOND))
 #define XNRG_32                32   // Needs to be the last XNRG_xx
 
 #ifndef TUYA_DIMMER_ID
@@ -27,6 +27,7 @@
 \*********************************************************************************************/
 
 #define XDRV_18                18
+#define XDRV_18_TICKS          (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XDRV_22                   22
+#define XDRV_22_TICKS             FUNC_TICK(FUNC_EVERY_250_MSECOND)
 
 const uint8_t MAX_FAN_SPEED = 4;            // Max number of iFan02 fan speeds (0 .. 3)
 
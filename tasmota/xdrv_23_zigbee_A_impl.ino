@@ -20,6 +20,7 @@
 #ifdef USE_ZIGBEE
 
 #define XDRV_23                    23
+#define XDRV_23_TICKS              (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_50_MSECOND))
 
 const char kZbCommands[] PROGMEM = D_PRFX_ZB "|"    // prefix
 #ifdef USE_ZIGBEE_ZNP
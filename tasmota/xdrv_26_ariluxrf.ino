@@ -24,6 +24,7 @@
 \*********************************************************************************************/
 
 #define XDRV_26              26
+#define XDRV_26_TICKS        (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 const uint32_t ARILUX_RF_TIME_AVOID_DUPLICATE = 1000;  // Milliseconds
 
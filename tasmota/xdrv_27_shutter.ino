@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XDRV_27            27
+#define XDRV_27_TICKS      (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 #ifndef SHUTTER_STEPPER
   #define SHUTTER_STEPPER
 #endif
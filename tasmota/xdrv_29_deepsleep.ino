@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XDRV_29                29
+#define XDRV_29_TICKS          FUNC_TICK(FUNC_EVERY_SECOND)
 
 #define D_PRFX_DEEPSLEEP "DeepSleep"
 #define D_CMND_DEEPSLEEP_TIME "Time"
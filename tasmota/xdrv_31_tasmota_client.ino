@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XDRV_31                    31
+#define XDRV_31_TICKS              (FUNC_TICK(FUNC_EVERY_100_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #define CONST_STK_CRC_EOP          0x20
 
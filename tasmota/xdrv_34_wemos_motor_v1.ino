@@ -43,6 +43,7 @@
 \*********************************************************************************************/
 
 #define XDRV_34              34
+#define XDRV_34_TICKS        0
 #define XI2C_44              44          // See I2CDEVICES.md
 
 #ifndef WEMOS_MOTOR_V1_ADDR
@@ -31,6 +31,7 @@
 \*********************************************************************************************/
 
 #define XDRV_35             35
+#define XDRV_35_TICKS       FUNC_TICK(FUNC_EVERY_SECOND)
 
 const char kPWMDimmerCommands[] PROGMEM = "|"  // No prefix
   D_CMND_BRI_PRESET
@@ -673,7 +674,7 @@ void PWMDimmerHandleButton(void)
   // If we need to publish an MQTT trigger, do it.
   if (mqtt_trigger) {
     char topic[TOPSZ];
-    sprintf_P(mqtt_data, PSTR("Trigger%u"), mqtt_trigger);
+    Response_P(PSTR("Trigger%u"), mqtt_trigger);
 #ifdef USE_PWM_DIMMER_REMOTE
     if (!active_device_is_local) {
       snprintf_P(topic, sizeof(topic), PSTR("cmnd/%s/Event"), device_groups[power_button_index].group_name);
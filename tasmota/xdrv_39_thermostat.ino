@@ -20,6 +20,7 @@
 #ifdef USE_THERMOSTAT
 
 #define XDRV_39              39
+#define XDRV_39_TICKS        (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 // Enable/disable debugging
 //#define DEBUG_THERMOSTAT
@@ -46,6 +46,7 @@
 #define EXTERNAL_DAC_PLAY   1
 
 #define XDRV_42           42
+#define XDRV_42_TICKS     0
 
 AudioGeneratorMP3 *mp3 = nullptr;
 AudioFileSourceFS *file;
@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XDRV_44			44
+#define XDRV_44_TICKS FUNC_TICKS_ALL
 
 #define nitems(_a)		(sizeof((_a)) / sizeof((_a)[0]))
 
@@ -36,6 +36,7 @@
 \*********************************************************************************************/
 
 #define XDRV_82           82
+#define XDRV_82_TICKS     0
 
 /*
 // Olimex ESP32-PoE
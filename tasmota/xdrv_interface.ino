@@ -829,6 +829,713 @@ const uint8_t kXdrvList[] = {
 #endif
 };
 
+/*********************************************************************************************\
+ * Xdrv periodic function interest list
+ *
+ * Drivers declare the periodic functions FUNC_LOOP up to FUNC_EVERY_SECOND they handle with
+ * XDRV_xx_TICKS. Drivers without declaration receive all periodic functions.
+\*********************************************************************************************/
+
+#ifdef XFUNC_PTR_IN_ROM
+const uint8_t kXdrvTicks[] PROGMEM = {
+#else
+const uint8_t kXdrvTicks[] = {
+#endif
+
+#ifdef XDRV_01
+#ifndef XDRV_01_TICKS
+#define XDRV_01_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_01_TICKS,
+#endif
+
+#ifdef XDRV_02
+#ifndef XDRV_02_TICKS
+#define XDRV_02_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_02_TICKS,
+#endif
+
+#ifdef XDRV_03
+#ifndef XDRV_03_TICKS
+#define XDRV_03_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_03_TICKS,
+#endif
+
+#ifdef XDRV_04
+#ifndef XDRV_04_TICKS
+#define XDRV_04_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_04_TICKS,
+#endif
+
+#ifdef XDRV_05
+#ifndef XDRV_05_TICKS
+#define XDRV_05_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_05_TICKS,
+#endif
+
+#ifdef XDRV_06
+#ifndef XDRV_06_TICKS
+#define XDRV_06_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_06_TICKS,
+#endif
+
+#ifdef XDRV_07
+#ifndef XDRV_07_TICKS
+#define XDRV_07_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_07_TICKS,
+#endif
+
+#ifdef XDRV_08
+#ifndef XDRV_08_TICKS
+#define XDRV_08_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_08_TICKS,
+#endif
+
+#ifdef XDRV_09
+#ifndef XDRV_09_TICKS
+#define XDRV_09_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_09_TICKS,
+#endif
+
+#ifdef XDRV_10
+#ifndef XDRV_10_TICKS
+#define XDRV_10_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_10_TICKS,
+#endif
+
+#ifdef XDRV_11
+#ifndef XDRV_11_TICKS
+#define XDRV_11_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_11_TICKS,
+#endif
+
+#ifdef XDRV_12
+#ifndef XDRV_12_TICKS
+#define XDRV_12_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_12_TICKS,
+#endif
+
+#ifdef XDRV_13
+#ifndef XDRV_13_TICKS
+#define XDRV_13_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_13_TICKS,
+#endif
+
+#ifdef XDRV_14
+#ifndef XDRV_14_TICKS
+#define XDRV_14_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_14_TICKS,
+#endif
+
+#ifdef XDRV_15
+#ifndef XDRV_15_TICKS
+#define XDRV_15_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_15_TICKS,
+#endif
+
+#ifdef XDRV_16
+#ifndef XDRV_16_TICKS
+#define XDRV_16_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_16_TICKS,
+#endif
+
+#ifdef XDRV_17
+#ifndef XDRV_17_TICKS
+#define XDRV_17_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_17_TICKS,
+#endif
+
+#ifdef XDRV_18
+#ifndef XDRV_18_TICKS
+#define XDRV_18_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_18_TICKS,
+#endif
+
+#ifdef XDRV_19
+#ifndef XDRV_19_TICKS
+#define XDRV_19_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_19_TICKS,
+#endif
+
+#ifdef XDRV_20
+#ifndef XDRV_20_TICKS
+#define XDRV_20_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_20_TICKS,
+#endif
+
+#ifdef XDRV_21
+#ifndef XDRV_21_TICKS
+#define XDRV_21_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_21_TICKS,
+#endif
+
+#ifdef XDRV_22
+#ifndef XDRV_22_TICKS
+#define XDRV_22_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_22_TICKS,
+#endif
+
+#ifdef XDRV_23
+#ifndef XDRV_23_TICKS
+#define XDRV_23_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_23_TICKS,
+#endif
+
+#ifdef XDRV_24
+#ifndef XDRV_24_TICKS
+#define XDRV_24_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_24_TICKS,
+#endif
+
+#ifdef XDRV_25
+#ifndef XDRV_25_TICKS
+#define XDRV_25_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_25_TICKS,
+#endif
+
+#ifdef XDRV_26
+#ifndef XDRV_26_TICKS
+#define XDRV_26_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_26_TICKS,
+#endif
+
+#ifdef XDRV_27
+#ifndef XDRV_27_TICKS
+#define XDRV_27_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_27_TICKS,
+#endif
+
+#ifdef XDRV_28
+#ifndef XDRV_28_TICKS
+#define XDRV_28_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_28_TICKS,
+#endif
+
+#ifdef XDRV_29
+#ifndef XDRV_29_TICKS
+#define XDRV_29_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_29_TICKS,
+#endif
+
+#ifdef XDRV_30
+#ifndef XDRV_30_TICKS
+#define XDRV_30_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_30_TICKS,
+#endif
+
+#ifdef XDRV_31
+#ifndef XDRV_31_TICKS
+#define XDRV_31_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_31_TICKS,
+#endif
+
+#ifdef XDRV_32
+#ifndef XDRV_32_TICKS
+#define XDRV_32_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_32_TICKS,
+#endif
+
+#ifdef XDRV_33
+#ifndef XDRV_33_TICKS
+#define XDRV_33_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_33_TICKS,
+#endif
+
+#ifdef XDRV_34
+#ifndef XDRV_34_TICKS
+#define XDRV_34_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_34_TICKS,
+#endif
+
+#ifdef XDRV_35
+#ifndef XDRV_35_TICKS
+#define XDRV_35_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_35_TICKS,
+#endif
+
+#ifdef XDRV_36
+#ifndef XDRV_36_TICKS
+#define XDRV_36_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_36_TICKS,
+#endif
+
+#ifdef XDRV_37
+#ifndef XDRV_37_TICKS
+#define XDRV_37_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_37_TICKS,
+#endif
+
+#ifdef XDRV_38
+#ifndef XDRV_38_TICKS
+#define XDRV_38_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_38_TICKS,
+#endif
+
+#ifdef XDRV_39
+#ifndef XDRV_39_TICKS
+#define XDRV_39_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_39_TICKS,
+#endif
+
+#ifdef XDRV_40
+#ifndef XDRV_40_TICKS
+#define XDRV_40_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_40_TICKS,
+#endif
+
+#ifdef XDRV_41
+#ifndef XDRV_41_TICKS
+#define XDRV_41_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_41_TICKS,
+#endif
+
+#ifdef XDRV_42
+#ifndef XDRV_42_TICKS
+#define XDRV_42_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_42_TICKS,
+#endif
+
+#ifdef XDRV_43
+#ifndef XDRV_43_TICKS
+#define XDRV_43_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_43_TICKS,
+#endif
+
+#ifdef XDRV_44
+#ifndef XDRV_44_TICKS
+#define XDRV_44_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_44_TICKS,
+#endif
+
+#ifdef XDRV_45
+#ifndef XDRV_45_TICKS
+#define XDRV_45_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_45_TICKS,
+#endif
+
+#ifdef XDRV_46
+#ifndef XDRV_46_TICKS
+#define XDRV_46_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_46_TICKS,
+#endif
+
+#ifdef XDRV_47
+#ifndef XDRV_47_TICKS
+#define XDRV_47_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_47_TICKS,
+#endif
+
+#ifdef XDRV_48
+#ifndef XDRV_48_TICKS
+#define XDRV_48_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_48_TICKS,
+#endif
+
+#ifdef XDRV_49
+#ifndef XDRV_49_TICKS
+#define XDRV_49_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_49_TICKS,
+#endif
+
+#ifdef XDRV_50
+#ifndef XDRV_50_TICKS
+#define XDRV_50_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_50_TICKS,
+#endif
+
+#ifdef XDRV_51
+#ifndef XDRV_51_TICKS
+#define XDRV_51_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_51_TICKS,
+#endif
+
+#ifdef XDRV_52
+#ifndef XDRV_52_TICKS
+#define XDRV_52_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_52_TICKS,
+#endif
+
+#ifdef XDRV_53
+#ifndef XDRV_53_TICKS
+#define XDRV_53_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_53_TICKS,
+#endif
+
+#ifdef XDRV_54
+#ifndef XDRV_54_TICKS
+#define XDRV_54_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_54_TICKS,
+#endif
+
+#ifdef XDRV_55
+#ifndef XDRV_55_TICKS
+#define XDRV_55_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_55_TICKS,
+#endif
+
+#ifdef XDRV_56
+#ifndef XDRV_56_TICKS
+#define XDRV_56_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_56_TICKS,
+#endif
+
+#ifdef XDRV_57
+#ifndef XDRV_57_TICKS
+#define XDRV_57_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_57_TICKS,
+#endif
+
+#ifdef XDRV_58
+#ifndef XDRV_58_TICKS
+#define XDRV_58_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_58_TICKS,
+#endif
+
+#ifdef XDRV_59
+#ifndef XDRV_59_TICKS
+#define XDRV_59_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_59_TICKS,
+#endif
+
+#ifdef XDRV_60
+#ifndef XDRV_60_TICKS
+#define XDRV_60_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_60_TICKS,
+#endif
+
+#ifdef XDRV_61
+#ifndef XDRV_61_TICKS
+#define XDRV_61_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_61_TICKS,
+#endif
+
+#ifdef XDRV_62
+#ifndef XDRV_62_TICKS
+#define XDRV_62_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_62_TICKS,
+#endif
+
+#ifdef XDRV_63
+#ifndef XDRV_63_TICKS
+#define XDRV_63_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_63_TICKS,
+#endif
+
+#ifdef XDRV_64
+#ifndef XDRV_64_TICKS
+#define XDRV_64_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_64_TICKS,
+#endif
+
+#ifdef XDRV_65
+#ifndef XDRV_65_TICKS
+#define XDRV_65_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_65_TICKS,
+#endif
+
+#ifdef XDRV_66
+#ifndef XDRV_66_TICKS
+#define XDRV_66_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_66_TICKS,
+#endif
+
+#ifdef XDRV_67
+#ifndef XDRV_67_TICKS
+#define XDRV_67_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_67_TICKS,
+#endif
+
+#ifdef XDRV_68
+#ifndef XDRV_68_TICKS
+#define XDRV_68_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_68_TICKS,
+#endif
+
+#ifdef XDRV_69
+#ifndef XDRV_69_TICKS
+#define XDRV_69_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_69_TICKS,
+#endif
+
+#ifdef XDRV_70
+#ifndef XDRV_70_TICKS
+#define XDRV_70_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_70_TICKS,
+#endif
+
+#ifdef XDRV_71
+#ifndef XDRV_71_TICKS
+#define XDRV_71_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_71_TICKS,
+#endif
+
+#ifdef XDRV_72
+#ifndef XDRV_72_TICKS
+#define XDRV_72_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_72_TICKS,
+#endif
+
+#ifdef XDRV_73
+#ifndef XDRV_73_TICKS
+#define XDRV_73_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_73_TICKS,
+#endif
+
+#ifdef XDRV_74
+#ifndef XDRV_74_TICKS
+#define XDRV_74_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_74_TICKS,
+#endif
+
+#ifdef XDRV_75
+#ifndef XDRV_75_TICKS
+#define XDRV_75_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_75_TICKS,
+#endif
+
+#ifdef XDRV_76
+#ifndef XDRV_76_TICKS
+#define XDRV_76_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_76_TICKS,
+#endif
+
+#ifdef XDRV_77
+#ifndef XDRV_77_TICKS
+#define XDRV_77_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_77_TICKS,
+#endif
+
+#ifdef XDRV_78
+#ifndef XDRV_78_TICKS
+#define XDRV_78_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_78_TICKS,
+#endif
+
+#ifdef XDRV_79
+#ifndef XDRV_79_TICKS
+#define XDRV_79_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_79_TICKS,
+#endif
+
+#ifdef XDRV_80
+#ifndef XDRV_80_TICKS
+#define XDRV_80_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_80_TICKS,
+#endif
+
+#ifdef XDRV_81
+#ifndef XDRV_81_TICKS
+#define XDRV_81_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_81_TICKS,
+#endif
+
+#ifdef XDRV_82
+#ifndef XDRV_82_TICKS
+#define XDRV_82_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_82_TICKS,
+#endif
+
+#ifdef XDRV_83
+#ifndef XDRV_83_TICKS
+#define XDRV_83_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_83_TICKS,
+#endif
+
+#ifdef XDRV_84
+#ifndef XDRV_84_TICKS
+#define XDRV_84_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_84_TICKS,
+#endif
+
+#ifdef XDRV_85
+#ifndef XDRV_85_TICKS
+#define XDRV_85_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_85_TICKS,
+#endif
+
+#ifdef XDRV_86
+#ifndef XDRV_86_TICKS
+#define XDRV_86_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_86_TICKS,
+#endif
+
+#ifdef XDRV_87
+#ifndef XDRV_87_TICKS
+#define XDRV_87_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_87_TICKS,
+#endif
+
+#ifdef XDRV_88
+#ifndef XDRV_88_TICKS
+#define XDRV_88_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_88_TICKS,
+#endif
+
+#ifdef XDRV_89
+#ifndef XDRV_89_TICKS
+#define XDRV_89_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_89_TICKS,
+#endif
+
+#ifdef XDRV_90
+#ifndef XDRV_90_TICKS
+#define XDRV_90_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_90_TICKS,
+#endif
+
+#ifdef XDRV_91
+#ifndef XDRV_91_TICKS
+#define XDRV_91_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_91_TICKS,
+#endif
+
+#ifdef XDRV_92
+#ifndef XDRV_92_TICKS
+#define XDRV_92_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_92_TICKS,
+#endif
+
+#ifdef XDRV_93
+#ifndef XDRV_93_TICKS
+#define XDRV_93_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_93_TICKS,
+#endif
+
+#ifdef XDRV_94
+#ifndef XDRV_94_TICKS
+#define XDRV_94_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_94_TICKS,
+#endif
+
+#ifdef XDRV_95
+#ifndef XDRV_95_TICKS
+#define XDRV_95_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_95_TICKS,
+#endif
+
+#ifdef XDRV_96
+#ifndef XDRV_96_TICKS
+#define XDRV_96_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_96_TICKS,
+#endif
+
+#ifdef XDRV_97
+#ifndef XDRV_97_TICKS
+#define XDRV_97_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_97_TICKS,
+#endif
+
+#ifdef XDRV_98
+#ifndef XDRV_98_TICKS
+#define XDRV_98_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_98_TICKS,
+#endif
+
+#ifdef XDRV_99
+#ifndef XDRV_99_TICKS
+#define XDRV_99_TICKS          FUNC_TICKS_ALL
+#endif
+  XDRV_99_TICKS
+#endif
+};
+
 /*********************************************************************************************/
 
 void XsnsDriverState(void)
@@ -845,6 +1552,51 @@ void XsnsDriverState(void)
   ResponseAppend_P(PSTR("\""));
 }
 
+uint32_t XdrvDriverId(uint32_t index)
+{
+#ifdef XFUNC_PTR_IN_ROM
+  return pgm_read_byte(kXdrvList + index);
+#else
+  return kXdrvList[index];
+#endif
+}
+
+/*********************************************************************************************\
+ * Build periodic function dispatch lists
+\*********************************************************************************************/
+
+uint16_t xdrv_tick_start[FUNC_TICKS +1];      // Start of each periodic function in xdrv_tick_list
+uint8_t *xdrv_tick_list = nullptr;            // Driver indexes per periodic function
+
+uint8_t* XfuncTicksInit(const uint8_t* ticks, uint32_t present, uint16_t* start)
+{
+  uint32_t count = 0;
+  for (uint32_t x = 0; x < present; x++) {
+    count += __builtin_popcount(pgm_read_byte(ticks + x) & FUNC_TICKS_ALL);
+  }
+  uint8_t *list = (uint8_t*)malloc(count +1);
+  if (!list) { return nullptr; }              // Fall back to calling all drivers
+
+  count = 0;
+  for (uint32_t tick = 0; tick < FUNC_TICKS; tick++) {
+    start[tick] = count;
+    for (uint32_t x = 0; x < present; x++) {
+      if (bitRead(pgm_read_byte(ticks + x), tick)) {
+        list[count++] = x;
+      }
+    }
+  }
+  start[FUNC_TICKS] = count;
+  return list;
+}
+
+void XdrvTicksInit(void)
+{
+  if (!xdrv_tick_list) {
+    xdrv_tick_list = XfuncTicksInit(kXdrvTicks, xdrv_present, xdrv_tick_start);
+  }
+}
+
 /*********************************************************************************************/
 
 bool XdrvRulesProcess(void)
@@ -875,7 +1627,10 @@ bool XdrvCallDriver(uint32_t driver, uint8_t Function)
     uint32_t listed = kXdrvList[x];
 #endif
     if (driver == listed) {
-      return xdrv_func_ptr[x](Function);
+      PROFILE_DRIVER_START(profile_start);
+      bool result = xdrv_func_ptr[x](Function);
+      PROFILE_DRIVER(PRF_XDRV, x, Function, profile_start);
+      return result;
     }
   }
   return false;
@@ -891,8 +1646,17 @@ bool XdrvCall(uint8_t Function)
 
   DEBUG_TRACE_LOG(PSTR("DRV: %d"), Function);
 
-  for (uint32_t x = 0; x < xdrv_present; x++) {
+  uint32_t tick = Function - FUNC_LOOP;
+  bool ticked = ((tick < FUNC_TICKS) && xdrv_tick_list);  // Only call drivers handling this periodic function
+  uint32_t first = (ticked) ? xdrv_tick_start[tick] : 0;
+  uint32_t last = (ticked) ? xdrv_tick_start[tick +1] : xdrv_present;
+
+  for (uint32_t i = first; i < last; i++) {
+    uint32_t x = (ticked) ? xdrv_tick_list[i] : i;
+    PROFILE_DRIVER_START(profile_start);
     result = xdrv_func_ptr[x](Function);
+    PROFILE_DRIVER(PRF_XDRV, x, Function, profile_start);
+    if (FUNC_JSON_APPEND == Function) { MqttPublishChunk(); }  // Hand over part of a streamed payload
 
     if (result && ((FUNC_COMMAND == Function) ||
                    (FUNC_COMMAND_DRIVER == Function) ||
@@ -108,7 +108,10 @@ bool XlgtCall(uint8_t function)
     }
   }
   else if (light_flg) {
-    return xlgt_func_ptr[xlgt_active](function);
+    PROFILE_DRIVER_START(profile_start);
+    bool result = xlgt_func_ptr[xlgt_active](function);
+    PROFILE_DRIVER(PRF_XLGT, xlgt_active, function, profile_start);
+    return result;
   }
   return false;
 }
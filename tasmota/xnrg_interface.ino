@@ -172,7 +172,10 @@ bool XnrgCall(uint8_t function)
     }
   }
   else if (energy_flg) {
-    return xnrg_func_ptr[xnrg_active](function);
+    PROFILE_DRIVER_START(profile_start);
+    bool result = xnrg_func_ptr[xnrg_active](function);
+    PROFILE_DRIVER(PRF_XNRG, xnrg_active, function, profile_start);
+    return result;
   }
   return false;
 }
@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XSNS_01             1
+#define XSNS_01_TICKS       (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #define USE_AC_ZERO_CROSS_DIMMER 1
 
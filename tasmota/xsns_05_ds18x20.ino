@@ -24,6 +24,7 @@
 \*********************************************************************************************/
 
 #define XSNS_05              5
+#define XSNS_05_TICKS        FUNC_TICK(FUNC_EVERY_SECOND)
 
 //#define USE_DS18x20_RECONFIGURE    // When sensor is lost keep retrying or re-configure
 
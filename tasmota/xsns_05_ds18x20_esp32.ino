@@ -24,6 +24,7 @@
 \*********************************************************************************************/
 
 #define XSNS_05              5
+#define XSNS_05_TICKS        FUNC_TICK(FUNC_EVERY_SECOND)
 
 #define DS18S20_CHIPID       0x10  // +/-0.5C 9-bit
 #define DS1822_CHIPID        0x22  // +/-2C 12-bit
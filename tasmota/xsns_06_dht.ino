@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_06          6
+#define XSNS_06_TICKS    FUNC_TICK(FUNC_EVERY_SECOND)
 
 #define DHT_MAX_SENSORS  4
 #define DHT_MAX_RETRY    8
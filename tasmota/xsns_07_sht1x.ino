@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_07             7
+#define XSNS_07_TICKS       FUNC_TICK(FUNC_EVERY_SECOND)
 #define XI2C_08             8  // See I2CDEVICES.md
 
 enum {
@@ -95,6 +95,7 @@
 \*********************************************************************************************/
 
 #define XSNS_11                     11
+#define XSNS_11_TICKS               FUNC_TICK(FUNC_EVERY_SECOND)
 #define XI2C_12                     12              // See I2CDEVICES.md
 
 #define VEML6070_ADDR_H             0x39            // on some PCB boards the address can be changed by a solder point,
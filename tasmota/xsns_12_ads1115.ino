@@ -41,6 +41,7 @@
 \*********************************************************************************************/
 
 #define XSNS_12                         12
+#define XSNS_12_TICKS                   FUNC_TICK(FUNC_EVERY_250_MSECOND)
 #define XI2C_13                         13        // See I2CDEVICES.md
 
 #define ADS1115_ADDRESS_ADDR_GND        0x48      // address pin low (GND)
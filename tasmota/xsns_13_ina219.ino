@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_13                                 13
+#define XSNS_13_TICKS                           FUNC_TICK(FUNC_EVERY_SECOND)
 #define XI2C_14                                 14        // See I2CDEVICES.md
 
 #define INA219_ADDRESS1                         (0x40)    // 1000000 (A0+A1=GND)
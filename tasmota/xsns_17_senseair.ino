@@ -27,6 +27,7 @@
 \*********************************************************************************************/
 
 #define XSNS_17                      17
+#define XSNS_17_TICKS                FUNC_TICK(FUNC_EVERY_250_MSECOND)
 
 #define SENSEAIR_MODBUS_SPEED        9600
 #define SENSEAIR_DEVICE_ADDRESS      0xFE    // Any address
@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_18             18
+#define XSNS_18_TICKS       FUNC_TICK(FUNC_EVERY_SECOND)
 
 #include <TasmotaSerial.h>
 
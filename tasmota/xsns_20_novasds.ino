@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_20             20
+#define XSNS_20_TICKS       FUNC_TICK(FUNC_EVERY_SECOND)
 
 #include <TasmotaSerial.h>
 
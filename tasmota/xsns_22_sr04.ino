@@ -30,6 +30,7 @@
 \*********************************************************************************************/
 
 #define XSNS_22              22
+#define XSNS_22_TICKS        FUNC_TICK(FUNC_EVERY_SECOND)
 
 uint8_t sr04_type = 1;
 real64_t distance;
@@ -50,6 +50,7 @@
 // #endif
 
 #define XSNS_27                   27
+#define XSNS_27_TICKS             FUNC_TICK(FUNC_EVERY_50_MSECOND)
 #define XI2C_21                   21              // See I2CDEVICES.md
 
 
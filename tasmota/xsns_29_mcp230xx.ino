@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_29                   29
+#define XSNS_29_TICKS             (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 #define XI2C_22                   22  // See I2CDEVICES.md
 
 /*
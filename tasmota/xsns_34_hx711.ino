@@ -33,6 +33,7 @@
 \*********************************************************************************************/
 
 #define XSNS_34              34
+#define XSNS_34_TICKS        FUNC_TICK(FUNC_EVERY_100_MSECOND)
 
 #ifndef HX_MAX_WEIGHT
 #define HX_MAX_WEIGHT        20000   // Default max weight in gram
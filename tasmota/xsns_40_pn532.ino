@@ -20,6 +20,7 @@
 #ifdef USE_PN532_HSU
 
 #define XSNS_40                                     40
+#define XSNS_40_TICKS                               (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_100_MSECOND) | FUNC_TICK(FUNC_EVERY_250_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
@@ -21,6 +21,7 @@
 #ifdef USE_SCD30
 
 #define XSNS_42        42
+#define XSNS_42_TICKS  FUNC_TICK(FUNC_EVERY_SECOND)
 #define XI2C_29        29  // See I2CDEVICES.md
 
 //#define SCD30_DEBUG
@@ -47,6 +47,7 @@
 \*********************************************************************************************/
 
 #define XSNS_43             43
+#define XSNS_43_TICKS       (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 enum hre_states {
    hre_idle,    // Initial state,
@@ -47,6 +47,7 @@
 \*********************************************************************************************/
 
 #define XSNS_48                       48
+#define XSNS_48_TICKS                 FUNC_TICK(FUNC_EVERY_100_MSECOND)
 #define XI2C_33                       33  // See I2CDEVICES.md
 
 #define CHIRP_MAX_SENSOR_COUNT        3            // 127 is expectectd to be the max number
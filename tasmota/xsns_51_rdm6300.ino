@@ -21,6 +21,7 @@
 #ifdef USE_RDM6300
 
 #define XSNS_51                          51
+#define XSNS_51_TICKS                    FUNC_TICK(FUNC_EVERY_100_MSECOND)
 
 #define RDM6300_BAUDRATE 9600
 
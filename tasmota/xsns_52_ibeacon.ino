@@ -22,6 +22,7 @@
 
 
 #define XSNS_52                       52
+#define XSNS_52_TICKS                 (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
@@ -24,6 +24,7 @@
 #ifdef USE_SML_M
 
 #define XSNS_53 53
+#define XSNS_53_TICKS (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_100_MSECOND))
 
 // default baudrate of D0 output
 #define SML_BAUDRATE 9600
@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_56             56
+#define XSNS_56_TICKS       FUNC_TICK(FUNC_EVERY_SECOND)
 
 #include <hpma115S0.h>
 #include <TasmotaSerial.h>
@@ -115,6 +115,7 @@ rule3 on tele-FLOG#sec do DisplayText  [f0c1l4]SAV:%value%  endon on tele-FLOG#r
 \*********************************************************************************************/
 
 #define XSNS_60        60
+#define XSNS_60_TICKS  (FUNC_TICK(FUNC_EVERY_50_MSECOND) | FUNC_TICK(FUNC_EVERY_100_MSECOND))
 
 #include "NTPServer.h"
 #include "NTPPacket.h"
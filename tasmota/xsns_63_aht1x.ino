@@ -43,6 +43,7 @@
 \*********************************************************************************************/
 
 #define XSNS_63              63
+#define XSNS_63_TICKS        FUNC_TICK(FUNC_EVERY_100_MSECOND)
 #define XI2C_43              43  // See I2CDEVICES.md
 
 #define AHT1X_ADDR1          0x38
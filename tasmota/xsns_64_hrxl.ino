@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XSNS_64                      64
+#define XSNS_64_TICKS                FUNC_TICK(FUNC_EVERY_SECOND)
 
 #include <TasmotaSerial.h>
 
@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XSNS_67             67
+#define XSNS_67_TICKS       FUNC_TICK(FUNC_EVERY_SECOND)
 #define XI2C_48             48  // See I2CDEVICES.md
 
 #define D_NAME_AS3935 "AS3935"
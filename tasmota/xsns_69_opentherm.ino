@@ -20,6 +20,7 @@
 #ifdef USE_OPENTHERM
 
 #define XSNS_69 69
+#define XSNS_69_TICKS (FUNC_TICK(FUNC_LOOP) | FUNC_TICK(FUNC_EVERY_100_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 
 #include <OpenTherm.h>
 
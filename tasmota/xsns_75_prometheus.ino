@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XSNS_75                    75
+#define XSNS_75_TICKS              0
 
 void HandleMetrics(void)
 {
@@ -32,6 +32,7 @@
 \*********************************************************************************************/
 
 #define XSNS_76 76
+#define XSNS_76_TICKS FUNC_TICK(FUNC_EVERY_SECOND)
 
 #include <TasmotaSerial.h>
 
@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_77     77
+#define XSNS_77_TICKS (FUNC_TICK(FUNC_EVERY_250_MSECOND) | FUNC_TICK(FUNC_EVERY_SECOND))
 #define XI2C_54     54  // See I2CDEVICES.md
 
 #include "VL53L1X.h"
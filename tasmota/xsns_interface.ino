@@ -829,6 +829,713 @@ const uint8_t kXsnsList[] = {
 #endif
 };
 
+/*********************************************************************************************\
+ * Xsns periodic function interest list
+ *
+ * Drivers declare the periodic functions FUNC_LOOP up to FUNC_EVERY_SECOND they handle with
+ * XSNS_xx_TICKS. Drivers without declaration receive all periodic functions.
+\*********************************************************************************************/
+
+#ifdef XFUNC_PTR_IN_ROM
+const uint8_t kXsnsTicks[] PROGMEM = {
+#else
+const uint8_t kXsnsTicks[] = {
+#endif
+
+#ifdef XSNS_01
+#ifndef XSNS_01_TICKS
+#define XSNS_01_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_01_TICKS,
+#endif
+
+#ifdef XSNS_02
+#ifndef XSNS_02_TICKS
+#define XSNS_02_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_02_TICKS,
+#endif
+
+#ifdef XSNS_03
+#ifndef XSNS_03_TICKS
+#define XSNS_03_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_03_TICKS,
+#endif
+
+#ifdef XSNS_04
+#ifndef XSNS_04_TICKS
+#define XSNS_04_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_04_TICKS,
+#endif
+
+#ifdef XSNS_05
+#ifndef XSNS_05_TICKS
+#define XSNS_05_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_05_TICKS,
+#endif
+
+#ifdef XSNS_06
+#ifndef XSNS_06_TICKS
+#define XSNS_06_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_06_TICKS,
+#endif
+
+#ifdef XSNS_07
+#ifndef XSNS_07_TICKS
+#define XSNS_07_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_07_TICKS,
+#endif
+
+#ifdef XSNS_08
+#ifndef XSNS_08_TICKS
+#define XSNS_08_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_08_TICKS,
+#endif
+
+#ifdef XSNS_09
+#ifndef XSNS_09_TICKS
+#define XSNS_09_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_09_TICKS,
+#endif
+
+#ifdef XSNS_10
+#ifndef XSNS_10_TICKS
+#define XSNS_10_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_10_TICKS,
+#endif
+
+#ifdef XSNS_11
+#ifndef XSNS_11_TICKS
+#define XSNS_11_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_11_TICKS,
+#endif
+
+#ifdef XSNS_12
+#ifndef XSNS_12_TICKS
+#define XSNS_12_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_12_TICKS,
+#endif
+
+#ifdef XSNS_13
+#ifndef XSNS_13_TICKS
+#define XSNS_13_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_13_TICKS,
+#endif
+
+#ifdef XSNS_14
+#ifndef XSNS_14_TICKS
+#define XSNS_14_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_14_TICKS,
+#endif
+
+#ifdef XSNS_15
+#ifndef XSNS_15_TICKS
+#define XSNS_15_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_15_TICKS,
+#endif
+
+#ifdef XSNS_16
+#ifndef XSNS_16_TICKS
+#define XSNS_16_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_16_TICKS,
+#endif
+
+#ifdef XSNS_17
+#ifndef XSNS_17_TICKS
+#define XSNS_17_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_17_TICKS,
+#endif
+
+#ifdef XSNS_18
+#ifndef XSNS_18_TICKS
+#define XSNS_18_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_18_TICKS,
+#endif
+
+#ifdef XSNS_19
+#ifndef XSNS_19_TICKS
+#define XSNS_19_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_19_TICKS,
+#endif
+
+#ifdef XSNS_20
+#ifndef XSNS_20_TICKS
+#define XSNS_20_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_20_TICKS,
+#endif
+
+#ifdef XSNS_21
+#ifndef XSNS_21_TICKS
+#define XSNS_21_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_21_TICKS,
+#endif
+
+#ifdef XSNS_22
+#ifndef XSNS_22_TICKS
+#define XSNS_22_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_22_TICKS,
+#endif
+
+#ifdef XSNS_23
+#ifndef XSNS_23_TICKS
+#define XSNS_23_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_23_TICKS,
+#endif
+
+#ifdef XSNS_24
+#ifndef XSNS_24_TICKS
+#define XSNS_24_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_24_TICKS,
+#endif
+
+#ifdef XSNS_25
+#ifndef XSNS_25_TICKS
+#define XSNS_25_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_25_TICKS,
+#endif
+
+#ifdef XSNS_26
+#ifndef XSNS_26_TICKS
+#define XSNS_26_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_26_TICKS,
+#endif
+
+#ifdef XSNS_27
+#ifndef XSNS_27_TICKS
+#define XSNS_27_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_27_TICKS,
+#endif
+
+#ifdef XSNS_28
+#ifndef XSNS_28_TICKS
+#define XSNS_28_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_28_TICKS,
+#endif
+
+#ifdef XSNS_29
+#ifndef XSNS_29_TICKS
+#define XSNS_29_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_29_TICKS,
+#endif
+
+#ifdef XSNS_30
+#ifndef XSNS_30_TICKS
+#define XSNS_30_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_30_TICKS,
+#endif
+
+#ifdef XSNS_31
+#ifndef XSNS_31_TICKS
+#define XSNS_31_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_31_TICKS,
+#endif
+
+#ifdef XSNS_32
+#ifndef XSNS_32_TICKS
+#define XSNS_32_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_32_TICKS,
+#endif
+
+#ifdef XSNS_33
+#ifndef XSNS_33_TICKS
+#define XSNS_33_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_33_TICKS,
+#endif
+
+#ifdef XSNS_34
+#ifndef XSNS_34_TICKS
+#define XSNS_34_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_34_TICKS,
+#endif
+
+#ifdef XSNS_35
+#ifndef XSNS_35_TICKS
+#define XSNS_35_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_35_TICKS,
+#endif
+
+#ifdef XSNS_36
+#ifndef XSNS_36_TICKS
+#define XSNS_36_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_36_TICKS,
+#endif
+
+#ifdef XSNS_37
+#ifndef XSNS_37_TICKS
+#define XSNS_37_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_37_TICKS,
+#endif
+
+#ifdef XSNS_38
+#ifndef XSNS_38_TICKS
+#define XSNS_38_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_38_TICKS,
+#endif
+
+#ifdef XSNS_39
+#ifndef XSNS_39_TICKS
+#define XSNS_39_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_39_TICKS,
+#endif
+
+#ifdef XSNS_40
+#ifndef XSNS_40_TICKS
+#define XSNS_40_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_40_TICKS,
+#endif
+
+#ifdef XSNS_41
+#ifndef XSNS_41_TICKS
+#define XSNS_41_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_41_TICKS,
+#endif
+
+#ifdef XSNS_42
+#ifndef XSNS_42_TICKS
+#define XSNS_42_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_42_TICKS,
+#endif
+
+#ifdef XSNS_43
+#ifndef XSNS_43_TICKS
+#define XSNS_43_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_43_TICKS,
+#endif
+
+#ifdef XSNS_44
+#ifndef XSNS_44_TICKS
+#define XSNS_44_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_44_TICKS,
+#endif
+
+#ifdef XSNS_45
+#ifndef XSNS_45_TICKS
+#define XSNS_45_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_45_TICKS,
+#endif
+
+#ifdef XSNS_46
+#ifndef XSNS_46_TICKS
+#define XSNS_46_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_46_TICKS,
+#endif
+
+#ifdef XSNS_47
+#ifndef XSNS_47_TICKS
+#define XSNS_47_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_47_TICKS,
+#endif
+
+#ifdef XSNS_48
+#ifndef XSNS_48_TICKS
+#define XSNS_48_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_48_TICKS,
+#endif
+
+#ifdef XSNS_49
+#ifndef XSNS_49_TICKS
+#define XSNS_49_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_49_TICKS,
+#endif
+
+#ifdef XSNS_50
+#ifndef XSNS_50_TICKS
+#define XSNS_50_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_50_TICKS,
+#endif
+
+#ifdef XSNS_51
+#ifndef XSNS_51_TICKS
+#define XSNS_51_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_51_TICKS,
+#endif
+
+#ifdef XSNS_52
+#ifndef XSNS_52_TICKS
+#define XSNS_52_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_52_TICKS,
+#endif
+
+#ifdef XSNS_53
+#ifndef XSNS_53_TICKS
+#define XSNS_53_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_53_TICKS,
+#endif
+
+#ifdef XSNS_54
+#ifndef XSNS_54_TICKS
+#define XSNS_54_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_54_TICKS,
+#endif
+
+#ifdef XSNS_55
+#ifndef XSNS_55_TICKS
+#define XSNS_55_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_55_TICKS,
+#endif
+
+#ifdef XSNS_56
+#ifndef XSNS_56_TICKS
+#define XSNS_56_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_56_TICKS,
+#endif
+
+#ifdef XSNS_57
+#ifndef XSNS_57_TICKS
+#define XSNS_57_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_57_TICKS,
+#endif
+
+#ifdef XSNS_58
+#ifndef XSNS_58_TICKS
+#define XSNS_58_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_58_TICKS,
+#endif
+
+#ifdef XSNS_59
+#ifndef XSNS_59_TICKS
+#define XSNS_59_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_59_TICKS,
+#endif
+
+#ifdef XSNS_60
+#ifndef XSNS_60_TICKS
+#define XSNS_60_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_60_TICKS,
+#endif
+
+#ifdef XSNS_61
+#ifndef XSNS_61_TICKS
+#define XSNS_61_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_61_TICKS,
+#endif
+
+#ifdef XSNS_62
+#ifndef XSNS_62_TICKS
+#define XSNS_62_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_62_TICKS,
+#endif
+
+#ifdef XSNS_63
+#ifndef XSNS_63_TICKS
+#define XSNS_63_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_63_TICKS,
+#endif
+
+#ifdef XSNS_64
+#ifndef XSNS_64_TICKS
+#define XSNS_64_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_64_TICKS,
+#endif
+
+#ifdef XSNS_65
+#ifndef XSNS_65_TICKS
+#define XSNS_65_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_65_TICKS,
+#endif
+
+#ifdef XSNS_66
+#ifndef XSNS_66_TICKS
+#define XSNS_66_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_66_TICKS,
+#endif
+
+#ifdef XSNS_67
+#ifndef XSNS_67_TICKS
+#define XSNS_67_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_67_TICKS,
+#endif
+
+#ifdef XSNS_68
+#ifndef XSNS_68_TICKS
+#define XSNS_68_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_68_TICKS,
+#endif
+
+#ifdef XSNS_69
+#ifndef XSNS_69_TICKS
+#define XSNS_69_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_69_TICKS,
+#endif
+
+#ifdef XSNS_70
+#ifndef XSNS_70_TICKS
+#define XSNS_70_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_70_TICKS,
+#endif
+
+#ifdef XSNS_71
+#ifndef XSNS_71_TICKS
+#define XSNS_71_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_71_TICKS,
+#endif
+
+#ifdef XSNS_72
+#ifndef XSNS_72_TICKS
+#define XSNS_72_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_72_TICKS,
+#endif
+
+#ifdef XSNS_73
+#ifndef XSNS_73_TICKS
+#define XSNS_73_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_73_TICKS,
+#endif
+
+#ifdef XSNS_74
+#ifndef XSNS_74_TICKS
+#define XSNS_74_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_74_TICKS,
+#endif
+
+#ifdef XSNS_75
+#ifndef XSNS_75_TICKS
+#define XSNS_75_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_75_TICKS,
+#endif
+
+#ifdef XSNS_76
+#ifndef XSNS_76_TICKS
+#define XSNS_76_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_76_TICKS,
+#endif
+
+#ifdef XSNS_77
+#ifndef XSNS_77_TICKS
+#define XSNS_77_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_77_TICKS,
+#endif
+
+#ifdef XSNS_78
+#ifndef XSNS_78_TICKS
+#define XSNS_78_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_78_TICKS,
+#endif
+
+#ifdef XSNS_79
+#ifndef XSNS_79_TICKS
+#define XSNS_79_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_79_TICKS,
+#endif
+
+#ifdef XSNS_80
+#ifndef XSNS_80_TICKS
+#define XSNS_80_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_80_TICKS,
+#endif
+
+#ifdef XSNS_81
+#ifndef XSNS_81_TICKS
+#define XSNS_81_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_81_TICKS,
+#endif
+
+#ifdef XSNS_82
+#ifndef XSNS_82_TICKS
+#define XSNS_82_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_82_TICKS,
+#endif
+
+#ifdef XSNS_83
+#ifndef XSNS_83_TICKS
+#define XSNS_83_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_83_TICKS,
+#endif
+
+#ifdef XSNS_84
+#ifndef XSNS_84_TICKS
+#define XSNS_84_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_84_TICKS,
+#endif
+
+#ifdef XSNS_85
+#ifndef XSNS_85_TICKS
+#define XSNS_85_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_85_TICKS,
+#endif
+
+#ifdef XSNS_86
+#ifndef XSNS_86_TICKS
+#define XSNS_86_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_86_TICKS,
+#endif
+
+#ifdef XSNS_87
+#ifndef XSNS_87_TICKS
+#define XSNS_87_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_87_TICKS,
+#endif
+
+#ifdef XSNS_88
+#ifndef XSNS_88_TICKS
+#define XSNS_88_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_88_TICKS,
+#endif
+
+#ifdef XSNS_89
+#ifndef XSNS_89_TICKS
+#define XSNS_89_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_89_TICKS,
+#endif
+
+#ifdef XSNS_90
+#ifndef XSNS_90_TICKS
+#define XSNS_90_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_90_TICKS,
+#endif
+
+#ifdef XSNS_91
+#ifndef XSNS_91_TICKS
+#define XSNS_91_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_91_TICKS,
+#endif
+
+#ifdef XSNS_92
+#ifndef XSNS_92_TICKS
+#define XSNS_92_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_92_TICKS,
+#endif
+
+#ifdef XSNS_93
+#ifndef XSNS_93_TICKS
+#define XSNS_93_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_93_TICKS,
+#endif
+
+#ifdef XSNS_94
+#ifndef XSNS_94_TICKS
+#define XSNS_94_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_94_TICKS,
+#endif
+
+#ifdef XSNS_95
+#ifndef XSNS_95_TICKS
+#define XSNS_95_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_95_TICKS,
+#endif
+
+#ifdef XSNS_96
+#ifndef XSNS_96_TICKS
+#define XSNS_96_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_96_TICKS,
+#endif
+
+#ifdef XSNS_97
+#ifndef XSNS_97_TICKS
+#define XSNS_97_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_97_TICKS,
+#endif
+
+#ifdef XSNS_98
+#ifndef XSNS_98_TICKS
+#define XSNS_98_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_98_TICKS,
+#endif
+
+#ifdef XSNS_99
+#ifndef XSNS_99_TICKS
+#define XSNS_99_TICKS          FUNC_TICKS_ALL
+#endif
+  XSNS_99_TICKS
+#endif
+};
+
 /*********************************************************************************************/
 
 bool XsnsEnabled(uint32_t sns_index)
@@ -844,6 +1551,15 @@ bool XsnsEnabled(uint32_t sns_index)
   return true;
 }
 
+uint32_t XsnsDriverId(uint32_t index)
+{
+#ifdef XFUNC_PTR_IN_ROM
+  return pgm_read_byte(kXsnsList + index);
+#else
+  return kXsnsList[index];
+#endif
+}
+
 void XsnsSensorState(void)
 {
   ResponseAppend_P(PSTR("\""));  // Use string for enable/disable signal
@@ -862,6 +1578,16 @@ void XsnsSensorState(void)
   ResponseAppend_P(PSTR("\""));
 }
 
+uint16_t xsns_tick_start[FUNC_TICKS +1];      // Start of each periodic function in xsns_tick_list
+uint8_t *xsns_tick_list = nullptr;            // Sensor indexes per periodic function
+
+void XsnsTicksInit(void)
+{
+  if (!xsns_tick_list) {
+    xsns_tick_list = XfuncTicksInit(kXsnsTicks, xsns_present, xsns_tick_start);
+  }
+}
+
 /*********************************************************************************************\
  * Function call to all xsns
 \*********************************************************************************************/
@@ -888,7 +1614,10 @@ bool XsnsNextCall(uint8_t Function, uint8_t &xsns_index)
   }
 #endif
 
-  return xsns_func_ptr[xsns_index](Function);
+  PROFILE_DRIVER_START(profile_start);
+  bool result = xsns_func_ptr[xsns_index](Function);
+  PROFILE_DRIVER(PRF_XSNS, xsns_index, Function, profile_start);
+  return result;
 }
 
 bool XsnsCall(uint8_t Function)
@@ -901,7 +1630,13 @@ bool XsnsCall(uint8_t Function)
   uint32_t profile_start_millis = millis();
 #endif  // PROFILE_XSNS_EVERY_SECOND
 
-  for (uint32_t x = 0; x < xsns_present; x++) {
+  uint32_t tick = Function - FUNC_LOOP;
+  bool ticked = ((tick < FUNC_TICKS) && xsns_tick_list);  // Only call sensors handling this periodic function
+  uint32_t first = (ticked) ? xsns_tick_start[tick] : 0;
+  uint32_t last = (ticked) ? xsns_tick_start[tick +1] : xsns_present;
+
+  for (uint32_t i = first; i < last; i++) {
+    uint32_t x = (ticked) ? xsns_tick_list[i] : i;
 #ifdef USE_DEBUG_DRIVER
     if (XsnsEnabled(x)) {  // Skip disabled sensor in debug mode
 #endif
@@ -911,7 +1646,10 @@ bool XsnsCall(uint8_t Function)
 #ifdef PROFILE_XSNS_SENSOR_EVERY_SECOND
       uint32_t profile_start_millis = millis();
 #endif  // PROFILE_XSNS_SENSOR_EVERY_SECOND
+      PROFILE_DRIVER_START(profile_start);
       result = xsns_func_ptr[x](Function);
+      PROFILE_DRIVER(PRF_XSNS, x, Function, profile_start);
+      if (FUNC_JSON_APPEND == Function) { MqttPublishChunk(); }  // Hand over part of a streamed payload
 
 #ifdef PROFILE_XSNS_SENSOR_EVERY_SECOND
       uint32_t profile_millis = millis() - profile_start_millis;
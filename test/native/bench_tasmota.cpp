@@ -0,0 +1,132 @@
+/*
+  bench_tasmota.cpp - Benchmarks of JSON parser, Unishox, command lookup and rules
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define MAX_COMMAND_TABLES     32             // Default of support.ino which is outside the converted functions
+
+// support.ino, support_command.ino and xdrv_10_rules.ino converted by ino2cpp.py
+#include "tasmota.cpp"
+#include <chrono>
+
+// Host timings only compare alternatives. They do not predict the time taken on an ESP8266 or ESP32
+
+template <typename T> inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Double the iterations until a run takes 0.2 seconds and report the time per iteration
+template <typename F> void Benchmark(const char *name, F function) {
+  uint64_t iterations = 1;
+  double elapsed;
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) { function(); }
+    elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if ((elapsed >= 2e8) || (iterations >= (1ULL << 32))) { break; }
+    iterations *= 2;
+  }
+  printf("%-32s %12.1f ns %12llu\n", name, elapsed / iterations, (unsigned long long)iterations);
+}
+
+const char kSensorJson[] = "{\"Time\":\"2020-10-17T12:00:00\",\"ENERGY\":{\"TotalStartTime\":\"2020-01-01T00:00:00\","
+  "\"Total\":123.456,\"Yesterday\":1.234,\"Today\":0.567,\"Power\":42,\"ApparentPower\":48,\"ReactivePower\":23,"
+  "\"Factor\":0.88,\"Voltage\":230,\"Current\":0.209},\"SI7021\":{\"Temperature\":21.5,\"Humidity\":48.2,"
+  "\"DewPoint\":10.1},\"TempUnit\":\"C\"}";
+
+const char kRuleText[] = "on system#boot do backlog var1 0; ruletimer1 60 endon on rules#timer=1 do backlog var1 1; power off endon";
+
+void BenchJson(void) {
+  Benchmark("JsonParser/Sensor", []() {
+    char json[sizeof(kSensorJson)];
+    memcpy(json, kSensorJson, sizeof(json));                // Parsing is in place
+    JsonParser parser(json);
+    JsonParserObject root = parser.getRootObject();
+    DoNotOptimize(root["SI7021"].getObject().getFloat("Temperature", 0));
+  });
+}
+
+void BenchUnishox(void) {
+  char compressed[128];
+  int32_t len = compressor.unishox_compress(kRuleText, strlen(kRuleText), compressed, sizeof(compressed));
+  Benchmark("Unishox/Compress", []() {
+    char out[128];
+    DoNotOptimize(compressor.unishox_compress(kRuleText, strlen(kRuleText), out, sizeof(out)));
+  });
+  Benchmark("Unishox/Decompress", [&]() {
+    char out[256];
+    DoNotOptimize(compressor.unishox_decompress(compressed, len, out, sizeof(out)));
+  });
+}
+
+void BenchCommand(void) {
+  char command[CMDSZ];
+  Benchmark("GetCommandCode/First", [&]() {
+    DoNotOptimize(GetCommandCode(command, sizeof(command), D_CMND_BACKLOG, kTasmotaCommands));
+  });
+  Benchmark("GetCommandCode/Last", [&]() {
+    DoNotOptimize(GetCommandCode(command, sizeof(command), D_CMND_DRIVER, kTasmotaCommands));
+  });
+  Benchmark("GetCommandCodeHashed/First", [&]() {
+    DoNotOptimize(GetCommandCodeHashed(command, sizeof(command), D_CMND_BACKLOG, kTasmotaCommands));
+  });
+  Benchmark("GetCommandCodeHashed/Last", [&]() {
+    DoNotOptimize(GetCommandCodeHashed(command, sizeof(command), D_CMND_DRIVER, kTasmotaCommands));
+  });
+  Benchmark("GetTextIndexed", [&]() {
+    DoNotOptimize(GetTextIndexed(command, sizeof(command), 40, kTasmotaCommands));
+  });
+}
+
+void BenchRules(void) {
+  SetRule(0, "on Power1#State=1 do Power2 %value% endon "
+             "on SI7021#Temperature>23.5 do Publish stat/hall {\"Temp\":%value%} endon "
+             "on Dimmer#Level<=30 do Color 100000 endon "
+             "on ENERGY#Power>%var1% do Var2 %value% endon");
+  bitSet(Settings.rule_enabled, 0);
+  strcpy(rules_vars[0], "40");
+  Benchmark("RulesProcessEvent/Sensor", []() {
+    char json[sizeof(kSensorJson)];
+    memcpy(json, kSensorJson, sizeof(json));
+    native_commands.clear();
+    DoNotOptimize(RulesProcessEvent(json));
+  });
+  Benchmark("RulesProcessEvent/NoMatch", []() {
+    char json[] = "{\"Switch1\":{\"Action\":\"ON\"}}";
+    native_commands.clear();
+    DoNotOptimize(RulesProcessEvent(json));
+  });
+
+  strcpy(rules_vars[1], "2");
+  Benchmark("evaluateExpression", []() {
+    const char expression[] = "(var1+2)*3-var2/4";
+    DoNotOptimize(evaluateExpression(expression, sizeof(expression) -1));
+  });
+  Benchmark("evaluateLogicalExpression", []() {
+    const char expression[] = "(var1>41 OR 2>1) AND var1+1==41";
+    DoNotOptimize(evaluateLogicalExpression(expression, sizeof(expression) -1));
+  });
+}
+
+int main(void) {
+  printf("%-32s %15s %12s\n", "Benchmark", "Time", "Iterations");
+  BenchJson();
+  BenchUnishox();
+  BenchCommand();
+  BenchRules();
+  return 0;
+}
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+ino2cpp.py - Convert Tasmota .ino files into a C++ file for native host builds
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+Usage: ino2cpp.py <output.cpp> <header> <file.ino>[:Function,...]...
+
+Like the Arduino build the .ino files are concatenated and prototypes of all top level
+functions are inserted before the first function. <header> is included first and provides
+the feature defines and the stubs for everything outside the converted files. A file
+followed by a list of names contributes only those functions, enums, structs, classes and
+constants.
+"""
+
+import re
+import sys
+
+FUNCTION = re.compile(r'^(?!(?:else|return|typedef|using)\b)([A-Za-z_][\w:<>]*(?:[ \t]+[\w:<>]+)*[ \t*&]+)'
+                      r'([A-Za-z_]\w*)[ \t]*\(([^()]*)\)[ \t]*(?:const[ \t]*)?(\{.*)?$')
+DECLARATION = re.compile(r'^(?:typedef[ \t]+)?(?:(?:enum(?:[ \t]+class)?|struct|class)[ \t]+(\w+)|'
+                         r'(?:static[ \t]+)?const[ \t]+[\w \t]*?[ \t*](\w+)[ \t]*(?:\[[^\]]*\])?[ \t]*(?:PROGMEM[ \t]*)?=)')
+
+
+def declaration(line):
+  """Return name of a top level enum, struct, class or constant declared by line"""
+  match = DECLARATION.match(line)
+  return (match.group(1) or match.group(2)) if match else None
+
+
+def prototype(lines, index):
+  """Return prototype if lines[index] starts a top level function definition"""
+  line = lines[index].rstrip()
+  while ('(' in line) and (line.count('(') > line.count(')')) and (index + 1 < len(lines)):
+    index += 1                                        # Arguments continued on next line
+    line += ' ' + lines[index].strip()
+  match = FUNCTION.match(line)
+  if not match:
+    return None
+  if not match.group(4):
+    # Brace on next non empty line like "void Foo(void)\n{"
+    for next_line in lines[index + 1:]:
+      if next_line.strip():
+        if not next_line.startswith('{'):
+          return None
+        break
+  args = re.sub(r'[ \t]*=[^,]*', '', match.group(3))  # Default arguments stay in the definition
+  return '{}{}({});'.format(match.group(1), match.group(2), args)
+
+
+def main(argv):
+  output, header, sources = argv[1], argv[2], argv[3:]
+  lines = []
+  origin = []
+  selections = {}
+  for source in sources:
+    source, _, functions = source.partition(':')
+    if functions:
+      selections[source] = functions.split(',')
+    with open(source, encoding='utf-8', errors='replace') as ino:
+      for number, line in enumerate(ino.readlines(), 1):
+        lines.append(line if line.endswith('\n') else line + '\n')
+        origin.append((source, number))
+
+  prototypes = []
+  first = None
+  keep = [True] * len(lines)
+  selected = False
+  depth = 0
+  comment = False
+  conditionals = []  # Per open #if whether braces of an #else/#elif branch are being skipped
+  for index, line in enumerate(lines):
+    if origin[index][0] in selections:
+      keep[index] = selected
+    directive = re.match(r'[ \t]*#[ \t]*(\w+)', line)
+    if directive and not comment:
+      # Braces are counted in the first branch of a conditional only
+      if directive.group(1) in ('if', 'ifdef', 'ifndef'):
+        conditionals.append(False)
+      elif directive.group(1) in ('else', 'elif') and conditionals:
+        conditionals[-1] = True
+      elif directive.group(1) == 'endif' and conditionals:
+        conditionals.pop()
+      continue
+    if any(conditionals):
+      continue
+    source = origin[index][0]
+    if depth == 0 and not comment and not line.startswith((' ', '\t', '#', '/', '*', '{', '}')):
+      proto = prototype(lines, index)
+      if source in selections:
+        name = re.search(r'(\w+)\(', proto).group(1) if proto else declaration(line)
+        selected = name in selections[source]
+        keep[index] = selected
+        if not selected:
+          proto = None
+      if proto:
+        prototypes.append(proto)
+        if first is None:
+          first = index
+    code = re.sub(r'"(?:\\.|[^"\\])*"|\'(?:\\.|[^\'\\])*\'', '', line)
+    if comment:
+      if '*/' not in code:
+        continue
+      code = code[code.index('*/') + 2:]
+      comment = False
+    code = re.sub(r'/\*.*?\*/|//.*', '', code)
+    if '/*' in code:
+      code = code[:code.index('/*')]
+      comment = True
+    depth += code.count('{') - code.count('}')
+    if depth == 0 and (code.strip().startswith('}') or code.rstrip().endswith((';', '}'))):
+      selected = False
+
+  with open(output, 'w', encoding='utf-8') as cpp:
+    cpp.write('#include "{}"\n'.format(header))
+    for index, line in enumerate(lines):
+      if index == first:
+        cpp.write('\n'.join(prototypes) + '\n')
+      if not keep[index]:
+        continue
+      if (index == 0) or (index == first) or not keep[index - 1] or (origin[index][0] != origin[index - 1][0]):
+        cpp.write('#line {} "{}"\n'.format(origin[index][1], origin[index][0]))
+      cpp.write(line)
+
+
+if __name__ == '__main__':
+  main(sys.argv)
@@ -0,0 +1,197 @@
+/*
+  Arduino.h - Minimal Arduino core for native host builds
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _NATIVE_ARDUINO_H_
+#define _NATIVE_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+#include <algorithm>
+
+#include "pgmspace.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+
+using std::min;
+using std::max;
+
+inline size_t native_strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = (len < size) ? len : size -1;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
+#define strlcpy native_strlcpy
+
+inline char *dtostrf(double number, signed char width, unsigned char prec, char *s) {
+  sprintf(s, "%*.*f", width, prec, number);
+  return s;
+}
+
+uint32_t millis(void);
+void delay(uint32_t ms);
+inline void yield(void) {}
+
+/*********************************************************************************************\
+ * String on top of std::string with the subset of the Arduino API used by Tasmota
+\*********************************************************************************************/
+
+class String {
+public:
+  String(void) {}
+  String(const char *cstr) { if (cstr) { s = cstr; } }
+  String(const String &str) : s(str.s) {}
+  String(const __FlashStringHelper *str) { if (str) { s = (const char*)str; } }
+  explicit String(char c) : s(1, c) {}
+  explicit String(int value, unsigned char base = 10) { s = Format((long)value, base); }
+  explicit String(unsigned int value, unsigned char base = 10) { s = Format((unsigned long)value, base); }
+  explicit String(long value, unsigned char base = 10) { s = Format(value, base); }
+  explicit String(unsigned long value, unsigned char base = 10) { s = Format(value, base); }
+  explicit String(float value, unsigned char decimals = 2) { s = Format((double)value, decimals); }
+  explicit String(double value, unsigned char decimals = 2) { s = Format(value, decimals); }
+
+  String &operator=(const String &rhs) { s = rhs.s; return *this; }
+  String &operator=(const char *cstr) { s = (cstr) ? cstr : ""; return *this; }
+  String &operator=(const __FlashStringHelper *str) { s = (str) ? (const char*)str : ""; return *this; }
+
+  bool reserve(unsigned int size) { s.reserve(size); return true; }
+  unsigned int length(void) const { return s.length(); }
+  const char *c_str(void) const { return s.c_str(); }
+  char *begin(void) { s.resize(s.capacity()); return &s[0]; }   // Writable up to reserved size
+  bool isEmpty(void) const { return s.empty(); }
+
+  bool concat(const String &str) { s += str.s; return true; }
+  bool concat(const char *cstr) { if (cstr) { s += cstr; } return true; }
+  bool concat(const __FlashStringHelper *str) { return concat((const char*)str); }
+  bool concat(char c) { s += c; return true; }
+  bool concat(int num) { s += String(num).s; return true; }
+  bool concat(unsigned int num) { s += String(num).s; return true; }
+  bool concat(long num) { s += String(num).s; return true; }
+  bool concat(unsigned long num) { s += String(num).s; return true; }
+  bool concat(float num) { s += String(num).s; return true; }
+  bool concat(double num) { s += String(num).s; return true; }
+  template <typename T> String &operator+=(T rhs) { concat(rhs); return *this; }
+
+  friend String operator+(const String &lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+  friend String operator+(const String &lhs, const char *rhs) { String r(lhs); r.concat(rhs); return r; }
+  friend String operator+(const char *lhs, const String &rhs) { String r(lhs); r.concat(rhs); return r; }
+  friend String operator+(const String &lhs, char rhs) { String r(lhs); r.concat(rhs); return r; }
+  friend String operator+(const String &lhs, const __FlashStringHelper *rhs) { String r(lhs); r.concat(rhs); return r; }
+
+  int compareTo(const String &str) const { return strcmp(c_str(), str.c_str()); }
+  bool equals(const String &str) const { return s == str.s; }
+  bool equals(const char *cstr) const { return s == ((cstr) ? cstr : ""); }
+  bool equalsIgnoreCase(const String &str) const { return (s.length() == str.s.length()) && !strcasecmp(c_str(), str.c_str()); }
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *cstr) const { return equals(cstr); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *cstr) const { return !equals(cstr); }
+  bool operator<(const String &rhs) const { return compareTo(rhs) < 0; }
+  bool startsWith(const String &prefix) const { return !s.compare(0, prefix.s.length(), prefix.s); }
+  bool startsWith(const String &prefix, unsigned int offset) const { return (offset <= s.length()) && !s.compare(offset, prefix.s.length(), prefix.s); }
+  bool endsWith(const String &suffix) const { return (s.length() >= suffix.s.length()) && !s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s); }
+
+  char charAt(unsigned int index) const { return (index < s.length()) ? s[index] : 0; }
+  void setCharAt(unsigned int index, char c) { if (index < s.length()) { s[index] = c; } }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index) { static char dummy; if (index < s.length()) { return s[index]; } dummy = 0; return dummy; }
+  void toCharArray(char *buf, unsigned int size, unsigned int index = 0) const { if (size) { strlcpy(buf, (index < s.length()) ? c_str() + index : "", size); } }
+
+  int indexOf(char ch, unsigned int from = 0) const { return Pos(s.find(ch, from)); }
+  int indexOf(const String &str, unsigned int from = 0) const { return Pos(s.find(str.s, from)); }
+  int indexOf(const char *cstr, unsigned int from = 0) const { return Pos(s.find(cstr, from)); }
+  int lastIndexOf(char ch) const { return Pos(s.rfind(ch)); }
+  int lastIndexOf(const String &str) const { return Pos(s.rfind(str.s)); }
+  int lastIndexOf(char ch, unsigned int from) const { return Pos(s.rfind(ch, from)); }
+  int lastIndexOf(const String &str, unsigned int from) const { return Pos(s.rfind(str.s, from)); }
+  String substring(unsigned int from) const { return substring(from, s.length()); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) { std::swap(from, to); }
+    if (from >= s.length()) { return String(); }
+    if (to > s.length()) { to = s.length(); }
+    return String(s.substr(from, to - from).c_str());
+  }
+
+  void replace(char find, char replace) { std::replace(s.begin(), s.end(), find, replace); }
+  void replace(const String &find, const String &replace) {
+    if (find.s.empty()) { return; }
+    size_t pos = 0;
+    while ((pos = s.find(find.s, pos)) != std::string::npos) {
+      s.replace(pos, find.s.length(), replace.s);
+      pos += replace.s.length();
+    }
+  }
+  void remove(unsigned int index) { if (index < s.length()) { s.erase(index); } }
+  void remove(unsigned int index, unsigned int count) { if (index < s.length()) { s.erase(index, count); } }
+  void toLowerCase(void) { for (auto &c : s) { c = tolower((unsigned char)c); } }
+  void toUpperCase(void) { for (auto &c : s) { c = toupper((unsigned char)c); } }
+  void trim(void) {
+    size_t start = 0;
+    while ((start < s.length()) && isspace((unsigned char)s[start])) { start++; }
+    size_t end = s.length();
+    while ((end > start) && isspace((unsigned char)s[end -1])) { end--; }
+    s = s.substr(start, end - start);
+  }
+
+  long toInt(void) const { return atol(c_str()); }
+  float toFloat(void) const { return atof(c_str()); }
+
+private:
+  static int Pos(size_t pos) { return (std::string::npos == pos) ? -1 : (int)pos; }
+  static std::string Format(long value, unsigned char base) {
+    if (value < 0) { return "-" + Format((unsigned long)-value, base); }
+    return Format((unsigned long)value, base);
+  }
+  static std::string Format(unsigned long value, unsigned char base) {
+    char buf[8 * sizeof(long) +1];
+    char *p = &buf[sizeof(buf) -1];
+    *p = 0;
+    do {
+      uint32_t digit = value % base;
+      *--p = (digit < 10) ? '0' + digit : 'A' + digit - 10;
+      value /= base;
+    } while (value);
+    return p;
+  }
+  static std::string Format(double value, unsigned char decimals) {
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+    return buf;
+  }
+  std::string s;
+};
+
+#endif  // _NATIVE_ARDUINO_H_
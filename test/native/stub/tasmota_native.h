@@ -0,0 +1,141 @@
+/*
+  tasmota_native.h - Tasmota environment for .ino files converted by ino2cpp.py
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Included once by the converted file. Globals and functions from the .ino files that are
+// not converted are defined here. Commands and log lines are recorded for the tests.
+
+#ifndef _TASMOTA_NATIVE_H_
+#define _TASMOTA_NATIVE_H_
+
+#include <Arduino.h>
+#include <JsonParser.h>
+#include <JsonGenerator.h>
+#include <unishox.h>
+#include <vector>
+
+#define ESP8266
+#define USE_RULES
+#define USE_EXPRESSION
+#define SUPPORT_IF_STATEMENT
+#define USE_UNISHOX_COMPRESSION
+
+#define VERSION                0x09000002
+#define MQTT_LWT_OFFLINE       "Offline"
+#define AGPIO(x)               (x<<5)
+#define MESSZ                  (1200 -TOPSZ -7)
+
+enum SerialConfig {
+  SERIAL_5N1, SERIAL_6N1, SERIAL_7N1, SERIAL_8N1, SERIAL_5N2, SERIAL_6N2, SERIAL_7N2, SERIAL_8N2,
+  SERIAL_5E1, SERIAL_6E1, SERIAL_7E1, SERIAL_8E1, SERIAL_5E2, SERIAL_6E2, SERIAL_7E2, SERIAL_8E2,
+  SERIAL_5O1, SERIAL_6O1, SERIAL_7O1, SERIAL_8O1, SERIAL_5O2, SERIAL_6O2, SERIAL_7O2, SERIAL_8O2 };
+
+#include "tasmota_compat.h"
+#include "tasmota.h"
+#include "i18n.h"
+#include "tasmota_template.h"
+#include "settings.h"
+
+power_t power = 0;
+uint32_t uptime = 0;
+uint16_t tele_period = 9999;
+uint8_t devices_present = 0;
+RulesBitfield rules_flag;
+char mqtt_topic[TOPSZ];
+char mqtt_data[MESSZ];
+Unishox compressor;
+
+std::vector<String> native_commands;                      // Commands executed by ExecuteCommand and BacklogInsert
+String native_log;                                        // Last log line
+char native_text[SET_MAX][33];                            // SettingsText storage
+
+void ExecuteCommand(const char *cmnd, uint32_t source) {
+  native_commands.push_back(cmnd);
+}
+
+bool BacklogInsert(const char* command) {
+  native_commands.push_back(command);
+  return true;
+}
+
+bool DecodeCommand(const char* haystack, void (* const MyCommand[])(void)) {
+  return false;
+}
+
+void AddLog_P2(uint32_t loglevel, PGM_P formatP, ...) {
+  char log_data[700];
+  va_list arg;
+  va_start(arg, formatP);
+  vsnprintf_P(log_data, sizeof(log_data), formatP, arg);
+  va_end(arg);
+  native_log = log_data;
+}
+
+int Response_P(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf_P(mqtt_data, sizeof(mqtt_data), format, args);
+  va_end(args);
+  return len;
+}
+
+int ResponseAppend_P(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int mlen = strlen(mqtt_data);
+  int len = vsnprintf_P(mqtt_data + mlen, sizeof(mqtt_data) - mlen, format, args);
+  va_end(args);
+  return len + mlen;
+}
+
+int ResponseJsonEnd(void) { return ResponseAppend_P(PSTR("}")); }
+void ResponseCmndNumber(int value) { Response_P(S_JSON_COMMAND_NVALUE, XdrvMailbox.command, value); }
+void ResponseCmndChar(const char* value) { Response_P(S_JSON_COMMAND_SVALUE, XdrvMailbox.command, value); }
+void ResponseCmndDone(void) { ResponseCmndChar(D_JSON_DONE); }
+void ResponseCmndIdxChar(const char* value) { Response_P(S_JSON_COMMAND_INDEX_SVALUE, XdrvMailbox.command, XdrvMailbox.index, value); }
+void ResponseCmndAll(uint32_t text_index, uint32_t count) {}
+void MqttPublishPrefixTopic_P(uint32_t prefix, const char* subtopic, bool retained = false) {}
+
+char* SettingsText(uint32_t index) {
+  return native_text[(index < SET_MAX) ? index : 0];
+}
+
+bool SettingsUpdateText(uint32_t index, const char* replace_me) {
+  if (index >= SET_MAX) { return false; }
+  strlcpy(native_text[index], replace_me, sizeof(native_text[index]));
+  return true;
+}
+
+char* GetStateText(uint32_t state) { return (char*)((state) ? D_ON : D_OFF); }
+int GetStateNumber(char *state_text) { return -1; }
+bool PinUsed(uint32_t gpio, uint32_t index = 0) { return false; }
+bool SwitchState(uint32_t index) { return false; }
+bool XsnsNextCall(uint8_t Function, uint8_t &xsns_index) { return false; }
+bool TimeReached(uint32_t timer) { return ((int32_t)(millis() - timer)) >= 0; }
+uint32_t UtcTime(void) { return 0; }
+uint32_t LocalTime(void) { return 0; }
+uint32_t MinutesUptime(void) { return uptime / 60; }
+uint32_t MinutesPastMidnight(void) { return 0; }
+String GetDateAndTime(uint8_t time_type) { return "1970-01-01T00:00:00"; }
+uint32_t ESP_getChipId(void) { return 0; }
+
+struct {
+  String macAddress(void) { return "00:00:00:00:00:00"; }
+} WiFi;
+
+#endif  // _TASMOTA_NATIVE_H_
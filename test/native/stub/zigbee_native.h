@@ -0,0 +1,37 @@
+/*
+  zigbee_native.h - Tasmota environment for the Zigbee files converted by ino2cpp.py
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Prototypes are inserted before the classes they use, like the forward declarations of
+// xdrv_23_zigbee_1_headers.ino do in the firmware build.
+
+#ifndef _ZIGBEE_NATIVE_H_
+#define _ZIGBEE_NATIVE_H_
+
+#define USE_ZIGBEE
+
+#include "tasmota_native.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+class SBuffer;
+class Z_attribute;
+
+char* ToHex_P(const unsigned char * in, size_t insz, char * out, size_t outsz, char inbetween = '\0');
+
+#endif  // _ZIGBEE_NATIVE_H_
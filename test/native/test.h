@@ -0,0 +1,49 @@
+/*
+  test.h - Minimal check macros for native host tests
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _NATIVE_TEST_H_
+#define _NATIVE_TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+static uint32_t test_checks = 0;
+static uint32_t test_failures = 0;
+
+#define CHECK(cond) do { test_checks++; if (!(cond)) { test_failures++; \
+  printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define CHECK_INT(actual, expected) do { long long a_ = (actual), e_ = (expected); test_checks++; if (a_ != e_) { test_failures++; \
+  printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); } } while (0)
+
+#define CHECK_FLOAT(actual, expected) do { double a_ = (actual), e_ = (expected); test_checks++; if (fabs(a_ - e_) > 1e-4 * (1 + fabs(e_))) { test_failures++; \
+  printf("%s:%d: %s is %g, expected %g\n", __FILE__, __LINE__, #actual, a_, e_); } } while (0)
+
+#define CHECK_STR(actual, expected) do { std::string a_ = (actual), e_ = (expected); test_checks++; if (a_ != e_) { test_failures++; \
+  printf("%s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, a_.c_str(), e_.c_str()); } } while (0)
+
+static int TestResult(void) {
+  printf("%u checks, %u failed\n", test_checks, test_failures);
+  return (test_failures) ? 1 : 0;
+}
+
+#endif  // _NATIVE_TEST_H_
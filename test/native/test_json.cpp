@@ -0,0 +1,141 @@
+/*
+  test_json.cpp - Golden tests for JsonParser and JsonGenerator
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Arduino.h>
+#include <JsonParser.h>
+#include <JsonGenerator.h>
+#include "test.h"
+
+void TestParseTypes(void) {
+  char json[] = "{\"Str\":\"abc\",\"Int\":-3,\"Uint\":4000000000,\"Float\":12.5,\"Bool\":true,\"Null\":null,"
+                "\"Arr\":[1,\"two\",3.5],\"Obj\":{\"Inner\":7}}";
+  JsonParser parser(json);
+  CHECK((bool)parser);
+  JsonParserObject root = parser.getRootObject();
+  CHECK(root.isObject());
+  CHECK_INT(root.size(), 8);
+
+  CHECK(root["Str"].isStr());
+  CHECK_STR(root["Str"].getStr(), "abc");
+  CHECK(root["Int"].isInt());
+  CHECK_INT(root["Int"].getInt(), -3);
+  CHECK(root["Uint"].isUint());
+  CHECK_INT(root["Uint"].getUInt(), 4000000000UL);
+  CHECK(root["Float"].isFloat());
+  CHECK_FLOAT(root["Float"].getFloat(), 12.5);
+  CHECK(root["Bool"].isBool());
+  CHECK(root["Bool"].getBool());
+  CHECK(root["Null"].isNull());
+
+  JsonParserArray arr = root["Arr"].getArray();
+  CHECK(arr.isArray());
+  CHECK_INT(arr.size(), 3);
+  CHECK_INT(arr[0].getInt(), 1);
+  CHECK_STR(arr[1].getStr(), "two");
+  CHECK_FLOAT(arr[2].getFloat(), 3.5);
+  CHECK(!arr[3].isValid());
+
+  JsonParserObject obj = root["Obj"].getObject();
+  CHECK_INT(obj.getInt("Inner", 0), 7);
+  CHECK_INT(obj.getInt("Missing", 42), 42);
+}
+
+void TestLookup(void) {
+  char json[] = "{\"ZbReceived\":{\"Prez\":{\"Device\":\"0x9C33\",\"Illuminance\":42,\"Occupancy\":1}}}";
+  JsonParser parser(json);
+  JsonParserObject root = parser.getRootObject();
+
+  // Keys are case insensitive, '?' matches any key
+  JsonParserObject dev = root["zbreceived"].getObject()["?"].getObject();
+  CHECK(dev.isValid());
+  CHECK_STR(dev["DEVICE"].getStr(), "0x9C33");
+  CHECK_INT(dev["illuminance"].getInt(), 42);
+  CHECK_INT(dev.findStartsWith("Occ").getInt(), 1);
+  CHECK(!dev["Occupanc"].isValid());
+  CHECK(nullptr == dev.findConstCharNull("Missing"));
+
+  // Keys are iterated in document order
+  String keys;
+  for (auto key : dev) {
+    keys += key.getStr();
+    keys += ",";
+  }
+  CHECK_STR(keys.c_str(), "Device,Illuminance,Occupancy,");
+}
+
+void TestConversions(void) {
+  char json[] = "{\"A\":\"12\",\"B\":\"0x1F\",\"C\":\"1\",\"D\":-0.25,\"E\":\"text\",\"F\":1.5,\"G\":\"true\"}";
+  JsonParser parser(json);
+  JsonParserObject root = parser.getRootObject();
+  CHECK_INT(root["A"].getInt(), 12);
+  CHECK_INT(root["B"].getUInt(), 31);
+  CHECK(root["C"].getBool());
+  CHECK(!root["G"].getBool());                // Only JSON true and numbers convert to bool
+  CHECK_FLOAT(root["D"].getFloat(), -0.25);
+  CHECK_INT(root["E"].getInt(-1), 0);
+  CHECK_INT(root["F"].getInt(), 1);
+  CHECK_STR(root["D"].getStr(), "-0.25");
+  CHECK_STR(root["Missing"].getStr("dflt"), "dflt");
+}
+
+void TestInvalid(void) {
+  char truncated[] = "{\"A\":1,\"B\":";
+  JsonParser parser1(truncated);
+  CHECK(!(bool)parser1);
+
+  char unclosed[] = "{\"A\":1,\"B\":2";
+  JsonParser parser2(unclosed);
+  CHECK(!(bool)parser2);
+  CHECK(!parser2.getRootObject().isValid());
+
+  char array[] = "[1,2]";
+  JsonParser parser3(array);
+  CHECK((bool)parser3);
+  CHECK(!parser3.getRootObject().isValid());
+
+  char empty[] = "";
+  JsonParser parser4(empty);
+  CHECK(!(bool)parser4);
+}
+
+void TestGenerator(void) {
+  JsonGeneratorObject obj;
+  obj.add("Name", "Tas\"mota");
+  obj.add("Value", (int32_t)-12);
+  obj.add("Hex", (uint32_t)10);
+  obj.addStrRaw("Raw", "[1,2]");
+  CHECK_STR(obj.toString().c_str(), "{\"Name\":\"Tas\\\"mota\",\"Value\":-12,\"Hex\":10,\"Raw\":[1,2]}");
+
+  JsonGeneratorArray arr;
+  arr.add((uint32_t)1);
+  arr.addStr("two");
+  arr.addStrRaw("{}");
+  CHECK_STR(arr.toString().c_str(), "[1,\"two\",{}]");
+
+  CHECK_STR(EscapeJSONString("a\\b\n\x01").c_str(), "a\\\\b\\n\x01");  // Control characters other than \b\f\n\r\t are kept
+}
+
+int main(void) {
+  TestParseTypes();
+  TestLookup();
+  TestConversions();
+  TestInvalid();
+  TestGenerator();
+  return TestResult();
+}
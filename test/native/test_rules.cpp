@@ -0,0 +1,250 @@
+/*
+  test_rules.cpp - Golden tests for the rule trigger matcher and expression evaluator
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// xdrv_10_rules.ino converted by ino2cpp.py. Included to reach its file scope state
+#include "rules.cpp"
+#include "test.h"
+
+// Process event and return the executed commands separated by '|'
+String Event(const char *event) {
+  char json_event[256];
+  strlcpy(json_event, event, sizeof(json_event));
+  native_commands.clear();
+  RulesProcessEvent(json_event);
+  String commands;
+  for (const auto &command : native_commands) {
+    if (commands.length()) { commands += "|"; }
+    commands += command;
+  }
+  return commands;
+}
+
+void UseRule(uint32_t idx, const char *rule) {
+  SetRule(idx, rule);
+  bitSet(Settings.rule_enabled, idx);
+  bitClear(Settings.rule_once, idx);
+}
+
+void TestTriggerMatch(void) {
+  UseRule(0, "on Power1#State=1 do Power2 %value% endon "
+             "on Tele-SI7021#Temperature>23.5 do Publish stat/hall {\"Temp\":%value%} endon "
+             "on Dimmer#Level<=30 do Color 100000 endon "
+             "on Counter#C1|10 do Event Tenth endon "
+             "on Zb#?#Power[2]!=0 do Backlog Power1 1;Power2 0 endon");
+
+  CHECK_STR(Event("{\"Power1\":{\"State\":1}}").c_str(), "Power2 1");
+  CHECK_STR(Event("{\"POWER1\":{\"STATE\":0}}").c_str(), "");                // Keys match in any case
+  CHECK_STR(Event("{\"SI7021\":{\"Temperature\":24.1}}").c_str(), "");      // Tele triggers only match at teleperiod
+  Rules.teleperiod = true;
+  CHECK_STR(Event("{\"SI7021\":{\"Temperature\":24.1}}").c_str(), "Publish stat/hall {\"Temp\":24.1}");
+  CHECK_STR(Event("{\"SI7021\":{\"Temperature\":23.5}}").c_str(), "");
+  Rules.teleperiod = false;
+  CHECK_STR(Event("{\"Dimmer\":{\"Level\":30}}").c_str(), "Color 100000");
+  CHECK_STR(Event("{\"Dimmer\":{\"Level\":31}}").c_str(), "");
+  CHECK_STR(Event("{\"Counter\":{\"C1\":20}}").c_str(), "backlog Event Tenth");  // Event gets an implicit backlog
+  CHECK_STR(Event("{\"Counter\":{\"C1\":21}}").c_str(), "");
+  CHECK_STR(Event("{\"Zb\":{\"0x1234\":{\"Power\":[1,0]}}}").c_str(), "");
+  CHECK_STR(Event("{\"Zb\":{\"0x1234\":{\"Power\":[0,1]}}}").c_str(), "Backlog Power1 1;Power2 0");
+  CHECK_STR(Event("{\"Power1\":").c_str(), "");                          // Truncated events match nothing
+  CHECK_STR(Event("Power1 on").c_str(), "");
+  CHECK_STR(native_log.c_str(), "RUL: No valid JSON (Power1 on)");
+
+  // Single values are expanded to {"SerialReceived":{"Data":"on"}}
+  UseRule(0, "on SerialReceived#Data=on do Power1 on endon");
+  CHECK_STR(Event("{\"SerialReceived\":\"on\"}").c_str(), "Power1 on");
+  bitClear(Settings.rule_enabled, 0);
+  CHECK_STR(Event("{\"SerialReceived\":\"on\"}").c_str(), "");
+}
+
+void TestBreakAndOnce(void) {
+  UseRule(0, "on System#Boot do Power1 1 break on System#Boot do Power2 1 endon");
+  UseRule(1, "on System#Boot do Power3 1 endon");
+  CHECK_STR(Event("{\"System\":{\"Boot\":1}}").c_str(), "Power1 1|Power3 1");  // Break stops rule set 1 only
+
+  UseRule(1, "on Dimmer#Level>50 do Power3 1 endon");
+  bitSet(Settings.rule_once, 1);
+  CHECK_STR(Event("{\"Dimmer\":{\"Level\":60}}").c_str(), "Power3 1");
+  CHECK_STR(Event("{\"Dimmer\":{\"Level\":70}}").c_str(), "");       // Once fires on state changes only
+  CHECK_STR(Event("{\"System\":{\"Boot\":1}}").c_str(), "Power1 1");
+  CHECK_STR(Event("{\"Dimmer\":{\"Level\":40}}").c_str(), "");
+  CHECK_STR(Event("{\"Dimmer\":{\"Level\":60}}").c_str(), "Power3 1");
+  SetRule(1, "");
+  bitClear(Settings.rule_enabled, 1);
+}
+
+void TestVariables(void) {
+  strcpy(rules_vars[0], "41");
+  SettingsUpdateText(SET_MEM1 +1, "on");
+  UseRule(0, "on Tele-Var#A>%var1% do Var2 %value%;Power1 %mem2% endon "
+             "on Var#B=%mem2% do Publish t %var1%%value% 100% %var99% %zzz% %% endon");
+
+  Rules.teleperiod = true;
+  CHECK_STR(Event("{\"Var\":{\"A\":41}}").c_str(), "");
+  CHECK_STR(Event("{\"Var\":{\"A\":41.5}}").c_str(), "Var2 41.5;Power1 on");
+  Rules.teleperiod = false;
+  CHECK_STR(Event("{\"Var\":{\"B\":\"ON\"}}").c_str(), "Publish t 41ON 100% %var99% %zzz% %%");
+
+  strcpy(rules_vars[0], "50");
+  Rules.teleperiod = true;
+  CHECK_STR(Event("{\"Var\":{\"A\":41.5}}").c_str(), "");                    // Variable operand resolved on every match
+  Rules.teleperiod = false;
+  bitClear(Settings.rule_enabled, 0);
+}
+
+void TestTriggerLimit(void) {
+  // Rule sets with more than 32 triggers are stored compressed and compiled up to 32 triggers
+  String rule;
+  for (uint32_t i = 0; i < 34; i++) {
+    rule += "on e#t do p";
+    rule += String(i);
+    rule += " endon ";
+  }
+  CHECK(SetRule(0, rule.c_str()) > 0);
+  CHECK(!IsRuleUncompressed(0));
+  CHECK_STR(GetRule(0).c_str(), rule.c_str());
+  bitSet(Settings.rule_enabled, 0);
+  bitClear(Settings.rule_once, 0);
+
+  String expected;
+  for (uint32_t i = 0; i < 32; i++) {
+    if (i) { expected += "|"; }
+    expected += "p";
+    expected += String(i);
+  }
+  native_log = "";
+  CHECK_STR(Event("{\"E\":{\"T\":1}}").c_str(), expected.c_str());
+  CHECK_STR(native_log.c_str(), "RUL: E#T performs \"p31\"");
+  CHECK_INT(RulesCompiled[0].count, 32);
+
+  SetRule(0, rule.c_str());
+  native_log = "";
+  RulesCompile(0);
+  CHECK_STR(native_log.c_str(), "RUL: Rule1 has more than 32 triggers, ignoring the rest");
+  SetRule(0, "");
+  bitClear(Settings.rule_enabled, 0);
+}
+
+float Expression(const char *expression) {
+  return evaluateExpression(expression, strlen(expression));
+}
+
+bool Logical(const char *expression) {
+  return evaluateLogicalExpression(expression, strlen(expression));
+}
+
+void TestExpression(void) {
+  CHECK_FLOAT(Expression("1+2*3"), 7);
+  CHECK_FLOAT(Expression("(1+2)*3"), 9);
+  CHECK_FLOAT(Expression("10/4"), 2.5);
+  CHECK_FLOAT(Expression("10%4"), 2);
+  CHECK_FLOAT(Expression("2^10"), FastPrecisePow(2, 10));     // Power is the fast approximation of support_float.ino
+  CHECK_FLOAT(Expression("2*3^2"), 2 * FastPrecisePow(3, 2));
+  CHECK_FLOAT(Expression("10-2-3"), 5);
+  CHECK_FLOAT(Expression("((2+3)*(4-1))/5"), 3);
+  CHECK_FLOAT(Expression("-4+1"), -3);
+  CHECK_FLOAT(Expression("1/0"), 0);
+
+  strcpy(rules_vars[0], "41");
+  SettingsUpdateText(SET_MEM1, "2.5");
+  CHECK_FLOAT(Expression("var1+1"), 42);
+  CHECK_FLOAT(Expression("VAR1*MEM1"), 102.5);
+  CHECK_FLOAT(Expression("(var1-mem1)/2"), 19.25);
+}
+
+void TestExpressionCache(void) {
+  // Expressions are cached after the second compile and then read variables on every run
+  const char *expression = "var2*3+var3";
+  strcpy(rules_vars[1], "2");
+  strcpy(rules_vars[2], "1");
+  auto cached = [&]() {
+    for (const auto &entry : RulesExpr.cache) {
+      if (entry.code && (entry.text_len == strlen(expression)) && !memcmp(entry.code, expression, entry.text_len)) { return true; }
+    }
+    return false;
+  };
+  CHECK_FLOAT(Expression(expression), 7);
+  CHECK(!cached());
+  CHECK_FLOAT(Expression(expression), 7);
+  CHECK(cached());
+  strcpy(rules_vars[1], "10");
+  CHECK_FLOAT(Expression(expression), 31);
+  strcpy(rules_vars[2], "-0.5");
+  CHECK_FLOAT(Expression(expression), 29.5);
+
+  // A logical expression with the same text is cached apart
+  CHECK(Logical(expression));
+  CHECK(Logical(expression));
+  CHECK_FLOAT(Expression(expression), 29.5);
+
+  // Entries are replaced when more expressions are used twice than fit the cache
+  char text[RULES_EXPR_CACHE +2][8];
+  for (uint32_t i = 0; i < RULES_EXPR_CACHE +2; i++) {
+    snprintf(text[i], sizeof(text[i]), "%u+1", i);
+    CHECK_FLOAT(Expression(text[i]), i +1);
+    CHECK_FLOAT(Expression(text[i]), i +1);
+  }
+  CHECK(!cached());
+  CHECK_FLOAT(Expression(expression), 29.5);
+}
+
+void TestLogical(void) {
+  strcpy(rules_vars[0], "41");
+  CHECK(Logical("1==1"));
+  CHECK(!Logical("1!=1"));
+  CHECK(Logical("var1>40"));
+  CHECK(Logical("var1>=41 AND var1<=41"));
+  CHECK(!Logical("var1>41 AND 1==1"));
+  CHECK(Logical("var1>41 OR 2>1"));
+  CHECK(Logical("(var1>41 OR 2>1) AND var1+1==42"));
+}
+
+void TestIfStatement(void) {
+  strcpy(rules_vars[0], "41");
+  native_commands.clear();
+  ProcessIfStatement("(var1>40) Power1 on;Power2 off else Power1 off endif");
+  CHECK_INT(native_commands.size(), 2);
+  CHECK_STR(native_commands[0].c_str(), "Power2 off");         // Block commands are inserted in front of the backlog
+  CHECK_STR(native_commands[1].c_str(), "Power1 on");
+
+  native_commands.clear();
+  ProcessIfStatement("(var1>41) Power1 on elseif (var1==41) Power1 toggle else Power1 off endif");
+  CHECK_INT(native_commands.size(), 1);
+  CHECK_STR(native_commands[0].c_str(), "Power1 toggle");
+
+  native_commands.clear();
+  ProcessIfStatement("(var1<0) Power1 on endif");
+  CHECK_INT(native_commands.size(), 0);
+
+  // Semicolons inside IF blocks are escaped to keep the block in a single backlog command
+  UseRule(0, "on System#Boot do Power3 on;If (var1>40) Power1 on;Power2 off endif endon");
+  CHECK_STR(Event("{\"System\":{\"Boot\":1}}").c_str(), "Power3 on;If (var1>40) Power1 on\x1ePower2 off endif");
+  bitClear(Settings.rule_enabled, 0);
+}
+
+int main(void) {
+  TestTriggerMatch();
+  TestBreakAndOnce();
+  TestVariables();
+  TestTriggerLimit();
+  TestExpression();
+  TestExpressionCache();
+  TestLogical();
+  TestIfStatement();
+  return TestResult();
+}
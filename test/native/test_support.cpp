@@ -0,0 +1,91 @@
+/*
+  test_support.cpp - Golden tests for the command and text list lookup of support.ino
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define MAX_COMMAND_TABLES     4              // Small index to test a full index
+
+// support.ino functions and kTasmotaCommands converted by ino2cpp.py
+#include "support.cpp"
+#include "test.h"
+
+const char kTestList[] PROGMEM = "Zero|One||Three|Four";
+
+void TestGetTextIndexed(void) {
+  char text[8];
+  CHECK_STR(GetTextIndexed(text, sizeof(text), 0, kTestList), "Zero");
+  CHECK_STR(GetTextIndexed(text, sizeof(text), 1, kTestList), "One");
+  CHECK_STR(GetTextIndexed(text, sizeof(text), 2, kTestList), "");
+  CHECK_STR(GetTextIndexed(text, sizeof(text), 4, kTestList), "Four");
+  CHECK_STR(GetTextIndexed(text, sizeof(text), 5, kTestList), "");      // Past the end
+  CHECK_STR(GetTextIndexed(text, 4, 3, kTestList), "Thr");              // Truncated to destination size
+  CHECK_STR(GetTextIndexed(text, sizeof(text), 0, ""), "");
+}
+
+void TestGetCommandCode(void) {
+  char command[CMDSZ];
+  CHECK_INT(GetCommandCode(command, sizeof(command), "Zero", kTestList), 0);
+  CHECK_INT(GetCommandCode(command, sizeof(command), "FOUR", kTestList), 4);  // Any case
+  CHECK_STR(command, "Four");
+  CHECK_INT(GetCommandCode(command, sizeof(command), "", kTestList), 2);      // Empty entry
+  CHECK_INT(GetCommandCode(command, sizeof(command), "Five", kTestList), -1);
+  CHECK_INT(GetCommandCode(command, sizeof(command), "Fou", kTestList), -1);  // No prefix match
+
+  CHECK_INT(GetCommandCode(command, sizeof(command), "", kTasmotaCommands), 0);  // No prefix
+  CHECK_INT(GetCommandCode(command, sizeof(command), "backlog", kTasmotaCommands), 1);
+  CHECK_STR(command, D_CMND_BACKLOG);
+  CHECK_INT(GetCommandCode(command, sizeof(command), "SETOPTION", kTasmotaCommands), 18);
+  CHECK_STR(command, D_CMND_SETOPTION);
+  CHECK_INT(GetCommandCode(command, sizeof(command), "Power1", kTasmotaCommands), -1);  // Index is not part of the name
+}
+
+void TestGetCommandCodeHashed(void) {
+  char command[CMDSZ];
+  char expected[CMDSZ];
+
+  // Every command of the table is found at the same index as by the linear lookup
+  uint32_t count = 0;
+  for (uint32_t i = 1; GetTextIndexed(expected, sizeof(expected), i, kTasmotaCommands)[0]; i++) {
+    String upper(expected);
+    upper.toUpperCase();
+    CHECK_INT(GetCommandCodeHashed(command, sizeof(command), upper.c_str(), kTasmotaCommands), i);
+    CHECK_STR(command, expected);
+    count++;
+  }
+  CHECK_INT(count, 77);                                // Without optional features
+  CHECK_STR(expected, "");
+  CHECK_STR(GetTextIndexed(expected, sizeof(expected), count, kTasmotaCommands), D_CMND_DRIVER);
+  CHECK_INT(CommandIndexGet(kTasmotaCommands)[0], count +1);
+  CHECK_INT(GetCommandCodeHashed(command, sizeof(command), "Power1", kTasmotaCommands), -1);
+  CHECK_STR(command, "");
+  CHECK_INT(GetCommandCodeHashed(command, sizeof(command), "Pwr", kTasmotaCommands), -1);
+
+  // Tables beyond MAX_COMMAND_TABLES fall back to the linear lookup
+  static const char kTables[MAX_COMMAND_TABLES +1][8] = { "A|B", "C|D", "E|F", "G|H", "I|J" };
+  for (uint32_t i = 0; i <= MAX_COMMAND_TABLES; i++) {
+    CHECK_INT(GetCommandCodeHashed(command, sizeof(command), &kTables[i][2], kTables[i]), 1);
+    CHECK_STR(command, &kTables[i][2]);
+  }
+  CHECK(nullptr == CommandIndexGet(kTables[MAX_COMMAND_TABLES]));
+}
+
+int main(void) {
+  TestGetTextIndexed();
+  TestGetCommandCode();
+  TestGetCommandCodeHashed();
+  return TestResult();
+}
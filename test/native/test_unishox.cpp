@@ -0,0 +1,86 @@
+/*
+  test_unishox.cpp - Golden tests for Unishox rule compression
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Arduino.h>
+#include <unishox.h>
+#include "test.h"
+
+// Compressed forms as produced by lib/Unishox-1.0-shadinger/python/unishox.py used by decode-config
+struct UnishoxGolden {
+  const char *text;
+  uint8_t size;
+  uint8_t data[72];
+};
+
+const UnishoxGolden kUnishoxGolden[] = {
+  { "ON Switch1#State DO Power1 %value% ENDON", 35,
+    { 0x2C, 0x2E, 0x45, 0xE1, 0xFD, 0xA0, 0xC5, 0x1C, 0x87, 0x91, 0x17, 0xAA, 0xE9, 0xA2, 0x10, 0xB1,
+      0x10, 0xCC, 0x1F, 0x7F, 0x39, 0x0E, 0xE1, 0xF4, 0x46, 0x76, 0x10, 0xB6, 0x7D, 0x22, 0x65, 0xC4,
+      0x21, 0x61, 0x71 } },
+  { "on system#boot do backlog var1 0; ruletimer1 60 endon on rules#timer=1 do backlog var1 1; power off endon", 68,
+    { 0xCE, 0x5E, 0x32, 0xF5, 0x31, 0xA7, 0x90, 0xEC, 0xCA, 0x42, 0x62, 0x1D, 0x61, 0x9A, 0x05, 0x83,
+      0xC8, 0xCE, 0xFE, 0x72, 0x1D, 0xC6, 0x78, 0x3B, 0x85, 0xF1, 0x61, 0x3A, 0xD1, 0xAF, 0xE7, 0x21,
+      0xDC, 0xE6, 0x77, 0x09, 0xF0, 0x99, 0xCB, 0x39, 0x7C, 0x58, 0x4F, 0xC7, 0x95, 0x68, 0xD7, 0xF3,
+      0xE1, 0xC8, 0x40, 0x99, 0x8A, 0x1C, 0x87, 0x83, 0xB8, 0x43, 0x30, 0x7D, 0xFD, 0x61, 0x83, 0x2A,
+      0x01, 0x83, 0x88, 0x1B } },
+  { "ON tele-SI7021#Temperature>23.5 DO Publish stat/hall/alarm {\"Temp\":%value%} ENDON", 68,
+    { 0x2C, 0x2E, 0x54, 0xC2, 0x67, 0x59, 0x78, 0xB4, 0xE7, 0x9D, 0x43, 0xC8, 0x8A, 0x98, 0xD1, 0x8F,
+      0xF7, 0x42, 0xFE, 0xCF, 0xC3, 0x95, 0x67, 0x4D, 0x3B, 0x84, 0x42, 0x16, 0x22, 0x18, 0x2C, 0x70,
+      0x5B, 0xE1, 0x4B, 0xD5, 0x74, 0x76, 0x0A, 0xB0, 0x82, 0x3B, 0x2C, 0x2B, 0xF8, 0xD4, 0x7B, 0x4F,
+      0x61, 0x53, 0x1A, 0x30, 0xF6, 0x1E, 0x67, 0xD1, 0x9D, 0x84, 0x2D, 0x9F, 0x47, 0xB9, 0x13, 0x2E,
+      0x21, 0x0B, 0x0B, 0x8D } },
+  { "Hello World 12345 HELLO world aaaaaaaaaaaaaaaa", 27,
+    { 0x21, 0x4C, 0x20, 0xB1, 0x10, 0xFE, 0x7C, 0x21, 0x11, 0xC9, 0x57, 0x9A, 0x77, 0x08, 0x85, 0x13,
+      0x20, 0x88, 0x22, 0xC4, 0x3F, 0x9F, 0x08, 0x45, 0x66, 0xF4, 0xB3 } },
+};
+
+void TestGolden(void) {
+  Unishox compressor;
+  for (const auto &golden : kUnishoxGolden) {
+    char compressed[128];
+    int32_t len = compressor.unishox_compress(golden.text, strlen(golden.text), compressed, sizeof(compressed));
+    CHECK_INT(len, golden.size);
+    CHECK(!memcmp(compressed, golden.data, golden.size));
+
+    char text[256];
+    len = compressor.unishox_decompress((const char*)golden.data, golden.size, text, sizeof(text));
+    CHECK_INT(len, strlen(golden.text));
+    text[(len >= 0) ? len : 0] = 0;
+    CHECK_STR(text, golden.text);
+  }
+}
+
+void TestOverflow(void) {
+  Unishox compressor;
+  const char *text = kUnishoxGolden[1].text;
+  char compressed[16];
+  CHECK(compressor.unishox_compress(text, strlen(text), compressed, sizeof(compressed)) < 0);
+
+  // Decompression stops when the output buffer is full
+  char decompressed[17];
+  int32_t len = compressor.unishox_decompress((const char*)kUnishoxGolden[1].data, kUnishoxGolden[1].size, decompressed, 16);
+  CHECK_INT(len, 16);
+  CHECK(!strncmp(decompressed, text, 16));
+}
+
+int main(void) {
+  TestGolden();
+  TestOverflow();
+  return TestResult();
+}
@@ -0,0 +1,202 @@
+/*
+  test_zigbee.cpp - Golden tests for SBuffer, Zigbee attribute lists and ZCL data type converters
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// support_static_buffer.ino, xdrv_23_zigbee_1z_libs.ino and converters converted by ino2cpp.py
+#include "zigbee.cpp"
+#include "test.h"
+
+// Buffer content as upper case hex
+String Hex(const SBuffer &buf) {
+  char hex[2 * buf.len() +1];
+  ToHex_P(buf.getBuffer(), buf.len(), hex, sizeof(hex));
+  return hex;
+}
+
+void TestSBuffer(void) {
+  SBuffer buf(8);
+  CHECK_INT(buf.size(), 8);
+  buf.add8(0x12);
+  buf.add16(0x3456);
+  buf.add32BigEndian(0x789ABCDE);
+  CHECK_STR(Hex(buf).c_str(), "125634789ABCDE");
+  CHECK_INT(buf.add16(0xFFFF), 7);                    // No room for two bytes
+  CHECK_INT(buf.add8(0xF0), 8);
+  CHECK_INT(buf.add8(0xF1), 8);                       // Full
+  CHECK_INT(buf.get8(0), 0x12);
+  CHECK_INT(buf.get16(1), 0x3456);
+  CHECK_INT(buf.get16BigEndian(1), 0x5634);
+  CHECK_INT(buf.get32IBigEndian(3), 0x789ABCDE);
+  CHECK_INT(buf.get32(4), 0xF0DEBC9A);
+  CHECK_INT(buf.get8(8), 0);                          // Past the data
+  CHECK_INT(buf.get32(5), 0);
+
+  buf.setLen(2);
+  buf.set8(1, 'a');
+  buf.set8(2, 'b');                                   // Past the data
+  CHECK_STR(Hex(buf).c_str(), "1261");
+  buf.setLen(4);                                      // Grows zero filled
+  CHECK_STR(Hex(buf).c_str(), "12610000");
+  CHECK_INT(buf.strlen(1), 1);
+  CHECK_INT(buf.strlen_s(1), 1);
+  buf.setLen(2);
+  CHECK_INT(buf.strlen(1), 1);                        // No terminator within the data
+  CHECK_INT(buf.strlen_s(1), 0);
+  buf.setLen(100);
+  CHECK_INT(buf.len(), 8);
+
+  SBuffer hex = SBuffer::SBufferFromHex("0A1b2Cf", 7);  // Odd digit ignored
+  CHECK_STR(Hex(hex).c_str(), "0A1B2C");
+  SBuffer sub = hex.subBuffer(1, 10);                 // Clipped to the data
+  CHECK_STR(Hex(sub).c_str(), "1B2C");
+
+  SBuffer empty(4);
+  CHECK(equalsSBuffer(nullptr, &empty));
+  CHECK(equalsSBuffer(&empty, nullptr));
+  CHECK(!equalsSBuffer(&hex, nullptr));
+  CHECK(!equalsSBuffer(&hex, &sub));
+  SBuffer copy(4);
+  copy.addBuffer(hex);
+  CHECK(equalsSBuffer(&hex, &copy));
+  CHECK_INT(copy.addBuffer(hex), 3);                  // Does not fit
+  CHECK_INT(copy.addBuffer("\x01", 1), 4);
+
+  uint8_t memory[12];
+  PreAllocatedSBuffer pre(sizeof(memory), memory);
+  CHECK_INT(pre.size(), 8);
+  pre.add64(0x0102030405060708);
+  CHECK_STR(Hex(pre).c_str(), "0807060504030201");
+  CHECK(pre.get64(0) == 0x0102030405060708);
+}
+
+void TestDataTypes(void) {
+  CHECK_INT(Z_getDatatypeLen(Zbool), 1);
+  CHECK_INT(Z_getDatatypeLen(Zuint16), 2);
+  CHECK_INT(Z_getDatatypeLen(Zint24), 3);
+  CHECK_INT(Z_getDatatypeLen(Zdata64), 8);
+  CHECK_INT(Z_getDatatypeLen(Zsingle), 4);
+  CHECK_INT(Z_getDatatypeLen(Zkey128), 16);
+  CHECK_INT(Z_getDatatypeLen(Ztuya4), 5);             // Length byte and value
+  CHECK_INT(Z_getDatatypeLen(Zstring), 0);            // Variable length
+  CHECK(!Z_isDiscreteDataType(Zuint8));
+  CHECK(!Z_isDiscreteDataType(Zsingle));
+  CHECK(!Z_isDiscreteDataType(ZUTC));
+  CHECK(Z_isDiscreteDataType(Zenum8));
+  CHECK(Z_isDiscreteDataType(Zmap16));
+
+  CHECK_INT(CxToCluster(Cx0300), 0x0300);
+  CHECK_INT(CxToCluster(0xFE), 0xFFFF);
+  CHECK_INT(ClusterToCx(0x0B04), Cx0B04);
+  CHECK_INT(ClusterToCx(0x1234), 0xFF);
+  CHECK_INT(CmToMultiplier(Cm100), 100);
+  CHECK_INT(CmToMultiplier(Cm_10), -10);
+  CHECK_INT(CmToMultiplier(Z_EXPORT_DATA | Cm10), 10);  // High nibble holds flags
+  CHECK_INT(CmToMultiplier(0x0F), 1);
+
+  CHECK_INT(toPercentageCR2032(2000), 0);
+  CHECK_INT(toPercentageCR2032(2440), 6);
+  CHECK_INT(toPercentageCR2032(2800), 27);
+  CHECK_INT(toPercentageCR2032(2950), 71);
+  CHECK_INT(toPercentageCR2032(3100), 100);
+}
+
+String Encode(double value, const char *str, uint8_t type, int32_t expected_len) {
+  SBuffer buf(40);
+  CHECK_INT(encodeSingleAttribute(buf, value, str, type), expected_len);
+  return Hex(buf);
+}
+
+void TestEncodeAttribute(void) {
+  CHECK_STR(Encode(1, nullptr, Zbool, 1).c_str(), "01");
+  CHECK_STR(Encode(300, nullptr, Zuint16, 2).c_str(), "2C01");
+  CHECK_STR(Encode(-2, nullptr, Zint8, 1).c_str(), "FE");
+  CHECK_STR(Encode(-300, nullptr, Zint32, 4).c_str(), "D4FEFFFF");
+  CHECK_STR(Encode(1.5, nullptr, Zsingle, 4).c_str(), "0000C03F");
+  CHECK_STR(Encode(-1, nullptr, Ztuya4, 5).c_str(), "04FFFFFFFF");
+  CHECK_STR(Encode(0, "abc", Zstring, 4).c_str(), "03616263");
+  CHECK_STR(Encode(0, "ab", Zstring16, 4).c_str(), "02006162");
+  CHECK_STR(Encode(0, nullptr, Zstring, -2).c_str(), "");
+  CHECK_STR(Encode(0, nullptr, Zdouble, -1).c_str(), "");  // Not supported
+
+  String longer(std::string(40, 'x').c_str());
+  CHECK_INT(Encode(0, longer.c_str(), Zstring, 33).length(), 66);  // Truncated to 32 characters
+}
+
+// Attribute parsed from hex as JSON
+String Parse(const char *hex, int32_t type, uint32_t expected_len) {
+  SBuffer buf = SBuffer::SBufferFromHex(hex, strlen(hex));
+  Z_attribute_list list;
+  Z_attribute &attr = list.addAttribute(0x0402, 0x0000);
+  CHECK_INT(parseSingleAttribute(attr, buf, 0, type), expected_len);
+  return list.toString();
+}
+
+void TestParseAttribute(void) {
+  CHECK_STR(Parse("2C01", Zuint16, 2).c_str(), "\"0402/0000\":300");
+  CHECK_STR(Parse("212C01", -1, 3).c_str(), "\"0402/0000\":300");    // Type read from the buffer
+  CHECK_STR(Parse("FFFF", Zuint16, 2).c_str(), "\"0402/0000\":null"); // Invalid value
+  CHECK_STR(Parse("D4FEFFFF", Zint32, 4).c_str(), "\"0402/0000\":-300");
+  CHECK_STR(Parse("01", Zbool, 1).c_str(), "\"0402/0000\":1");
+  CHECK_STR(Parse("0000C03F", Zsingle, 4).c_str(), "\"0402/0000\":1.5");
+  CHECK_STR(Parse("0000000000000C40", Zdouble, 8).c_str(), "\"0402/0000\":3.5");
+  CHECK_STR(Parse("03612262", Zstring, 4).c_str(), "\"0402/0000\":\"a\\\"b\"");
+  CHECK_STR(Parse("05616263", Zstring, 4).c_str(), "\"0402/0000\":\"abc\"");  // Length clipped to the buffer
+  CHECK_STR(Parse("020001FF", Zoctstr16, 4).c_str(), "\"0402/0000\":\"01FF\"");
+}
+
+void TestAttributeList(void) {
+  Z_attribute_list list;
+  list.addAttribute(0x0006, 0x0000).setBool(true);
+  list.addAttribute(PSTR("Temperature"), true).setFloat(21.25);
+  list.addAttribute(PSTR("Temperature"), true).setFloat(-3);
+  list.addAttribute(PSTR("Name"), true).setStr("Living \"room\"");
+  list.addAttribute(PSTR("Raw"), true).setStrRaw("{\"A\":1}");
+  Z_attribute_list &sub = list.addAttribute(PSTR("Sub"), true).newAttrList();
+  sub.addAttribute(0x0006, 0x0000).setUInt(1);
+  sub.addAttribute(0x0006, 0x0000).setInt(-1);
+  Z_json_array &arr = list.addAttribute(PSTR("Array"), true).newJsonArray();
+  arr.add(1);
+  arr.addStrRaw("\"x\"");
+  list.src_ep = 1;
+  list.lqi = 80;
+  CHECK_STR(list.toString(true).c_str(),
+    "{\"0006/0000\":true,\"Temperature\":21.25,\"Temperature2\":-3,\"Name\":\"Living \\\"room\\\"\","
+    "\"Raw\":{\"A\":1},\"Sub\":{\"0006/0000\":1,\"0006/0000+2\":-1},\"Array\":[1,\"x\"],"
+    "\"" D_CMND_ZIGBEE_ENDPOINT "\":1,\"" D_CMND_ZIGBEE_LINKQUALITY "\":80}");
+
+  CHECK_INT(list.countAttribute(PSTR("Temperature")), 2);
+  CHECK(list.findAttribute(PSTR("Temperature"), 2)->getFloat() == -3);
+  CHECK(nullptr == list.findAttribute(0x0006, 0x0001));
+
+  Z_attribute_list other;
+  other.addAttribute(PSTR("Name"), true).setStr("Kitchen");
+  other.addAttribute(PSTR("Battery"), true).setUInt(90);
+  other.lqi = 80;
+  CHECK(list.mergeList(other));
+  CHECK_STR(list.findAttribute(PSTR("Name"))->getStr(), "Kitchen");
+  CHECK_INT(list.findAttribute(PSTR("Battery"))->getUInt(), 90);
+}
+
+int main(void) {
+  TestSBuffer();
+  TestDataTypes();
+  TestEncodeAttribute();
+  TestParseAttribute();
+  TestAttributeList();
+  return TestResult();
+}